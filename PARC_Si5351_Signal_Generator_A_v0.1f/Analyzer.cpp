@@ -0,0 +1,241 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to use the Si5351 as a scalar network analyzer.
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+*/
+
+#include "Arduino.h"
+
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
+#include "VE3OOI_Si5351_v2.1.h"
+#include "Timer.h"
+#include "Sweep.h"
+#include "Display.h"
+#include "OLED.h"
+#include "Analyzer.h"
+
+#ifdef ENABLE_ANALYZER
+
+// Each AnalyzerPoll() measures the point the clock is tuned to and then tunes the next.  The payload of the
+// next point is computed while the detector settles.  The last conversion of a point is started before the
+// retune and read after it so the I2C transaction and the conversion run at the same time.  Serial output is
+// buffered by the UART interrupt and is sent while the next point is measured.  Timer2 is claimed but not
+// used so nothing else changes the Si5351 during the sweep and the LCD is not updated.
+unsigned char analyzeractive;
+char analyzerformat;
+unsigned char analyzersamples;
+unsigned char analyzerbase;                 // First multisynth register of the clock being swept
+unsigned char analyzerlast[SI_MSREGS];      // Payload of the point the clock is tuned to
+unsigned char analyzernext[SI_MSREGS];      // Payload of the next point
+unsigned int analyzersettle;
+unsigned int analyzerpoints, analyzerpoint;
+signed char analyzerdir;                    // Direction of the pass. A triangle sweep comes back down
+unsigned long analyzerfreq, analyzernextfreq;
+unsigned long analyzertuned;                // micros() at the end of the last retune
+unsigned long analyzercount, analyzerstart, analyzerstop;
+
+#ifdef ENABLE_OLED
+// Each point is drawn as a bar in the OLED plot area when it is measured.  The framebuffer is sent by
+// LCDFlush() once the I2C bus is free so a single sweep is shown when it ends
+#endif // ENABLE_OLED
+
+#ifndef ARDUINO
+// Simulated AD8307 at 25mV/dB on a tuned circuit. 0dB at the centre gives 2V
+#define ANALYZER_SIM_CENTER 10000000.0
+#define ANALYZER_SIM_Q      50.0
+static unsigned long analyzersimfreq;            // Frequency when the simulated conversion was started
+#endif // ARDUINO
+
+
+static void AnalyzerConvert (void)
+// Start a conversion
+{
+#ifdef ARDUINO
+  ADCSRA |= (1 << ADSC);
+#else
+  analyzersimfreq = analyzerfreq;
+#endif // ARDUINO
+}
+
+static unsigned int AnalyzerResult (void)
+// Wait for the conversion to end and return it
+{
+#ifdef ARDUINO
+  while (ADCSRA & (1 << ADSC));
+  return ADC;
+#else
+  float x, v;
+
+  x = 2.0 * ANALYZER_SIM_Q * ((float)analyzersimfreq - ANALYZER_SIM_CENTER) / ANALYZER_SIM_CENTER;
+  v = 2.0 - 0.25 * log10 (1.0 + x * x);
+  if (v < 0.25) v = 0.25;                   // Detector floor
+  return (unsigned int)(v * 1023.0 / 5.0) + (rand () & 1);
+#endif // ARDUINO
+}
+
+static unsigned int AnalyzerNext (void)
+// Point after the one the clock is tuned to. A triangle sweep turns around at both ends
+{
+  if (analyzerdir > 0) {
+    if (analyzerpoint + 1 < analyzerpoints) return analyzerpoint + 1;
+    return (sweepcfg.mode == SWEEP_TRIANGLE) ? analyzerpoint - 1 : 0;
+  }
+  return analyzerpoint ? analyzerpoint - 1 : 1;
+}
+
+static void AnalyzerPrepare (void)
+// Compute the payload of the point after the one the clock is tuned to
+{
+  analyzernextfreq = SweepFrequency (AnalyzerNext ());
+  Si5351MSPayload (SI_MAX_PLL_FREQ, analyzernextfreq, analyzernext);
+}
+
+static void AnalyzerRetune (void)
+// Send the registers of the next point that differ from the current one
+{
+  unsigned char i, first = SI_MSREGS, last = 0;
+
+  for (i=0; i<SI_MSREGS; i++) {
+    if (analyzernext[i] != analyzerlast[i]) {
+      if (first == SI_MSREGS) first = i;
+      last = i;
+    }
+    analyzerlast[i] = analyzernext[i];
+  }
+  if (first != SI_MSREGS) Si5351RepeatedWriteRegister (analyzerbase + first, last - first + 1, &analyzernext[first]);
+  analyzerfreq = analyzernextfreq;
+  analyzertuned = micros();
+}
+
+static void AnalyzerSend (unsigned int point, unsigned long freq, unsigned int value, unsigned char last)
+{
+  if (analyzerformat == ANALYZER_BINARY) {
+    if (last) value |= ANALYZER_LAST;
+    Serial.write ((uint8_t)ANALYZER_SYNC);
+    Serial.write ((uint8_t)point);
+    Serial.write ((uint8_t)(point >> 8));
+    Serial.write ((uint8_t)value);
+    Serial.write ((uint8_t)(value >> 8));
+  } else {
+    Serial.print (freq);
+    Serial.print (',');
+    Serial.println (value);
+  }
+}
+
+unsigned char AnalyzerStart (unsigned char clk, unsigned int settle, unsigned char samples, char format)
+// Sweep clk over the configured sweep.  A single sweep stops after the last point, a continuous sweep starts
+// over and a triangle sweep goes back and forth between the ends.
+// Returns 0 if an argument is not valid or Timer2 is in use
+{
+  if (clk >= MAXCLK || !samples || samples > ANALYZER_MAX_SAMPLES) return 0;
+  if (format != ANALYZER_CSV && format != ANALYZER_BINARY) return 0;
+  if (!ClaimTimer2 (TIMER2_ANALYZER) || analyzeractive) return 0;
+
+#ifdef ARDUINO
+  ADMUX = (1 << REFS0) | ANALYZER_CHANNEL;        // AVcc reference
+  ADCSRA = (1 << ADEN) | ANALYZER_ADC_PRESCALE;
+  DIDR0 |= 1 << ANALYZER_CHANNEL;
+#endif // ARDUINO
+
+  analyzerformat = format;
+  analyzersettle = settle;
+  analyzersamples = samples;
+  analyzerpoints = SweepPoints ();
+  analyzerpoint = 0;
+  analyzerdir = 1;
+
+  // The first point sets up the PLL, clock control and output enable. All points use SI_MAX_PLL_FREQ
+  analyzerfreq = SweepFrequency (0);
+  SetFrequency (clk, (clk == SI_CLK1) ? SI_PLL_B : SI_PLL_A, analyzerfreq);
+  Si5351MSPayload (SI_MAX_PLL_FREQ, analyzerfreq, analyzerlast);
+  analyzerbase = SIREG_42_MSYN0_1 + clk * SI_MSREGS;
+  analyzertuned = micros();
+  AnalyzerPrepare ();
+
+#ifdef ENABLE_OLED
+  OLEDClearPages (OLED_PLOT_PAGE, OLED_PLOT_PAGES);
+#endif // ENABLE_OLED
+
+  if (format == ANALYZER_CSV) Serial.println (F("Hz,ADC/16"));
+  analyzercount = 0;
+  analyzerstart = millis();
+  analyzeractive = 1;
+  return 1;
+}
+
+void AnalyzerStop (void)
+// The output is left on the last frequency sent
+{
+  if (!analyzeractive) return;
+  ReleaseTimer2 (TIMER2_ANALYZER);
+  analyzeractive = 0;
+  analyzerstop = millis();
+}
+
+void AnalyzerPoll (void)
+// Called from loop(). Measure one point and tune to the next
+{
+  unsigned long freq;
+  unsigned int sum = 0, value;
+  unsigned char i, last, done;
+#ifdef ENABLE_OLED
+  unsigned char x, width;
+#endif // ENABLE_OLED
+
+  if (!analyzeractive) return;
+  freq = analyzerfreq;
+  last = (analyzerdir > 0) ? (analyzerpoint == analyzerpoints - 1) : !analyzerpoint;
+  done = last && sweepcfg.mode == SWEEP_SINGLE;
+
+  while (micros() - analyzertuned < analyzersettle);
+  for (i=1; i<analyzersamples; i++) {
+    AnalyzerConvert ();
+    sum += AnalyzerResult ();
+  }
+
+  // The detector is sampled in the first 1.5 ADC clocks so the clock can be retuned while the ADC converts
+  AnalyzerConvert ();
+  if (!done) {
+    delayMicroseconds (ANALYZER_HOLD_US);
+    AnalyzerRetune ();
+  }
+  sum += AnalyzerResult ();
+
+  value = (unsigned int)(((unsigned long)sum * 16 + analyzersamples / 2) / analyzersamples);
+  AnalyzerSend (analyzerpoint, freq, value, last);
+  analyzercount++;
+
+#ifdef ENABLE_OLED
+  // Points are spread over the width of the plot. A value of 16368 (1023 * 16) fills the area
+  x = (unsigned char)(((unsigned long)analyzerpoint * OLED_WIDTH) / analyzerpoints);
+  width = (unsigned char)(((unsigned long)(analyzerpoint + 1) * OLED_WIDTH) / analyzerpoints) - x;
+  if (width) OLEDPlot (x, width, value >> 6);
+#endif // ENABLE_OLED
+
+  if (done) {
+    AnalyzerStop ();
+    return;
+  }
+  analyzerpoint = AnalyzerNext ();
+  if (last && sweepcfg.mode == SWEEP_TRIANGLE) analyzerdir = -analyzerdir;
+  AnalyzerPrepare ();
+}
+
+void AnalyzerReport (void)
+{
+  unsigned long ms;
+
+  ms = (analyzeractive ? millis() : analyzerstop) - analyzerstart;
+  Serial.print (analyzeractive ? F("Analyzer: on") : F("Analyzer: off"));
+  Serial.print (F(" Points: "));
+  Serial.print (analyzercount);
+  Serial.print (F(" Points/s: "));
+  Serial.println (ms ? (unsigned long)(((unsigned long long)analyzercount * 1000 + ms / 2) / ms) : 0);
+}
+
+#endif // ENABLE_ANALYZER
@@ -0,0 +1,31 @@
+#ifndef _ANALYZER_H_
+#define _ANALYZER_H_
+
+// Scalar network analyzer.  A clock is swept over the points of the configured sweep (W command) and a log
+// detector such as an AD8307 on ANALYZER_CHANNEL is sampled at each point.  After each retune the detector
+// is given settle us and then the average of samples ADC conversions is sent over serial as CSV or binary.
+// The last conversion of a point is held by the ADC while the next point is sent to the Si5351.
+// Host builds have no ADC.  A detector on a tuned circuit is simulated instead
+
+#define ANALYZER_CHANNEL        0           // A0
+#define ANALYZER_ADC_PRESCALE   ((1 << ADPS2) | (1 << ADPS1))   // 250kHz ADC clock, 52us per conversion
+#define ANALYZER_HOLD_US        8           // ADC sample and hold ends 1.5 ADC clocks after the start
+#define ANALYZER_MAX_SAMPLES    64          // 64 sums of 1023 fit in 16 bits
+#define ANALYZER_DEFAULT_SETTLE 100         // us
+#define ANALYZER_DEFAULT_SAMPLES 4
+
+// Output formats. Values are the average ADC reading in 1/16 LSB
+#define ANALYZER_CSV            'C'         // Hz,value lines
+#define ANALYZER_BINARY         'B'         // ANALYZER_SYNC, point (2), value (2). Little endian
+
+#define ANALYZER_SYNC           0x5A      // Not PROTO_SYNC so a point is never taken for a protocol frame
+#define ANALYZER_LAST           0x8000      // Set in the binary value of the last point of each pass
+
+extern unsigned char analyzeractive;
+
+unsigned char AnalyzerStart (unsigned char clk, unsigned int settle, unsigned char samples, char format);
+void AnalyzerStop (void);
+void AnalyzerPoll (void);
+void AnalyzerReport (void);
+
+#endif // _ANALYZER_H_
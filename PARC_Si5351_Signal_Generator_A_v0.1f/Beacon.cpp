@@ -0,0 +1,769 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to transmit WSPR, FT8 and JT65 beacons on the Si5351.
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+*/
+
+#include "Arduino.h"
+
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
+#include "VE3OOI_Si5351_v2.1.h"
+#include "i2c.h"
+#include "Timer.h"
+#include "Log.h"
+#include "Beacon.h"
+
+#ifdef ENABLE_BEACON
+
+// loop() computes the multisynth registers of the next symbols into a ring while the Timer2 ISR sends one
+// each time a symbol is due.  Symbol k of a transmission is due on the first tick at or after k * num/den ms
+// so ticks are counted against the exact period without drift.  A symbol that is due while the ring is empty
+// or while loop() is in the middle of an I2C transaction is sent on the next tick and counted as late.
+// Each symbol is time stamped against its ideal start and the worst error of a transmission is logged.
+const Beacon_Mode beaconmodes[] PROGMEM = {
+  {BEACON_WSPR, 162, 2, 3,  6000,  2048,   3,   120000},    // 12000/8192 Hz tones, 8192/12000 s symbols
+  {BEACON_FT8,  79,  3, 7,  25600, 160,    1,   15000},     // 6.25 Hz tones, 0.16 s symbols
+  {BEACON_JT65, 126, 7, 65, 11025, 163840, 441, 60000}      // 11025/4096 Hz tones, 4096/11025 s symbols
+};
+
+// WSPR sync vector, one bit per symbol from bit 0 of the first byte
+const unsigned char wsprsync[] PROGMEM = {
+  0x03, 0x71, 0xA4, 0x07, 0xA4, 0x40, 0xB3, 0x58, 0x58, 0x95, 0x34,
+  0x56, 0x04, 0xC9, 0xCD, 0xE2, 0xA0, 0x0C, 0x58, 0x63, 0x00
+};
+
+#ifdef ENABLE_FT8
+// FT8 LDPC (174,91) generator. Row i has the message bits that make up parity bit i, message bit 0 in bit 7
+// of the first byte.  Channel symbols are the Gray code of 3 codeword bits between three 7x7 Costas arrays
+const unsigned char ft8generator[FT8_PARITY_BITS][12] PROGMEM = {
+  {0x83, 0x29, 0xCE, 0x11, 0xBF, 0x31, 0xEA, 0xF5, 0x09, 0xF2, 0x7F, 0xC0},
+  {0x76, 0x1C, 0x26, 0x4E, 0x25, 0xC2, 0x59, 0x33, 0x54, 0x93, 0x13, 0x20},
+  {0xDC, 0x26, 0x59, 0x02, 0xFB, 0x27, 0x7C, 0x64, 0x10, 0xA1, 0xBD, 0xC0},
+  {0x1B, 0x3F, 0x41, 0x78, 0x58, 0xCD, 0x2D, 0xD3, 0x3E, 0xC7, 0xF6, 0x20},
+  {0x09, 0xFD, 0xA4, 0xFE, 0xE0, 0x41, 0x95, 0xFD, 0x03, 0x47, 0x83, 0xA0},
+  {0x07, 0x7C, 0xCC, 0xC1, 0x1B, 0x88, 0x73, 0xED, 0x5C, 0x3D, 0x48, 0xA0},
+  {0x29, 0xB6, 0x2A, 0xFE, 0x3C, 0xA0, 0x36, 0xF4, 0xFE, 0x1A, 0x9D, 0xA0},
+  {0x60, 0x54, 0xFA, 0xF5, 0xF3, 0x5D, 0x96, 0xD3, 0xB0, 0xC8, 0xC3, 0xE0},
+  {0xE2, 0x07, 0x98, 0xE4, 0x31, 0x0E, 0xED, 0x27, 0x88, 0x4A, 0xE9, 0x00},
+  {0x77, 0x5C, 0x9C, 0x08, 0xE8, 0x0E, 0x26, 0xDD, 0xAE, 0x56, 0x31, 0x80},
+  {0xB0, 0xB8, 0x11, 0x02, 0x8C, 0x2B, 0xF9, 0x97, 0x21, 0x34, 0x87, 0xC0},
+  {0x18, 0xA0, 0xC9, 0x23, 0x1F, 0xC6, 0x0A, 0xDF, 0x5C, 0x5E, 0xA3, 0x20},
+  {0x76, 0x47, 0x1E, 0x83, 0x02, 0xA0, 0x72, 0x1E, 0x01, 0xB1, 0x2B, 0x80},
+  {0xFF, 0xBC, 0xCB, 0x80, 0xCA, 0x83, 0x41, 0xFA, 0xFB, 0x47, 0xB2, 0xE0},
+  {0x66, 0xA7, 0x2A, 0x15, 0x8F, 0x93, 0x25, 0xA2, 0xBF, 0x67, 0x17, 0x00},
+  {0xC4, 0x24, 0x36, 0x89, 0xFE, 0x85, 0xB1, 0xC5, 0x13, 0x63, 0xA1, 0x80},
+  {0x0D, 0xFF, 0x73, 0x94, 0x14, 0xD1, 0xA1, 0xB3, 0x4B, 0x1C, 0x27, 0x00},
+  {0x15, 0xB4, 0x88, 0x30, 0x63, 0x6C, 0x8B, 0x99, 0x89, 0x49, 0x72, 0xE0},
+  {0x29, 0xA8, 0x9C, 0x0D, 0x3D, 0xE8, 0x1D, 0x66, 0x54, 0x89, 0xB0, 0xE0},
+  {0x4F, 0x12, 0x6F, 0x37, 0xFA, 0x51, 0xCB, 0xE6, 0x1B, 0xD6, 0xB9, 0x40},
+  {0x99, 0xC4, 0x72, 0x39, 0xD0, 0xD9, 0x7D, 0x3C, 0x84, 0xE0, 0x94, 0x00},
+  {0x19, 0x19, 0xB7, 0x51, 0x19, 0x76, 0x56, 0x21, 0xBB, 0x4F, 0x1E, 0x80},
+  {0x09, 0xDB, 0x12, 0xD7, 0x31, 0xFA, 0xEE, 0x0B, 0x86, 0xDF, 0x6B, 0x80},
+  {0x48, 0x8F, 0xC3, 0x3D, 0xF4, 0x3F, 0xBD, 0xEE, 0xA4, 0xEA, 0xFB, 0x40},
+  {0x82, 0x74, 0x23, 0xEE, 0x40, 0xB6, 0x75, 0xF7, 0x56, 0xEB, 0x5F, 0xE0},
+  {0xAB, 0xE1, 0x97, 0xC4, 0x84, 0xCB, 0x74, 0x75, 0x71, 0x44, 0xA9, 0xA0},
+  {0x2B, 0x50, 0x0E, 0x4B, 0xC0, 0xEC, 0x5A, 0x6D, 0x2B, 0xDB, 0xDD, 0x00},
+  {0xC4, 0x74, 0xAA, 0x53, 0xD7, 0x02, 0x18, 0x76, 0x16, 0x69, 0x36, 0x00},
+  {0x8E, 0xBA, 0x1A, 0x13, 0xDB, 0x33, 0x90, 0xBD, 0x67, 0x18, 0xCE, 0xC0},
+  {0x75, 0x38, 0x44, 0x67, 0x3A, 0x27, 0x78, 0x2C, 0xC4, 0x20, 0x12, 0xE0},
+  {0x06, 0xFF, 0x83, 0xA1, 0x45, 0xC3, 0x70, 0x35, 0xA5, 0xC1, 0x26, 0x80},
+  {0x3B, 0x37, 0x41, 0x78, 0x58, 0xCC, 0x2D, 0xD3, 0x3E, 0xC3, 0xF6, 0x20},
+  {0x9A, 0x4A, 0x5A, 0x28, 0xEE, 0x17, 0xCA, 0x9C, 0x32, 0x48, 0x42, 0xC0},
+  {0xBC, 0x29, 0xF4, 0x65, 0x30, 0x9C, 0x97, 0x7E, 0x89, 0x61, 0x0A, 0x40},
+  {0x26, 0x63, 0xAE, 0x6D, 0xDF, 0x8B, 0x5C, 0xE2, 0xBB, 0x29, 0x48, 0x80},
+  {0x46, 0xF2, 0x31, 0xEF, 0xE4, 0x57, 0x03, 0x4C, 0x18, 0x14, 0x41, 0x80},
+  {0x3F, 0xB2, 0xCE, 0x85, 0xAB, 0xE9, 0xB0, 0xC7, 0x2E, 0x06, 0xFB, 0xE0},
+  {0xDE, 0x87, 0x48, 0x1F, 0x28, 0x2C, 0x15, 0x39, 0x71, 0xA0, 0xA2, 0xE0},
+  {0xFC, 0xD7, 0xCC, 0xF2, 0x3C, 0x69, 0xFA, 0x99, 0xBB, 0xA1, 0x41, 0x20},
+  {0xF0, 0x26, 0x14, 0x47, 0xE9, 0x49, 0x0C, 0xA8, 0xE4, 0x74, 0xCE, 0xC0},
+  {0x44, 0x10, 0x11, 0x58, 0x18, 0x19, 0x6F, 0x95, 0xCD, 0xD7, 0x01, 0x20},
+  {0x08, 0x8F, 0xC3, 0x1D, 0xF4, 0xBF, 0xBD, 0xE2, 0xA4, 0xEA, 0xFB, 0x40},
+  {0xB8, 0xFE, 0xF1, 0xB6, 0x30, 0x77, 0x29, 0xFB, 0x0A, 0x07, 0x8C, 0x00},
+  {0x5A, 0xFE, 0xA7, 0xAC, 0xCC, 0xB7, 0x7B, 0xBC, 0x9D, 0x99, 0xA9, 0x00},
+  {0x49, 0xA7, 0x01, 0x6A, 0xC6, 0x53, 0xF6, 0x5E, 0xCD, 0xC9, 0x07, 0x60},
+  {0x19, 0x44, 0xD0, 0x85, 0xBE, 0x4E, 0x7D, 0xA8, 0xD6, 0xCC, 0x7D, 0x00},
+  {0x25, 0x1F, 0x62, 0xAD, 0xC4, 0x03, 0x2F, 0x0E, 0xE7, 0x14, 0x00, 0x20},
+  {0x56, 0x47, 0x1F, 0x87, 0x02, 0xA0, 0x72, 0x1E, 0x00, 0xB1, 0x2B, 0x80},
+  {0x2B, 0x8E, 0x49, 0x23, 0xF2, 0xDD, 0x51, 0xE2, 0xD5, 0x37, 0xFA, 0x00},
+  {0x6B, 0x55, 0x0A, 0x40, 0xA6, 0x6F, 0x47, 0x55, 0xDE, 0x95, 0xC2, 0x60},
+  {0xA1, 0x8A, 0xD2, 0x8D, 0x4E, 0x27, 0xFE, 0x92, 0xA4, 0xF6, 0xC8, 0x40},
+  {0x10, 0xC2, 0xE5, 0x86, 0x38, 0x8C, 0xB8, 0x2A, 0x3D, 0x80, 0x75, 0x80},
+  {0xEF, 0x34, 0xA4, 0x18, 0x17, 0xEE, 0x02, 0x13, 0x3D, 0xB2, 0xEB, 0x00},
+  {0x7E, 0x9C, 0x0C, 0x54, 0x32, 0x5A, 0x9C, 0x15, 0x83, 0x6E, 0x00, 0x00},
+  {0x36, 0x93, 0xE5, 0x72, 0xD1, 0xFD, 0xE4, 0xCD, 0xF0, 0x79, 0xE8, 0x60},
+  {0xBF, 0xB2, 0xCE, 0xC5, 0xAB, 0xE1, 0xB0, 0xC7, 0x2E, 0x07, 0xFB, 0xE0},
+  {0x7E, 0xE1, 0x82, 0x30, 0xC5, 0x83, 0xCC, 0xCC, 0x57, 0xD4, 0xB0, 0x80},
+  {0xA0, 0x66, 0xCB, 0x2F, 0xED, 0xAF, 0xC9, 0xF5, 0x26, 0x64, 0x12, 0x60},
+  {0xBB, 0x23, 0x72, 0x5A, 0xBC, 0x47, 0xCC, 0x5F, 0x4C, 0xC4, 0xCD, 0x20},
+  {0xDE, 0xD9, 0xDB, 0xA3, 0xBE, 0xE4, 0x0C, 0x59, 0xB5, 0x60, 0x9B, 0x40},
+  {0xD9, 0xA7, 0x01, 0x6A, 0xC6, 0x53, 0xE6, 0xDE, 0xCD, 0xC9, 0x03, 0x60},
+  {0x9A, 0xD4, 0x6A, 0xED, 0x5F, 0x70, 0x7F, 0x28, 0x0A, 0xB5, 0xFC, 0x40},
+  {0xE5, 0x92, 0x1C, 0x77, 0x82, 0x25, 0x87, 0x31, 0x6D, 0x7D, 0x3C, 0x20},
+  {0x4F, 0x14, 0xDA, 0x82, 0x42, 0xA8, 0xB8, 0x6D, 0xCA, 0x73, 0x35, 0x20},
+  {0x8B, 0x8B, 0x50, 0x7A, 0xD4, 0x67, 0xD4, 0x44, 0x1D, 0xF7, 0x70, 0xE0},
+  {0x22, 0x83, 0x1C, 0x9C, 0xF1, 0x16, 0x94, 0x67, 0xAD, 0x04, 0xB6, 0x80},
+  {0x21, 0x3B, 0x83, 0x8F, 0xE2, 0xAE, 0x54, 0xC3, 0x8E, 0xE7, 0x18, 0x00},
+  {0x5D, 0x92, 0x6B, 0x6D, 0xD7, 0x1F, 0x08, 0x51, 0x81, 0xA4, 0xE1, 0x20},
+  {0x66, 0xAB, 0x79, 0xD4, 0xB2, 0x9E, 0xE6, 0xE6, 0x95, 0x09, 0xE5, 0x60},
+  {0x95, 0x81, 0x48, 0x68, 0x2D, 0x74, 0x8A, 0x38, 0xDD, 0x68, 0xBA, 0xA0},
+  {0xB8, 0xCE, 0x02, 0x0C, 0xF0, 0x69, 0xC3, 0x2A, 0x72, 0x3A, 0xB1, 0x40},
+  {0xF4, 0x33, 0x1D, 0x6D, 0x46, 0x16, 0x07, 0xE9, 0x57, 0x52, 0x74, 0x60},
+  {0x6D, 0xA2, 0x3B, 0xA4, 0x24, 0xB9, 0x59, 0x61, 0x33, 0xCF, 0x9C, 0x80},
+  {0xA6, 0x36, 0xBC, 0xBC, 0x7B, 0x30, 0xC5, 0xFB, 0xEA, 0xE6, 0x7F, 0xE0},
+  {0x5C, 0xB0, 0xD8, 0x6A, 0x07, 0xDF, 0x65, 0x4A, 0x90, 0x89, 0xA2, 0x00},
+  {0xF1, 0x1F, 0x10, 0x68, 0x48, 0x78, 0x0F, 0xC9, 0xEC, 0xDD, 0x80, 0xA0},
+  {0x1F, 0xBB, 0x53, 0x64, 0xFB, 0x8D, 0x2C, 0x9D, 0x73, 0x0D, 0x5B, 0xA0},
+  {0xFC, 0xB8, 0x6B, 0xC7, 0x0A, 0x50, 0xC9, 0xD0, 0x2A, 0x5D, 0x03, 0x40},
+  {0xA5, 0x34, 0x43, 0x30, 0x29, 0xEA, 0xC1, 0x5F, 0x32, 0x2E, 0x34, 0xC0},
+  {0xC9, 0x89, 0xD9, 0xC7, 0xC3, 0xD3, 0xB8, 0xC5, 0x5D, 0x75, 0x13, 0x00},
+  {0x7B, 0xB3, 0x8B, 0x2F, 0x01, 0x86, 0xD4, 0x66, 0x43, 0xAE, 0x96, 0x20},
+  {0x26, 0x44, 0xEB, 0xAD, 0xEB, 0x44, 0xB9, 0x46, 0x7D, 0x1F, 0x42, 0xC0},
+  {0x60, 0x8C, 0xC8, 0x57, 0x59, 0x4B, 0xFB, 0xB5, 0x5D, 0x69, 0x60, 0x00}
+};
+
+const unsigned char ft8costas[7] PROGMEM = {3, 1, 4, 0, 6, 5, 2};
+const unsigned char ft8gray[8] PROGMEM = {0, 1, 3, 2, 5, 6, 4, 7};
+#endif // ENABLE_FT8
+
+#ifdef ENABLE_JT65
+// JT65 Reed Solomon (63,12) generator polynomial over GF(64) with x^6 + x + 1. Its roots are alpha^3 to
+// alpha^53. Coefficient 0 first, the leading 1 is left out
+const unsigned char jt65genpoly[JT65_PARITY] PROGMEM = {
+  58, 22, 62,  5, 24, 29, 53, 59, 14, 54, 15, 29, 21, 30, 54, 59, 16,
+  61, 14, 40, 43, 48, 44, 43, 63, 22, 12, 44, 44, 51, 48, 63, 56, 13,
+  17, 54,  1, 34,  5, 21, 13,  9, 57, 46, 31,  2, 14,  4,  5,  2, 52
+};
+
+// JT65 sync vector, one bit per symbol from bit 0 of the first byte.  Sync symbols are tone 0
+const unsigned char jt65sync[] PROGMEM = {
+  0x19, 0xBF, 0xA2, 0x89, 0xF3, 0xF6, 0x58, 0xCD, 0x2A, 0x81, 0x01, 0x4B, 0xAB, 0x4C, 0xC2, 0x3F
+};
+#endif // ENABLE_JT65
+
+Beacon_Mode beaconmode;                         // Mode of the symbol table
+unsigned char beacontones[BEACON_TABLE_BYTES];
+unsigned char beaconloaded;                     // Symbols in the table
+
+Beacon_Step beaconring[BEACON_AHEAD];
+volatile unsigned char beaconhead, beacontail;
+volatile unsigned char beaconactive, beaconsending;
+volatile unsigned char beaconsymbol;            // Next symbol sent. symbols + 1 between transmissions
+volatile long beaconacc;                        // Ticks since the next symbol was due, times den
+volatile unsigned long beaconslotms;            // ms since the transmission started
+volatile unsigned long beaconlate, beaconworst, beaconlastworst;
+volatile unsigned int beacontx;                 // Transmissions completed
+
+unsigned long beaconstartus;                    // Ideal start of the transmission in micros()
+unsigned long beaconidealus, beaconperiodus;
+unsigned int beaconidealrem, beaconperiodrem;   // Fractions of a us, times den
+
+uint64_t beaconf0;                              // Tone 0 in 1/BEACON_FREQ_SCALE Hz
+unsigned char beaconrepeat, beaconbase, beaconoeon, beaconoeoff;
+unsigned char beaconnext;                       // Next symbol to compute
+unsigned char beacondone;                       // Every symbol of a single transmission has been computed
+unsigned char beaconlast[SI_MSREGS];            // Payload of the last symbol computed
+
+
+static unsigned char BeaconSelectMode (char mode)
+{
+  unsigned char i;
+
+  for (i=0; i<sizeof(beaconmodes) / sizeof(beaconmodes[0]); i++) {
+    if (pgm_read_byte (&beaconmodes[i].mode) == mode) {
+      memcpy_P (&beaconmode, &beaconmodes[i], sizeof(beaconmode));
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static unsigned char BeaconGetTone (unsigned char i)
+{
+  unsigned int bit = (unsigned int)i * beaconmode.bits;
+  unsigned int v = beacontones[bit >> 3] | (beacontones[(bit >> 3) + 1] << 8);
+
+  return (v >> (bit & 7)) & ((1 << beaconmode.bits) - 1);
+}
+
+static void BeaconSetTone (unsigned char i, unsigned char tone)
+{
+  unsigned int bit = (unsigned int)i * beaconmode.bits;
+  unsigned int mask = ((1 << beaconmode.bits) - 1) << (bit & 7);
+  unsigned int v = (unsigned int)tone << (bit & 7);
+
+  beacontones[bit >> 3] = (beacontones[bit >> 3] & ~mask) | v;
+  beacontones[(bit >> 3) + 1] = (beacontones[(bit >> 3) + 1] & ~(mask >> 8)) | (v >> 8);
+}
+
+static unsigned long Parity (unsigned long x)
+{
+  x ^= x >> 16;
+  x ^= x >> 8;
+  x ^= x >> 4;
+  x ^= x >> 2;
+  x ^= x >> 1;
+  return x & 1;
+}
+
+static unsigned char WSPRChar (char c)
+// 0-9 are 0 to 9, A-Z are 10 to 35 and space is 36
+{
+  if (isdigit (c)) return c - '0';
+  if (isupper (c)) return c - 'A' + 10;
+  return 36;
+}
+
+static unsigned char BeaconCall (char *call, char *c)
+// Standard callsign in 6 characters with a digit third.  A callsign with a digit second gets a leading space.
+// Returns 0 if it is not a standard callsign
+{
+  unsigned char i, j, len;
+
+  len = strlen (call);
+  for (i=0; i<len; i++) call[i] = toupper (call[i]);
+  j = (len > 1 && isdigit (call[1])) ? 1 : 0;
+  if (len < 3 || len + j > 6) return 0;
+  for (i=0; i<6; i++) c[i] = ' ';
+  for (i=0; i<len; i++) c[i + j] = call[i];
+  if (!isalnum (c[0]) && c[0] != ' ') return 0;
+  if (!isalnum (c[1]) || !isdigit (c[2])) return 0;
+  for (i=3; i<6; i++) if (!isupper (c[i]) && c[i] != ' ') return 0;
+  return 1;
+}
+
+static unsigned long BeaconPackCall (char *c)
+// 28 bit WSPR and JT65 value of a callsign from BeaconCall()
+{
+  unsigned long n;
+  unsigned char i;
+
+  n = WSPRChar (c[0]);
+  n = n * 36 + WSPRChar (c[1]);
+  n = n * 10 + WSPRChar (c[2]);
+  for (i=3; i<6; i++) n = n * 27 + WSPRChar (c[i]) - 10;
+  return n;
+}
+
+static unsigned char BeaconGrid (char *grid)
+// Returns 1 for a 4 character Maidenhead locator.  It is converted to upper case
+{
+  unsigned char i;
+
+  if (strlen (grid) != 4) return 0;
+  for (i=0; i<4; i++) grid[i] = toupper (grid[i]);
+  if (grid[0] < 'A' || grid[0] > 'R' || grid[1] < 'A' || grid[1] > 'R') return 0;
+  return isdigit (grid[2]) && isdigit (grid[3]);
+}
+
+static unsigned int BeaconPackGrid (char *grid)
+// WSPR and JT65 value of a grid. It is the JT65 longitude and latitude of the centre of the square
+{
+  return (179 - 10 * (grid[0] - 'A') - (grid[2] - '0')) * 180U + 10 * (grid[1] - 'A') + (grid[3] - '0');
+}
+
+unsigned char BeaconWSPR (char *call, char *grid, unsigned char dbm)
+// Encode a type 1 WSPR message (callsign, 4 character grid and dBm) into the symbol table.  Returns 0 if
+// the message can not be sent as type 1 or a beacon is running
+{
+  char c[6];
+  unsigned long n, m, reg, bit;
+  unsigned char i, j;
+  unsigned int k, p;
+
+  if (beaconactive) return 0;
+  if (!BeaconCall (call, c) || !BeaconGrid (grid)) return 0;
+
+  // Only powers ending in 0, 3 or 7 dBm can be sent
+  if (dbm > 60 || (dbm % 10 != 0 && dbm % 10 != 3 && dbm % 10 != 7)) return 0;
+
+  n = BeaconPackCall (c);
+  m = BeaconPackGrid (grid) * 128UL + dbm + 64;
+
+  BeaconSelectMode (BEACON_WSPR);
+
+  // The 50 message bits and 31 zero bits are convolutionally encoded (K=32, r=1/2) into 162 bits.  Bit p
+  // goes to the symbol at the bit reversal of the p-th index below 162.  Each symbol is sync + 2 * data
+  reg = 0;
+  for (k=0, p=0; p<beaconmode.symbols; k++) {
+    for (i=0, j=0; i<8; i++) if (k & (1 << i)) j |= 0x80 >> i;
+    if (j >= beaconmode.symbols) continue;
+
+    if (!(p & 1)) {
+      if (p < 56) bit = (n >> (27 - p / 2)) & 1;
+      else if (p < 100) bit = (m >> (49 - p / 2)) & 1;
+      else bit = 0;
+      reg = (reg << 1) | bit;
+      bit = Parity (reg & 0xF2D05351UL);
+    } else {
+      bit = Parity (reg & 0xE4613C47UL);
+    }
+    BeaconSetTone (j, ((pgm_read_byte (&wsprsync[j >> 3]) >> (j & 7)) & 1) + 2 * bit);
+    p++;
+  }
+  beaconloaded = beaconmode.symbols;
+  return 1;
+}
+
+#if defined(ENABLE_FT8) || defined(ENABLE_JT65)
+static void BeaconPutBits (unsigned char *buf, unsigned char *pos, unsigned long v, unsigned char n)
+// Append the n low bits of v to a cleared buf, most significant bit first
+{
+  while (n--) {
+    if ((v >> n) & 1) buf[*pos >> 3] |= 0x80 >> (*pos & 7);
+    (*pos)++;
+  }
+}
+
+static unsigned char BeaconGetBits (unsigned char *buf, unsigned char pos, unsigned char n)
+// n bits of buf from bit pos, most significant bit first
+{
+  unsigned char v = 0;
+
+  for (; n; n--, pos++) v = (v << 1) | ((buf[pos >> 3] >> (7 - (pos & 7))) & 1);
+  return v;
+}
+
+static unsigned char BeaconDB (char *s, int *db)
+// Signal report of a sign and two digits, e.g. -07
+{
+  if ((s[0] != '+' && s[0] != '-') || !isdigit (s[1]) || !isdigit (s[2]) || s[3]) return 0;
+  *db = (s[1] - '0') * 10 + s[2] - '0';
+  if (s[0] == '-') *db = -*db;
+  return 1;
+}
+
+static void BeaconUpper (char *s)
+{
+  for (; *s; s++) *s = toupper (*s);
+}
+#endif // ENABLE_FT8 || ENABLE_JT65
+
+#ifdef ENABLE_FT8
+static unsigned long FT8PackCall (char *call)
+// 28 bit FT8 value of DE, QRZ, CQ or a standard callsign.  BEACON_BAD_CALL if it is none of them
+{
+  char c[6];
+  unsigned long n;
+  unsigned char i;
+
+  BeaconUpper (call);
+  if (!strcmp (call, "DE")) return 0;
+  if (!strcmp (call, "QRZ")) return 1;
+  if (!strcmp (call, "CQ")) return 2;
+  if (!BeaconCall (call, c)) return BEACON_BAD_CALL;
+
+  // Unlike WSPR space is the first character and letters follow it
+  n = (c[0] == ' ') ? 0 : WSPRChar (c[0]) + 1;
+  n = n * 36 + WSPRChar (c[1]);
+  n = n * 10 + WSPRChar (c[2]);
+  for (i=3; i<6; i++) n = n * 27 + ((c[i] == ' ') ? 0 : c[i] - 'A' + 1);
+  return FT8_NTOKENS + FT8_MAX22 + n;
+}
+
+static unsigned int FT8CRC (unsigned char *a)
+// CRC14 of the 77 message bits followed by 5 zero bits
+{
+  unsigned int crc = 0;
+  unsigned char i;
+
+  for (i=0; i<82; i++) {
+    if (!(i & 7)) crc ^= (unsigned int)a[i >> 3] << 6;
+    crc = (crc & 0x2000) ? (crc << 1) ^ FT8_CRC_POLY : crc << 1;
+  }
+  return crc & 0x3FFF;
+}
+
+unsigned char BeaconFT8 (char *call1, char *call2, char *extra)
+// Encode a standard FT8 message (i3 = 1) into the symbol table.  call1 is CQ, QRZ, DE or a callsign, call2 is a
+// callsign and extra is a grid, a report from -30 to +49 (R in front to acknowledge), RRR, RR73, 73 or NULL.
+// Returns 0 if the message can not be sent this way or a beacon is running
+{
+  unsigned char a[22];                  // 77 message bits, 14 CRC bits then 83 parity bits
+  unsigned long n1, n2;
+  unsigned int g;
+  unsigned char i, j, p, pos;
+  int db;
+
+  if (beaconactive) return 0;
+  if ((n1 = FT8PackCall (call1)) == BEACON_BAD_CALL) return 0;
+  if ((n2 = FT8PackCall (call2)) == BEACON_BAD_CALL || n2 < FT8_NTOKENS) return 0;
+
+  if (!extra || !*extra) {
+    g = FT8_MAXGRID4 + 1;
+  } else {
+    BeaconUpper (extra);
+    if (!strcmp (extra, "RRR")) g = FT8_MAXGRID4 + 2;
+    else if (!strcmp (extra, "RR73")) g = FT8_MAXGRID4 + 3;
+    else if (!strcmp (extra, "73")) g = FT8_MAXGRID4 + 4;
+    else if (BeaconGrid (extra)) g = ((extra[0] - 'A') * 18 + extra[1] - 'A') * 100 + (extra[2] - '0') * 10 + extra[3] - '0';
+    else {
+      i = (extra[0] == 'R');
+      if (!BeaconDB (extra + i, &db) || db < -30 || db > 49) return 0;
+      g = FT8_MAXGRID4 + 35 + db;
+      if (i) g |= 0x8000;               // The R bit is sent ahead of the grid
+    }
+  }
+
+  // Callsigns have no /R suffix and i3 is 1
+  memset (a, 0, sizeof(a));
+  pos = 0;
+  BeaconPutBits (a, &pos, n1 << 1, 29);
+  BeaconPutBits (a, &pos, n2 << 1, 29);
+  BeaconPutBits (a, &pos, g, 16);
+  BeaconPutBits (a, &pos, 1, 3);
+  BeaconPutBits (a, &pos, FT8CRC (a), 14);
+
+  // Generator bits past the 91 message and CRC bits are clear so the parity bits being added do not count
+  for (i=0; i<FT8_PARITY_BITS; i++) {
+    for (j=0, p=0; j<sizeof(ft8generator[0]); j++) p ^= a[j] & pgm_read_byte (&ft8generator[i][j]);
+    BeaconPutBits (a, &pos, Parity (p), 1);
+  }
+
+  BeaconSelectMode (BEACON_FT8);
+  for (i=0, pos=0; i<beaconmode.symbols; i++) {
+    j = i % 36;
+    if (j < 7) {
+      BeaconSetTone (i, pgm_read_byte (&ft8costas[j]));
+    } else {
+      BeaconSetTone (i, pgm_read_byte (&ft8gray[BeaconGetBits (a, pos, 3)]));
+      pos += 3;
+    }
+  }
+  beaconloaded = beaconmode.symbols;
+  return 1;
+}
+#endif // ENABLE_FT8
+
+#ifdef ENABLE_JT65
+static unsigned char GF64Mul (unsigned char a, unsigned char b)
+// Product in GF(64) with the field polynomial x^6 + x + 1
+{
+  unsigned char r = 0;
+
+  while (b) {
+    if (b & 1) r ^= a;
+    b >>= 1;
+    a <<= 1;
+    if (a & 0x40) a ^= 0x43;
+  }
+  return r;
+}
+
+unsigned char BeaconJT65 (char *call1, char *call2, char *extra)
+// Encode a standard JT65 message into the symbol table.  call1 is CQ, QRZ, DE or a callsign, call2 is a callsign
+// and extra is a grid, a report from -01 to -30 (R in front to acknowledge), RO, RRR, 73 or NULL.  Returns 0 if
+// the message can not be sent this way or a beacon is running
+{
+  unsigned char s[JT65_SYMBOLS];        // Parity symbols then the 12 data symbols
+  unsigned char m[9];                   // 72 message bits
+  char c[6];
+  unsigned long n1, n2;
+  unsigned int g;
+  unsigned char i, j, fb, pos;
+  int db;
+
+  if (beaconactive) return 0;
+  BeaconUpper (call1);
+  if (!strcmp (call1, "CQ")) n1 = JT65_NBASE + 1;
+  else if (!strcmp (call1, "QRZ")) n1 = JT65_NBASE + 2;
+  else if (!strcmp (call1, "DE")) n1 = JT65_DE;
+  else if (BeaconCall (call1, c)) n1 = BeaconPackCall (c);
+  else return 0;
+  if (!BeaconCall (call2, c)) return 0;
+  n2 = BeaconPackCall (c);
+
+  if (!extra || !*extra) {
+    g = JT65_NGBASE + 1;
+  } else {
+    BeaconUpper (extra);
+    if (!strcmp (extra, "RO")) g = JT65_NGBASE + 62;
+    else if (!strcmp (extra, "RRR")) g = JT65_NGBASE + 63;
+    else if (!strcmp (extra, "73")) g = JT65_NGBASE + 64;
+    else if (BeaconGrid (extra)) g = BeaconPackGrid (extra);
+    else {
+      i = (extra[0] == 'R');
+      if (!BeaconDB (extra + i, &db) || db < -30 || db > -1) return 0;
+      g = JT65_NGBASE + 1 - db + (i ? 30 : 0);
+    }
+  }
+
+  memset (m, 0, sizeof(m));
+  pos = 0;
+  BeaconPutBits (m, &pos, n1, 28);
+  BeaconPutBits (m, &pos, n2, 28);
+  BeaconPutBits (m, &pos, g, 16);
+  for (i=0; i<JT65_SYMBOLS - JT65_PARITY; i++) s[JT65_PARITY + i] = BeaconGetBits (m, i * 6, 6);
+
+  // Systematic Reed Solomon encoder.  The data goes in last symbol first and the parity symbols come out
+  // reversed, as in the WSJT encoder
+  memset (s, 0, JT65_PARITY);
+  for (i=JT65_SYMBOLS; i-- > JT65_PARITY; ) {
+    fb = s[i] ^ s[0];
+    for (j=1; j<JT65_PARITY; j++) s[j-1] = s[j] ^ GF64Mul (fb, pgm_read_byte (&jt65genpoly[JT65_PARITY - j]));
+    s[JT65_PARITY - 1] = GF64Mul (fb, pgm_read_byte (&jt65genpoly[0]));
+  }
+  for (i=0, j=JT65_PARITY - 1; i<j; i++, j--) {
+    fb = s[i];
+    s[i] = s[j];
+    s[j] = fb;
+  }
+
+  // The code symbols are sent in the order of a 7x9 interleaver and Gray coded between the sync symbols
+  BeaconSelectMode (BEACON_JT65);
+  for (i=0, j=0; i<beaconmode.symbols; i++) {
+    if ((pgm_read_byte (&jt65sync[i >> 3]) >> (i & 7)) & 1) {
+      BeaconSetTone (i, 0);
+    } else {
+      fb = s[j / 9 + 7 * (j % 9)];
+      BeaconSetTone (i, (fb ^ (fb >> 1)) + 2);
+      j++;
+    }
+  }
+  beaconloaded = beaconmode.symbols;
+  return 1;
+}
+#endif // ENABLE_JT65
+
+unsigned char BeaconLoad (char mode, unsigned char index, unsigned char *tones, unsigned char n)
+// Store n channel symbols from index.  Loading from index 0 sets the mode.  The table ends after the last
+// symbol loaded.  Returns the number of symbols in the table or 0 if a symbol is not valid
+{
+  unsigned char i;
+
+  if (beaconactive || !n || index > beaconloaded) return 0;
+  if (!index) {
+    if (!BeaconSelectMode (mode)) return 0;
+  } else if (mode != beaconmode.mode) {
+    return 0;
+  }
+  if (index + n > beaconmode.symbols) return 0;
+  for (i=0; i<n; i++) if (tones[i] > beaconmode.maxtone) return 0;
+
+  for (i=0; i<n; i++) BeaconSetTone (index + i, tones[i]);
+  beaconloaded = index + n;
+  return beaconloaded;
+}
+
+static void BeaconPayload (unsigned char tone, unsigned char *regs)
+// Multisynth registers for the tone.  The fraction of SI_MAX_PLL_FREQ / tone frequency is approximated by the
+// continued fraction convergent (or semiconvergent) with the largest denominator up to SI_MAX_DIVIDER
+{
+  uint64_t num, den, r, t;
+  unsigned long a, k, p0 = 0, q0 = 1, p1 = 1, q1 = 0, p2, q2;
+
+  den = beaconf0 + (uint64_t)tone * beaconmode.spacing;
+  num = (uint64_t)SI_MAX_PLL_FREQ * BEACON_FREQ_SCALE;
+  a = (unsigned long)(num / den);
+  num %= den;
+
+  for (;;) {
+    t = num / den;
+    if (q1 && t > (SI_MAX_DIVIDER - q0) / q1) {
+      // The next convergent is too fine. A semiconvergent past half way is closer than the last convergent
+      k = (SI_MAX_DIVIDER - q0) / q1;
+      if (2 * (uint64_t)k > t) {
+        p1 = p0 + k * p1;
+        q1 = q0 + k * q1;
+      }
+      break;
+    }
+    p2 = (unsigned long)t * p1 + p0;
+    q2 = (unsigned long)t * q1 + q0;
+    p0 = p1;
+    q0 = q1;
+    p1 = p2;
+    q1 = q2;
+    r = num - t * den;
+    if (!r) break;
+    num = den;
+    den = r;
+  }
+  Si5351MSEncode (a, p1, q1, regs);
+}
+
+unsigned char BeaconStart (unsigned char clk, uint64_t mhz, unsigned char repeat)
+// Transmit the symbol table on clk with tone 0 at mhz milliHz.  With repeat a transmission starts every slot
+// of the mode.  Returns 0 if the table is not complete, the frequency or clk is not valid or Timer2 is in use
+{
+  unsigned long hz = (unsigned long)((mhz + 500) / 1000);
+  unsigned char i;
+
+  if (clk >= MAXCLK || hz < BEACON_MIN_FREQ || hz > BEACON_MAX_FREQ) return 0;
+  if (!beaconloaded || beaconloaded != beaconmode.symbols) return 0;
+  if (!ClaimTimer2 (TIMER2_BEACON) || beaconactive) return 0;
+
+  // The PLL, clock control and multisynth are set up for tone 0 with the output off
+  beaconf0 = (mhz * BEACON_FREQ_SCALE + 500) / 1000;
+  SetFrequency (clk, (clk == SI_CLK1) ? SI_PLL_B : SI_PLL_A, hz);
+  beaconbase = SIREG_42_MSYN0_1 + clk * SI_MSREGS;
+  for (i=0; i<SI_MSREGS; i++) beaconlast[i] = Si5351ReadRegister (beaconbase + i);
+  beaconoeon = Si5351ReadRegister (SIREG_3_OUTPUT_ENABLE_CTL) & ~(1 << clk);
+  beaconoeoff = beaconoeon | (1 << clk);
+  Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, beaconoeoff);
+
+  beaconperiodus = beaconmode.num * 1000 / beaconmode.den;
+  beaconperiodrem = beaconmode.num * 1000 % beaconmode.den;
+  beaconidealus = beaconidealrem = 0;
+
+  // Compute the first symbols before Timer2 starts
+  beaconrepeat = repeat;
+  beaconnext = 0;
+  beacondone = 0;
+  beaconhead = beacontail = 0;
+  beaconsymbol = 0;
+  beaconacc = 0;
+  beaconslotms = 0;
+  beaconlate = beaconworst = beaconlastworst = 0;
+  beacontx = 0;
+  beaconactive = 1;
+  BeaconPoll ();
+
+  // The first tick is 1ms after Timer2 starts
+  beaconstartus = micros() + 1000;
+  EnableTimers (2, TIMER2_1MS);
+  return 1;
+}
+
+void BeaconStop (void)
+// The output is turned off
+{
+  if (!beaconactive) return;
+  ReleaseTimer2 (TIMER2_BEACON);
+  beaconactive = 0;
+  Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, beaconoeoff);
+}
+
+void BeaconPoll (void)
+// Called from loop(). Compute symbols until the ring is full.  A single transmission stops once it ended
+{
+  Beacon_Step *s;
+  unsigned char regs[SI_MSREGS];
+  unsigned char i, last;
+
+  if (!beaconactive) return;
+  if (!beaconrepeat && beaconsymbol > beaconmode.symbols) {
+    BeaconStop ();
+    return;
+  }
+
+  while (!beacondone && (unsigned char)(beaconhead - beacontail) < BEACON_AHEAD) {
+    BeaconPayload (BeaconGetTone (beaconnext), regs);
+
+    s = &beaconring[beaconhead & (BEACON_AHEAD - 1)];
+    s->flags = beaconnext ? 0 : BEACON_STEP_FIRST;
+    s->first = SI_MSREGS;
+    last = 0;
+    for (i=0; i<SI_MSREGS; i++) {
+      s->regs[i] = regs[i];
+      if (regs[i] != beaconlast[i]) {
+        if (s->first == SI_MSREGS) s->first = i;
+        last = i;
+      }
+      beaconlast[i] = regs[i];
+    }
+    s->count = (s->first == SI_MSREGS) ? 0 : last - s->first + 1;
+
+    if (++beaconnext >= beaconmode.symbols) {
+      beaconnext = 0;
+      if (!beaconrepeat) beacondone = 1;
+    }
+    beaconhead++;
+  }
+}
+
+void BeaconTick (void)
+// Called from the Timer2 ISR every 1ms.  A tick that arrives while a symbol is being sent is counted and the
+// next symbol is sent on the first tick after that
+{
+  Beacon_Step *s;
+  long err;
+
+  if (!beaconactive) return;
+  if (beaconsending) {
+    beaconacc += beaconmode.den;
+    beaconslotms++;
+    return;
+  }
+
+  if (beaconsymbol > beaconmode.symbols) {
+    // Between transmissions
+    if (!beaconrepeat || ++beaconslotms < beaconmode.slot) return;
+    beaconslotms = 0;
+    beaconsymbol = 0;
+    beaconacc = 0;
+    beaconstartus += beaconmode.slot * 1000;
+    beaconidealus = beaconidealrem = 0;
+  }
+
+  if (beaconacc >= 0) {
+    if (i2cbusy || (beaconsymbol < beaconmode.symbols && beaconhead == beacontail)) {
+      beaconlate++;
+
+    } else if (beaconsymbol == beaconmode.symbols) {
+      // The last symbol has ended
+      beaconsending = 1;
+      sei();
+      Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, beaconoeoff);
+      cli();
+      LogEvent (LOG_SYMBOL_TIME, beaconworst);
+      beaconlastworst = beaconworst;
+      beaconworst = 0;
+      beacontx++;
+      beaconsymbol++;
+      beaconsending = 0;
+
+    } else {
+      err = (long)(micros() - beaconstartus - beaconidealus);
+      if (err < 0) err = -err;
+      if ((unsigned long)err > beaconworst) beaconworst = err;
+
+      beaconsending = 1;
+      s = &beaconring[beacontail & (BEACON_AHEAD - 1)];
+      sei();
+      if (s->count) Si5351RepeatedWriteRegister (beaconbase + s->first, s->count, &s->regs[s->first]);
+      if (s->flags & BEACON_STEP_FIRST) Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, beaconoeon);
+      cli();
+      beacontail++;
+      beaconsymbol++;
+      beaconacc -= beaconmode.num;
+      beaconidealus += beaconperiodus;
+      beaconidealrem += beaconperiodrem;
+      if (beaconidealrem >= beaconmode.den) {
+        beaconidealrem -= beaconmode.den;
+        beaconidealus++;
+      }
+      beaconsending = 0;
+    }
+  }
+  beaconacc += beaconmode.den;
+  beaconslotms++;
+}
+
+void BeaconReport (void)
+{
+  unsigned char i;
+
+  Serial.print (beaconactive ? F("Beacon: on") : F("Beacon: off"));
+  Serial.print (F(" Mode: "));
+  Serial.print (beaconloaded ? beaconmode.mode : '-');
+  Serial.print (F(" Symbols: "));
+  Serial.print (beaconloaded);
+  Serial.print (F(" Sent: "));
+  Serial.print (beacontx);
+  Serial.print (F(" Late: "));
+  Serial.print (beaconlate);
+  Serial.print (F(" Worst us: "));
+  Serial.println (beaconlastworst);
+
+  for (i=0; i<beaconloaded; i++) {
+    Serial.print (BeaconGetTone (i));
+    Serial.print (' ');
+  }
+  Serial.println ();
+}
+
+#endif // ENABLE_BEACON
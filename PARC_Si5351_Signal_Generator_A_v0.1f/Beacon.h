@@ -0,0 +1,75 @@
+#ifndef _BEACON_H_
+#define _BEACON_H_
+
+// Beacon transmissions of WSPR, FT8 or JT65 channel symbols.  The symbols are kept in a bit packed table.
+// WSPR messages are encoded here, and so are standard FT8 and JT65 messages with ENABLE_FT8 and ENABLE_JT65.
+// Other FT8 and JT65 messages are encoded by the host and loaded over the binary protocol.  Symbols are timed by Timer2 in 1ms ticks.  The average symbol rate is exact and each
+// symbol starts within one tick of its ideal time.  The PLL is left at SI_MAX_PLL_FREQ and each symbol only
+// rewrites the multisynth registers of the tone that changed.  The multisynth divider of each tone is the best
+// fraction with a denominator up to SI_MAX_DIVIDER so the tones are within a small fraction of a mHz.
+
+#define BEACON_AHEAD        2           // Symbols computed ahead of time. Must be a power of 2
+#define BEACON_MIN_FREQ     1000000UL   // No R_DIV below this
+#define BEACON_MAX_FREQ     (SI_MIN_MSRATIO6_FREQ - 1000UL)   // Room for the highest tone
+#define BEACON_MAX_SYMBOLS  162
+#define BEACON_TABLE_BYTES  ((126 * 7 + 7) / 8 + 1)           // 126 JT65 symbols of 7 bits, one spare byte
+#define BEACON_FREQ_SCALE   4096        // Tones are computed in 1/4096 Hz so every tone spacing is exact
+
+// Modes
+#define BEACON_WSPR         'W'
+#define BEACON_FT8          'F'
+#define BEACON_JT65         'J'
+
+#define BEACON_BAD_CALL     0xFFFFFFFFUL
+
+// FT8 message and code
+#define FT8_NTOKENS         2063592UL   // 28 bit callsign values below this are DE, QRZ, CQ and other tokens
+#define FT8_MAX22           4194304UL   // Hashed callsigns, then standard callsigns
+#define FT8_MAXGRID4        32400       // Grid values past this are reports and acknowledgements
+#define FT8_CRC_POLY        0x2757
+#define FT8_PARITY_BITS     83
+
+// JT65 message and code
+#define JT65_NBASE          262177560UL // 37*36*10*27*27*27. Callsign values from here are CQ and QRZ
+#define JT65_DE             267796945UL
+#define JT65_NGBASE         32400U      // Grid values past this are reports and acknowledgements
+#define JT65_SYMBOLS        63          // Reed Solomon (63,12) code symbols of 6 bits
+#define JT65_PARITY         51
+
+// Packed symbol flags
+#define BEACON_STEP_FIRST   0x1         // First symbol of a transmission. The output is turned on after it
+
+typedef struct {
+  char mode;
+  unsigned char symbols;        // Channel symbols per transmission
+  unsigned char bits;           // Bits per symbol in the table
+  unsigned char maxtone;
+  unsigned int spacing;         // Tone spacing in 1/BEACON_FREQ_SCALE Hz
+  unsigned long num;            // Symbol period is num/den ms
+  unsigned int den;
+  unsigned long slot;           // ms from the start of one transmission to the next when repeating
+} Beacon_Mode;
+
+// Multisynth registers for one symbol.  Only count registers from first are sent
+typedef struct {
+  unsigned char first, count, flags;
+  unsigned char regs[SI_MSREGS];
+} Beacon_Step;
+
+extern volatile unsigned char beaconactive;
+
+unsigned char BeaconWSPR (char *call, char *grid, unsigned char dbm);
+#ifdef ENABLE_FT8
+unsigned char BeaconFT8 (char *call1, char *call2, char *extra);
+#endif // ENABLE_FT8
+#ifdef ENABLE_JT65
+unsigned char BeaconJT65 (char *call1, char *call2, char *extra);
+#endif // ENABLE_JT65
+unsigned char BeaconLoad (char mode, unsigned char index, unsigned char *tones, unsigned char n);
+unsigned char BeaconStart (unsigned char clk, uint64_t mhz, unsigned char repeat);
+void BeaconStop (void);
+void BeaconPoll (void);
+void BeaconTick (void);
+void BeaconReport (void);
+
+#endif // _BEACON_H_
@@ -0,0 +1,160 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to calibrate the Si5351 crystal from measured outputs.
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+*/
+
+#include "Arduino.h"
+#include <math.h>
+
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
+#include "VE3OOI_Si5351_v2.1.h"
+#include "LCD.h"
+#include "Counter.h"
+#include "Calibrate.h"
+
+#ifdef ENABLE_AUTO_CALIBRATION
+
+extern Sig_Gen_Struct sg;
+
+// A crystal error of e ppb makes an output set to x Hz e*x/1e6 mHz high.  With the errors d in mHz the least
+// squares error is e = 1e6 * sum(x*d) / sum(x*x).  The sums are kept in 64 bits.  A correction c already
+// applied scales the crystal by (1 + c) so the new correction is c + e + c*e in ppb
+Cal_Point calpoints[CAL_POINTS];
+unsigned char calpointn;
+long calcorrection;                         // Correction the points were measured with
+long calerror;                              // Crystal error in ppb from the last CalSolve()
+
+
+static long long CalError (unsigned char i)
+// Frequency error of a point in mHz
+{
+  return (long long)calpoints[i].measured - (long long)calpoints[i].freq * 1000;
+}
+
+void CalClear (void)
+{
+  calpointn = 0;
+  calcorrection = sg.correction;
+}
+
+unsigned char CalAddPoint (unsigned long freq, uint64_t measured)
+// Returns 0 if freq is not valid, the error is more than twice MAXIMUM_CORRECTION or all points are used
+{
+  long long d;
+
+  if (freq < SI_MIN_OUT_FREQ || freq > SI_MAX_OUT_FREQ) return 0;
+  d = (long long)measured - (long long)freq * 1000;
+  if (d < 0) d = -d;
+  if (d > (long long)freq * (2 * MAXIMUM_CORRECTION) / 1000000) return 0;
+
+  if (calcorrection != sg.correction) CalClear ();
+  if (calpointn >= CAL_POINTS) return 0;
+  calpoints[calpointn].freq = freq;
+  calpoints[calpointn].measured = measured;
+  calpointn++;
+  return 1;
+}
+
+#ifdef ENABLE_COUNTER
+unsigned char CalMeasure (unsigned long freq)
+// Set CLK0 to freq and add the frequency counted on D5 in one CAL_COUNTER_GATE gate.  CLK0 must be wired to D5.
+// CLK0 is set back to its own frequency, or turned off, afterwards.
+// Returns 0 if freq can not be counted, Timer2 is in use or the counter does not respond
+{
+  unsigned long start;
+  uint64_t mhz;
+  unsigned char counted = 0;
+
+  if (freq < SI_MIN_OUT_FREQ || freq > CAL_COUNTER_MAX_FREQ) return 0;
+  SetFrequency (SI_CLK0, SI_PLL_A, freq);
+
+  if (CounterStart (CAL_COUNTER_GATE)) {
+    Serial.println (F("Counting"));
+    start = millis();
+    while (!(counted = CounterRead (&mhz)) && millis() - start <= 2UL * CAL_COUNTER_GATE);
+    CounterStop ();
+  }
+
+  if (sg.ClkStatus[0]) UpdateFrequency (0);
+  else DisableFrequency (0);
+
+  return counted && CalAddPoint (freq, mhz);
+}
+#endif // ENABLE_COUNTER
+
+unsigned char CalSolve (long *correction, long *rms)
+// Returns 0 if there are no points or the new correction is more than MAXIMUM_CORRECTION.  rms is the
+// residual in mHz that the crystal error does not explain
+{
+  long long sxd = 0, r;
+  unsigned long long sxx = 0;
+  float sum = 0;
+  unsigned char i;
+
+  if (calcorrection != sg.correction) CalClear ();
+  if (!calpointn) return 0;
+
+  for (i=0; i<calpointn; i++) {
+    sxd += (long long)calpoints[i].freq * CalError (i);
+    sxx += (unsigned long long)calpoints[i].freq * calpoints[i].freq;
+  }
+
+  // |d| < 0.2x so sxx stays well above zero while sxd is made small enough to multiply by 1e6
+  while (sxd >= (1LL << 43) || sxd <= -(1LL << 43)) {
+    sxd /= 2;
+    sxx >>= 1;
+  }
+  sxd *= 1000000;
+  calerror = (long)((sxd + ((sxd < 0) ? -(long long)(sxx / 2) : (long long)(sxx / 2))) / (long long)sxx);
+
+  for (i=0; i<calpointn; i++) {
+    r = CalError (i) - (long long)calerror * calpoints[i].freq / 1000000;
+    sum += (float)r * (float)r;
+  }
+  *rms = (long)(sqrt (sum / calpointn) + 0.5);
+
+  *correction = calcorrection + calerror + (long)((long long)calcorrection * calerror / 1000000000);
+  return (*correction <= MAXIMUM_CORRECTION && *correction >= -MAXIMUM_CORRECTION);
+}
+
+void CalReport (void)
+// Shows the points, their residuals and the solution
+{
+  char buf[4];
+  long correction, rms;
+  unsigned char i, ok;
+
+  ok = CalSolve (&correction, &rms);
+  for (i=0; i<calpointn; i++) {
+    Serial.print (i);
+    Serial.print (F(" Hz: "));
+    Serial.print (calpoints[i].freq);
+    Serial.print (F(" Meas: "));
+    Serial.print ((unsigned long)(calpoints[i].measured / 1000));
+    FormatDecimal (buf, (unsigned long)(calpoints[i].measured % 1000), 3);
+    Serial.print ('.');
+    Serial.print (buf);
+    Serial.print (F(" Err mHz: "));
+    Serial.print ((long)CalError (i));
+    Serial.print (F(" Res mHz: "));
+    Serial.println ((long)(CalError (i) - (long long)calerror * calpoints[i].freq / 1000000));
+  }
+
+  Serial.print (F("Correction: "));
+  Serial.println (sg.correction);
+  if (!calpointn) return;
+  Serial.print (F("Error ppb: "));
+  Serial.print (calerror);
+  Serial.print (F(" New Correction: "));
+  Serial.print (correction);
+  Serial.print (F(" RMS mHz: "));
+  Serial.println (rms);
+  if (!ok) Serial.println (F("Bad Cal"));
+}
+
+#endif // ENABLE_AUTO_CALIBRATION
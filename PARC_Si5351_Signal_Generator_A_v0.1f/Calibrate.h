@@ -0,0 +1,24 @@
+#ifndef _CALIBRATE_H_
+#define _CALIBRATE_H_
+
+// Crystal calibration from measured outputs.  Each point is the frequency an output was set to and the
+// frequency measured with a reference counter or the built in counter.  The crystal error is the least squares
+// fit of the frequency errors, which is the error in ppb times the frequency.  Points measured with another
+// correction than the current one are dropped.  The correction is stored in sg.correction in ppb
+
+#define CAL_POINTS          4
+#define CAL_COUNTER_GATE    10000       // ms. 0.1Hz resolution
+#define CAL_COUNTER_MAX_FREQ 6000000UL  // Highest frequency T1 can count
+
+typedef struct {
+  unsigned long freq;                   // Hz set
+  uint64_t measured;                    // mHz measured
+} Cal_Point;
+
+void CalClear (void);
+unsigned char CalAddPoint (unsigned long freq, uint64_t measured);
+unsigned char CalMeasure (unsigned long freq);
+unsigned char CalSolve (long *correction, long *rms);
+void CalReport (void);
+
+#endif // _CALIBRATE_H_
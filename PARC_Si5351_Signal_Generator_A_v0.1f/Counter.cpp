@@ -0,0 +1,195 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to use Timer1 as a frequency counter.
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+*/
+
+#include "Arduino.h"
+
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
+#include "LCD.h"
+#include "Timer.h"
+#include "Counter.h"
+
+#ifdef ENABLE_COUNTER
+
+// The gate ends in the Timer2 ISR.  The count is read there and the last time stamped edge becomes the first
+// stamped edge of the next gate so gates follow each other without a gap.  The stamps are taken in the
+// Timer1 compare ISR at exactly known counts.  Only the ISR latency, which is about the same for every stamp,
+// is added to their times.  The prescale is set at the end of each gate for a stamp about every ms.
+// loop() picks up the result of each gate with CounterRead()
+volatile unsigned char counteractive;
+unsigned int countergate;                       // Gate in Timer2 ticks
+volatile unsigned int countertick;              // Ticks left in the gate
+volatile unsigned int counterovf;               // Timer1 overflows. The top 16 bits of the count
+volatile unsigned long countergatestart;        // Count at the start of the gate
+volatile unsigned int counterprescale;          // Input edges between time stamps
+volatile unsigned char counterhaveref;
+volatile unsigned long counterrefedge, counterreftime;      // First stamped edge of the gate
+volatile unsigned long counterlastedge, counterlasttime;    // Last stamped edge
+
+// Result of the last gate
+volatile unsigned char counterready;
+volatile unsigned long countercount, counteredges, countertime;
+unsigned long countergates;
+uint64_t counterlast;
+
+
+static unsigned long CounterCount (void)
+// Count with the overflows.  Called with interrupts off
+{
+  unsigned int count, ovf;
+
+  ovf = counterovf;
+  count = TCNT1;
+  if ((TIFR1 & (1 << TOV1)) && count < 0x8000) ovf++;
+  return ((unsigned long)ovf << 16) | count;
+}
+
+ISR(TIMER1_OVF_vect)
+{
+  counterovf++;
+}
+
+ISR(TIMER1_COMPB_vect)
+// The input edge at OCR1B was counted. Time stamp it and set up the next stamp.  The next stamp is
+// counterprescale edges from now so a prescale that is too small for the input can not queue up matches
+{
+  unsigned long now;
+
+  counterlasttime = TimerTimestamp();
+  now = CounterCount ();
+  counterlastedge = now - (unsigned int)((unsigned int)now - OCR1B);
+  if (!counterhaveref) {
+    counterrefedge = counterlastedge;
+    counterreftime = counterlasttime;
+    counterhaveref = 1;
+  }
+  OCR1B = (unsigned int)(now + counterprescale);
+}
+
+unsigned char CounterStart (unsigned int gate)
+// Count with a gate of gate ms.  Returns 0 if gate is not valid or Timer2 is in use
+{
+  if (gate < COUNTER_MIN_GATE || gate > COUNTER_MAX_GATE) return 0;
+  if (!ClaimTimer2 (TIMER2_COUNTER) || counteractive) return 0;
+
+  countergate = countertick = gate * 2;
+  countergates = 0;
+  counterlast = 0;
+  counterready = 0;
+  pinMode (COUNTER_PIN, INPUT);
+  EnableTimers (2, TIMER2_500US);               // The input ISR and time stamps move to Timer2
+
+  cli();
+  TIMSK1 = 0;
+  TCCR1A = 0;
+  TCCR1B = (1 << CS12) | (1 << CS11) | (1 << CS10);   // Clocked by rising edges on T1
+  TCNT1 = 0;
+  counterovf = 0;
+  countergatestart = 0;
+  counterprescale = COUNTER_MAX_PRESCALE;
+  OCR1B = COUNTER_MAX_PRESCALE;
+  counterhaveref = 0;
+  TIFR1 = (1 << TOV1) | (1 << OCF1A) | (1 << OCF1B);
+  TIMSK1 = (1 << TOIE1) | (1 << OCIE1B);
+  counteractive = 1;
+  sei();
+
+  return 1;
+}
+
+void CounterStop (void)
+{
+  if (!counteractive) return;
+  counteractive = 0;
+  TIMSK1 = 0;
+  EnableTimers (1, TIMER500);                   // Input ISR and time stamps back on Timer1
+  ReleaseTimer2 (TIMER2_COUNTER);
+}
+
+void CounterTick (void)
+// Called from the Timer2 ISR every 0.5ms with interrupts off
+{
+  unsigned long count;
+
+  if (!counteractive || --countertick) return;
+  countertick = countergate;
+
+  count = CounterCount ();
+  countercount = count - countergatestart;
+  countergatestart = count;
+
+  count = countercount / (countergate / 2) + 1;
+  counterprescale = (count > COUNTER_MAX_PRESCALE) ? COUNTER_MAX_PRESCALE : (unsigned int)count;
+
+  // The pending stamp was set up with the old prescale. At low frequencies the first one is COUNTER_MAX_PRESCALE
+  // edges away so it is brought forward when the prescale goes down
+  if ((unsigned int)(OCR1B - TCNT1) > counterprescale) OCR1B = TCNT1 + counterprescale;
+
+  counteredges = counterlastedge - counterrefedge;
+  countertime = counterlasttime - counterreftime;
+  counterrefedge = counterlastedge;
+  counterreftime = counterlasttime;
+  counterready = 1;
+}
+
+unsigned char CounterRead (uint64_t *mhz)
+// Returns 1 with the frequency in mHz once each gate ends.  The time between stamped edges is used if it has
+// more time stamp units than the gate has edges
+{
+  unsigned long count, edges, time;
+
+  if (!counterready) return 0;
+  cli();
+  count = countercount;
+  edges = counteredges;
+  time = countertime;
+  counterready = 0;
+  sei();
+
+  if (edges && time > count) {
+    counterlast = ((uint64_t)edges * (1000000000ULL / TIMER_TICK_US) + time / 2) / time;
+  } else {
+    counterlast = ((uint64_t)count * 2000000ULL + countergate / 2) / countergate;     // countergate is in 0.5ms
+  }
+
+  countergates++;
+  *mhz = counterlast;
+  return 1;
+}
+
+unsigned char CounterFormat (char *buf, uint64_t mhz)
+// Write mhz as Hz with 3 decimals, right justified in 8 digits.  Returns the number of characters written
+{
+  unsigned char i;
+
+  FormatDecimal (buf, (unsigned long)(mhz / 1000), 8);
+  for (i=0; i<7 && buf[i] == '0'; i++) buf[i] = ' ';
+  buf[8] = '.';
+  FormatDecimal (&buf[9], (unsigned long)(mhz % 1000), 3);
+  return COUNTER_FORMAT_LEN - 1;
+}
+
+void CounterReport (void)
+// Shows the last reading
+{
+  char buf[COUNTER_FORMAT_LEN];
+  uint64_t mhz;
+
+  CounterRead (&mhz);
+  CounterFormat (buf, counterlast);
+  Serial.print (counteractive ? F("Counter: on") : F("Counter: off"));
+  Serial.print (F(" Gate ms: "));
+  Serial.print (countergate / 2);
+  Serial.print (F(" Gates: "));
+  Serial.print (countergates);
+  Serial.print (F(" Hz: "));
+  Serial.println (buf);
+}
+
+#endif // ENABLE_COUNTER
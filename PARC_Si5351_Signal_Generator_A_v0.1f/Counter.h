@@ -0,0 +1,28 @@
+#ifndef _COUNTER_H_
+#define _COUNTER_H_
+
+// Frequency counter.  The input on T1 (D5) clocks Timer1 and Timer1 overflows extend the count to 32 bits.
+// While it runs the rotary encoder, push buttons and time stamps move from Timer1 to Timer2, which also times
+// the gate.  Every counterprescale input edges a Timer1 compare match time stamps the edge.  Low frequencies
+// are measured from the time between the first and last stamped edges of the gate (reciprocal counting)
+// and high frequencies from the count in the gate.  D5 is also PBUTTON1 which is ignored while counting.
+// T1 is sampled by the CPU clock so the input must be below about 6MHz.  The reading is only as accurate
+// as the Arduino clock
+
+#define COUNTER_PIN         5           // T1
+#define COUNTER_MIN_GATE    10          // ms
+#define COUNTER_MAX_GATE    10000       // ms
+#define COUNTER_DEFAULT_GATE 1000       // ms
+#define COUNTER_MAX_PRESCALE 0xFFFF     // Edges between time stamps until the frequency is known
+#define COUNTER_FORMAT_LEN  13          // "HHHHHHHH.mmm" and the terminator
+
+extern volatile unsigned char counteractive;
+
+unsigned char CounterStart (unsigned int gate);
+void CounterStop (void);
+unsigned char CounterRead (uint64_t *mhz);
+unsigned char CounterFormat (char *buf, uint64_t mhz);
+void CounterTick (void);
+void CounterReport (void);
+
+#endif // _COUNTER_H_
@@ -0,0 +1,316 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to drive the 4x20 LCD through different libraries.
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+ */
+
+#include "Arduino.h"
+
+#include <stdint.h>
+
+#include "Display.h"
+#include "OLED.h"
+
+// Each backend counts the bytes it puts on the I2C bus (including the address byte of each
+// transaction) so backends can be compared with the LCD benchmark.  Counts follow what the
+// library sends for each command or character.
+
+#ifdef ARDUINO
+#ifdef USE_HD44780
+#include <Wire.h>                           // Comes with Arduino IDE
+#include <hd44780.h>                        // main hd44780 header
+#include <hd44780ioClass/hd44780_I2Cexp.h>  // i2c expander i/o class header
+#include "hd44780_I2CexpBatch.h"            // i2c expander with batched character writes
+
+class HD44780Backend : public LCDBackend
+{
+public:
+  void begin (unsigned char cols, unsigned char rows)
+  {
+    lcd.begin(cols, rows);                  // auto locate & auto config expander chip
+    lcd.backlight();
+
+    // MCP23008 needs the GPIO register before the data. Each command is two nibbles with E high/low
+    header = 1 + (lcd.getProp(hd44780_I2Cexp::Prop_expType) == I2Cexp_MCP23008);
+    batch = (BUFFER_LENGTH - (header - 1)) / I2CEXP_BATCH_BYTES_PER_CHAR;
+  }
+
+  void clear (void)
+  {
+    lcd.clear();
+    busbytes += header + I2CEXP_BATCH_BYTES_PER_CHAR;
+  }
+
+  void setCursor (unsigned char col, unsigned char row)
+  {
+    lcd.setCursor(col, row);
+    busbytes += header + I2CEXP_BATCH_BYTES_PER_CHAR;
+  }
+
+  void write (const unsigned char *buf, unsigned char len)
+  {
+    lcd.writeRun(buf, len);
+    busbytes += (unsigned long)header * ((len + batch - 1) / batch) + (unsigned long)len * I2CEXP_BATCH_BYTES_PER_CHAR;
+  }
+
+  void cursor (unsigned char on)
+  {
+    if (on) {
+      lcd.cursor();
+      lcd.blink();
+    } else {
+      lcd.noCursor();
+      lcd.noBlink();
+    }
+    busbytes += 2 * (header + I2CEXP_BATCH_BYTES_PER_CHAR);
+  }
+
+private:
+  hd44780_I2CexpBatch lcd;
+  unsigned char header;         // Bytes in front of the data in each transaction
+  unsigned char batch;          // Characters per transaction
+};
+
+HD44780Backend hd44780backend;
+
+#else
+#include <LiquidCrystal_I2C.h>
+
+// LiquidCrystal_I2C sends every nibble as two 1 byte transactions (E high then E low)
+#define LIQUIDCRYSTAL_BYTES_PER_CHAR 8
+
+class LiquidCrystalBackend : public LCDBackend
+{
+public:
+  LiquidCrystalBackend () : lcd(0x3F, 2, 1, 0, 4, 5, 6, 7, 3, POSITIVE) {}  // Set the LCD I2C address
+
+  void begin (unsigned char cols, unsigned char rows)
+  {
+    lcd.begin(cols, rows);
+    lcd.backlight();
+  }
+
+  void clear (void)
+  {
+    lcd.clear();
+    busbytes += LIQUIDCRYSTAL_BYTES_PER_CHAR;
+  }
+
+  void setCursor (unsigned char col, unsigned char row)
+  {
+    lcd.setCursor(col, row);
+    busbytes += LIQUIDCRYSTAL_BYTES_PER_CHAR;
+  }
+
+  void write (const unsigned char *buf, unsigned char len)
+  {
+    busbytes += (unsigned long)len * LIQUIDCRYSTAL_BYTES_PER_CHAR;
+    while (len--) lcd.write(*buf++);
+  }
+
+  void cursor (unsigned char on)
+  {
+    if (on) {
+      lcd.cursor();
+      lcd.blink();
+    } else {
+      lcd.noCursor();
+      lcd.noBlink();
+    }
+    busbytes += 2 * LIQUIDCRYSTAL_BYTES_PER_CHAR;
+  }
+
+private:
+  LiquidCrystal_I2C lcd;
+};
+
+LiquidCrystalBackend liquidcrystalbackend;
+#endif  //USE_HD44780
+
+#else
+#include <stdio.h>
+#include <string.h>
+
+// Host build console backend. Every operation is recorded as one line on stderr and the whole
+// display is drawn after each clear or write so a session can be followed or diffed.  stdout is
+// left to Serial
+class ConsoleBackend : public LCDBackend
+{
+public:
+  void begin (unsigned char cols, unsigned char rows)
+  {
+    ncols = (cols > sizeof(screen[0])) ? sizeof(screen[0]) : cols;
+    nrows = (rows > sizeof(screen) / sizeof(screen[0])) ? sizeof(screen) / sizeof(screen[0]) : rows;
+    clear();
+  }
+
+  void clear (void)
+  {
+    memset (screen, ' ', sizeof(screen));
+    col = row = 0;
+    busbytes++;
+    fprintf (stderr, "clear\n");
+    draw();
+  }
+
+  void setCursor (unsigned char c, unsigned char r)
+  {
+    col = c;
+    row = r;
+    busbytes++;
+    fprintf (stderr, "cursor %u %u\n", c, r);
+  }
+
+  void write (const unsigned char *buf, unsigned char len)
+  {
+    fprintf (stderr, "write %u %u \"%.*s\"\n", col, row, len, (const char *)buf);
+    while (len--) {
+      if (col < ncols && row < nrows) screen[row][col] = *buf;
+      col++;
+      buf++;
+      busbytes++;
+    }
+    draw();
+  }
+
+  void cursor (unsigned char on)
+  {
+    busbytes += 2;
+    fprintf (stderr, "blink %u\n", on);
+  }
+
+private:
+  char screen[4][20];
+  unsigned char ncols, nrows;
+  unsigned char col, row;
+
+  void draw (void)
+  {
+    unsigned char r;
+
+    for (r=0; r<nrows; r++) fprintf (stderr, "|%.*s|\n", ncols, screen[r]);
+  }
+};
+
+ConsoleBackend consolebackend;
+#endif // ARDUINO
+
+
+#ifdef ENABLE_OLED
+// The LCD text is drawn on the top half of the OLED (see OLED.h).  The LCD cursor is shown as an
+// underline that follows the address counter like the LCD cursor does.  Pages that changed are sent
+// from update(), one I2C transaction per call unless everything has to be sent
+class OLEDBackend : public LCDBackend
+{
+public:
+  void begin (unsigned char cols, unsigned char rows)
+  {
+    OLEDInit();
+    col = row = 0;
+    on = 0;
+  }
+
+  void clear (void)
+  {
+    OLEDClear();
+    col = row = 0;
+    if (on) OLEDUnderline(X(col), row, 1);
+  }
+
+  void setCursor (unsigned char c, unsigned char r)
+  {
+    move(c, r);
+  }
+
+  void write (const unsigned char *buf, unsigned char len)
+  {
+    while (len--) {
+      if (row < OLED_TEXT_PAGES) OLEDDrawChar(X(col), row, *buf++);
+      move(col + 1, row);
+    }
+  }
+
+  void cursor (unsigned char c)
+  {
+    on = c;
+    OLEDUnderline(X(col), row, on);
+  }
+
+  void update (unsigned char all)
+  {
+    busbytes += OLEDSendPages(all);
+  }
+
+private:
+  unsigned char col, row;
+  unsigned char on;
+
+  unsigned char X (unsigned char c) { return OLED_TEXT_X + c * OLED_CHAR_PITCH; }
+
+  void move (unsigned char c, unsigned char r)
+  {
+    if (on) OLEDUnderline(X(col), row, 0);
+    col = c;
+    row = r;
+    if (on) OLEDUnderline(X(col), row, 1);
+  }
+};
+
+OLEDBackend oledbackend;
+#endif // ENABLE_OLED
+
+
+// Null backend.  Nothing is sent so a benchmark shows the time spent in LCD.cpp itself
+class NullBackend : public LCDBackend
+{
+public:
+  void begin (unsigned char cols, unsigned char rows) {}
+  void clear (void) {}
+  void setCursor (unsigned char col, unsigned char row) {}
+  void write (const unsigned char *buf, unsigned char len) {}
+  void cursor (unsigned char on) {}
+};
+
+NullBackend nullbackend;
+
+const char lcdbackendnames[LCD_BACKENDS][LCD_BACKEND_NAME_LEN] PROGMEM = {
+  "HD44780", "LiquidCrystal", "Null", "Console", "OLED"
+};
+
+
+LCDBackend *LCDGetBackend (unsigned char id)
+// Returns 0 if the backend is not compiled in
+{
+  switch (id) {
+#ifdef ARDUINO
+#ifdef USE_HD44780
+    case LCD_BACKEND_HD44780:
+      return &hd44780backend;
+#else
+    case LCD_BACKEND_LIQUIDCRYSTAL:
+      return &liquidcrystalbackend;
+#endif  //USE_HD44780
+#else
+    case LCD_BACKEND_CONSOLE:
+      return &consolebackend;
+#endif // ARDUINO
+
+#ifdef ENABLE_OLED
+    case LCD_BACKEND_OLED:
+      return &oledbackend;
+#endif // ENABLE_OLED
+
+    case LCD_BACKEND_NULL:
+      return &nullbackend;
+  }
+  return 0;
+}
+
+const __FlashStringHelper *LCDBackendName (unsigned char id)
+{
+  return (const __FlashStringHelper *)lcdbackendnames[id];
+}
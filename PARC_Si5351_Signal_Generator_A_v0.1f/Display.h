@@ -0,0 +1,51 @@
+#ifndef _DISPLAY_H_
+#define _DISPLAY_H_
+
+//========================================================
+// LCD Library
+// Can use either LiquidCrystal or HD44780 library.
+// define below selects which library to use
+//========================================================
+#define USE_HD44780     // if this is defined, will use the HD44780 libary
+                        // if commented out, will use LiquidCrystal library
+
+//#define ENABLE_OLED   // 128x64 SSD1306 OLED is the default display (OLED.cpp). Its framebuffer takes 1KB of RAM
+//#define OLED_SH1106   // OLED has a SH1106 controller
+
+// Display backends. LCD.cpp only talks to the display through an LCDBackend
+#define LCD_BACKEND_HD44780         0     // hd44780 library, I2C expander with batched writes
+#define LCD_BACKEND_LIQUIDCRYSTAL   1     // NewliquidCrystal LiquidCrystal_I2C
+#define LCD_BACKEND_NULL            2     // Discards everything. Shows the cost of LCD.cpp itself
+#define LCD_BACKEND_CONSOLE         3     // Host build only (host/Makefile). Records the display on stderr
+#define LCD_BACKEND_OLED            4     // 128x64 OLED. Host builds write PBM files
+#define LCD_BACKENDS                5
+
+#ifndef ARDUINO
+#define LCD_DEFAULT_BACKEND LCD_BACKEND_CONSOLE
+#elif defined(ENABLE_OLED)
+#define LCD_DEFAULT_BACKEND LCD_BACKEND_OLED
+#elif defined(USE_HD44780)
+#define LCD_DEFAULT_BACKEND LCD_BACKEND_HD44780
+#else
+#define LCD_DEFAULT_BACKEND LCD_BACKEND_LIQUIDCRYSTAL
+#endif
+
+#define LCD_BACKEND_NAME_LEN 14
+
+class LCDBackend
+{
+public:
+  virtual void begin (unsigned char cols, unsigned char rows) = 0;
+  virtual void clear (void) = 0;
+  virtual void setCursor (unsigned char col, unsigned char row) = 0;
+  virtual void write (const unsigned char *buf, unsigned char len) = 0;   // Characters at the cursor
+  virtual void cursor (unsigned char on) = 0;                             // Cursor and blink on/off
+  virtual void update (unsigned char all) {}                              // Called after LCDFlush() sends changes
+
+  unsigned long busbytes;       // Bytes put on the bus, including I2C addresses
+};
+
+LCDBackend *LCDGetBackend (unsigned char id);
+const __FlashStringHelper *LCDBackendName (unsigned char id);
+
+#endif // _DISPLAY_H_
@@ -13,6 +13,9 @@
 #include "LCD.h"
 #include "Encoder.h"
 #include "Timer.h"
+#include "Trace.h"
+#include "Profile.h"
+#include "Counter.h"
 
 extern volatile unsigned long flags;
 
@@ -20,6 +23,7 @@ extern volatile unsigned long flags;
 // Encoder Variables
 volatile int enc_states[] = {0, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 volatile int old_AB;
+volatile int rotarycount;                    // Net detents not yet processed by menu code
 volatile unsigned int pbstate;
 volatile unsigned long pbreset;
 
@@ -82,6 +86,9 @@ void CheckPushButtons (void)
 {
   pb1current = digitalRead(PBUTTON1);
   pb2current = digitalRead(PBUTTON2);
+#ifdef ENABLE_COUNTER
+  if (counteractive) pb1current = !PBUTTON_STATE;     // PBUTTON1 is the counter input on T1
+#endif // ENABLE_COUNTER
 
   mscurrent = millis();
 
@@ -98,6 +105,7 @@ void CheckPushButtons (void)
       if (pb1state == PBUTTON_STATE && !(flags & PBUTTON1_PUSHED) ) {
         digitalWrite(LED_BUILTIN, HIGH);
         flags |= PBUTTON1_PUSHED;
+        TRACE_EVENT(TRACE_PBUTTON1);
       }
     }
   }
@@ -109,6 +117,7 @@ void CheckPushButtons (void)
       if (pb2state == PBUTTON_STATE && !(flags & PBUTTON2_PUSHED) ) {
         digitalWrite(LED_BUILTIN, HIGH);
         flags |= PBUTTON2_PUSHED;
+        TRACE_EVENT(TRACE_PBUTTON2);
       }
     }
   }
@@ -120,31 +129,63 @@ void CheckEncoder (void)
 // This routine is used to poll the encoder for rotation or rotary button pushed.
 // Rotation with cause frequency to increase or decrease by the current increment.
 // Rotary pushbutton will cycle through increment values
-  unsigned long mult;
+// Detents are added to rotarycount so none are lost if the menu code is busy. The menu code
+// reads the net count with GetRotaryCount() and applies it in one update.
   int retvalue;
-  
-  // May overrun so don't process if flags has not been cleared (i.e. last update processed)
-  if ( (flags & ROTARY_CCW) || (flags & ROTARY_CW)) {
-    return;
-  }
 
   retvalue = 0;
   
   // Check for rotation or push
   retvalue = ReadEncoder();        // Returns 0, 1 or -1
   if (retvalue < 0) {
-    flags |= ROTARY_CCW;
+    RotaryDetent (-1);
     digitalWrite(LED_BUILTIN, HIGH);  
     
   } else if (retvalue > 0) {
-    flags |= ROTARY_CW;
+    RotaryDetent (1);
     digitalWrite(LED_BUILTIN, HIGH);
-
-    
   } 
    
 }
 
+void RotaryDetent (int dir)
+// Add a detent (1 for CW, -1 for CCW) to the pending count. ROTARY_CW or ROTARY_CCW is set
+// based on direction of the net count.  Called from the Timer1 ISR or trace replay.
+{
+  unsigned char sreg;
+
+  sreg = SREG;
+  cli();
+  if (!rotarycount) LATENCY_STAMP();        // Latency is measured from the oldest pending detent
+  if (dir > 0 && rotarycount < ROTARY_COUNT_MAX) rotarycount++;
+  else if (dir < 0 && rotarycount > -ROTARY_COUNT_MAX) rotarycount--;
+
+  flags &= ~ROTARY_CW;
+  flags &= ~ROTARY_CCW;
+  if (rotarycount > 0) flags |= ROTARY_CW;
+  else if (rotarycount < 0) flags |= ROTARY_CCW;
+  SREG = sreg;
+}
+
+int GetRotaryCount (void)
+// Returns the net number of detents since the last call (+ for CW, - for CCW) and clears the rotary flags.
+// The trace records the count here, as the menu code applies it, so a replay makes the same updates
+{
+  int count;
+  unsigned char sreg;
+
+  sreg = SREG;
+  cli();
+  count = rotarycount;
+  rotarycount = 0;
+  if (count) TRACE_ROTARY(count);
+  flags &= ~ROTARY_CW;
+  flags &= ~ROTARY_CCW;
+  SREG = sreg;
+
+  return count;
+}
+
 
 int ReadEncoder(void)
 {
@@ -179,6 +220,7 @@ void ReadPBEncoder(void)
   if (!button && !pbstate) {                            // Button pushed and relax condition met
     pbstate = PUSH_BUTTON_RELAXATION;                  // Reset counter for relaxation period
     flags |= ROTARY_PUSH;
+    TRACE_EVENT(TRACE_ROTARY_PUSH);
     pbstate = PBDEBOUNCE;
 
   // Relaxation period
@@ -191,6 +233,7 @@ void ReadPBEncoder(void)
   if (!button) {            // Button continually pushed 
     if (pbreset++ > PUSH_BUTTON_RESET) {
       flags |= MASTER_RESET;
+      TRACE_EVENT(TRACE_MASTER_RESET);
       pbreset = 0;
     }
   }
@@ -29,6 +29,8 @@
 
 #define PBDEBOUNCE 30
 
+#define ROTARY_COUNT_MAX 100     // Limit on detents queued before menu code processes them
+
 #define PB1ENABLED 0x1
 #define PB2ENABLED 0x2
 #define PB3ENABLED 0x4
@@ -39,6 +41,8 @@ void SetupEncoder (void);
 int ReadEncoder(void);
 void ReadPBEncoder(void);
 void CheckEncoder (void);
+void RotaryDetent (int dir);
+int GetRotaryCount (void);
 void CheckPushButtons (void);
 
 
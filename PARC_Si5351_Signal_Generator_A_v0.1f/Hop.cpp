@@ -0,0 +1,248 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to play a table of frequency hops on the Si5351.
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+*/
+
+#include "Arduino.h"
+
+#include <EEPROM.h>
+
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
+#include "VE3OOI_Si5351_v2.1.h"
+#include "i2c.h"
+#include "Timer.h"
+#include "Hop.h"
+
+#ifdef ENABLE_HOP
+
+// loop() packs the registers of the next hops into a ring while the Timer2 ISR sends one each time the
+// dwell of the previous hop ends.  The multisynth registers of all three clocks are kept in hoplast so
+// a hop only sends the registers that differ from the previous hop.  A hop that is due while the ring is
+// empty or while loop() is in the middle of an I2C transaction is sent on the next tick and counted as late.
+// In trigger mode the table waits at its last entry and the INT0 edge restarts it exactly one tick later.
+Hop_Entry hoptable[HOP_ENTRIES];
+unsigned char hopentries;
+
+Hop_Step hopring[HOP_AHEAD];
+volatile unsigned char hophead, hoptail;
+volatile unsigned char hopactive, hopsending, hoparmed;
+volatile unsigned int hopcountdown;
+volatile unsigned long hopsteps, hoplate, hoptriggers;
+
+char hopmode;
+unsigned char hopnext;                          // Next entry to pack
+unsigned char hopdone;                          // Every entry of a one shot has been packed
+unsigned char hoplast[MAXCLK * SI_MSREGS];      // Multisynth registers after the last hop packed
+unsigned char hopoe;                            // Output enable register after the last hop packed
+
+
+unsigned char HopSet (unsigned char index, unsigned char mask, unsigned long freq, unsigned int dwell, unsigned char on)
+// Set a table entry.  An entry past the end of the table is added to it. Returns 0 if the entry is not valid
+{
+  if (hopactive || index >= HOP_ENTRIES || index > hopentries) return 0;
+  if (!mask || mask & ~(SI_ENABLE_CLK0 | SI_ENABLE_CLK1 | SI_ENABLE_CLK2)) return 0;
+  if (freq && (freq < HOP_MIN_FREQ || freq > HOP_MAX_FREQ)) return 0;
+  if (!dwell || dwell > HOP_MAX_DWELL || on > 1) return 0;
+
+  hoptable[index].freq = freq;
+  hoptable[index].dwell = dwell;
+  hoptable[index].mask = mask;
+  hoptable[index].on = on;
+  if (index == hopentries) hopentries++;
+  return 1;
+}
+
+void HopClear (void)
+{
+  if (!hopactive) hopentries = 0;
+}
+
+void HopSave (void)
+{
+  EEPROM.update (HOP_ADDRESS, hopentries);
+  EEPROM.put (HOP_ADDRESS + 1, hoptable);
+}
+
+unsigned char HopLoad (void)
+// Returns 0 if no table was saved
+{
+  unsigned char n;
+
+  n = EEPROM.read (HOP_ADDRESS);
+  if (hopactive || n > HOP_ENTRIES) return 0;
+  EEPROM.get (HOP_ADDRESS + 1, hoptable);
+  hopentries = n;
+  return 1;
+}
+
+static void HopTrigger (void)
+// INT0 ISR.  The first hop is sent on the Timer2 compare match one tick from now
+{
+  if (!hoparmed) return;
+  TCNT2 = 0;
+  TIFR2 = _BV(OCF2A);
+  hopcountdown = 1;
+  hoparmed = 0;
+  hoptriggers++;
+}
+
+unsigned char HopStart (char mode)
+// Returns 0 if the table is empty, Timer2 is in use or mode is not valid
+{
+  unsigned char i, clk, used = 0, oe = 0;
+
+  if (!hopentries || (mode != HOP_ONESHOT && mode != HOP_LOOP && mode != HOP_TRIGGER)) return 0;
+  if (!ClaimTimer2 (TIMER2_HOP) || hopactive) return 0;
+  hopmode = mode;
+
+  // Every clock in the table is set up on SI_MAX_PLL_FREQ with the first frequency it is given.  A clock
+  // that is only turned on and off keeps its current set up
+  for (i=0; i<hopentries; i++) {
+    oe |= hoptable[i].mask;
+    if (!hoptable[i].freq) continue;
+    for (clk=0; clk<MAXCLK; clk++) {
+      if (!(hoptable[i].mask & (1 << clk)) || (used & (1 << clk))) continue;
+      used |= 1 << clk;
+      SetFrequency (clk, (clk == SI_CLK1) ? SI_PLL_B : SI_PLL_A, hoptable[i].freq);
+    }
+  }
+
+  // The clocks are off until a hop turns them on
+  hopoe = Si5351ReadRegister (SIREG_3_OUTPUT_ENABLE_CTL) | oe;
+  Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, hopoe);
+  for (i=0; i<MAXCLK * SI_MSREGS; i++) hoplast[i] = Si5351ReadRegister (SIREG_42_MSYN0_1 + i);
+
+  // Pack the first hops before Timer2 starts
+  hopnext = 0;
+  hopdone = 0;
+  hophead = hoptail = 0;
+  hopsteps = hoplate = hoptriggers = 0;
+  hopcountdown = 1;
+  hoparmed = (mode == HOP_TRIGGER);
+  hopactive = 1;
+  HopPoll ();
+
+  if (mode == HOP_TRIGGER) {
+    pinMode (HOP_TRIGGER_PIN, INPUT_PULLUP);
+    attachInterrupt (digitalPinToInterrupt (HOP_TRIGGER_PIN), HopTrigger, FALLING);
+  }
+  EnableTimers (2, TIMER2_1MS);
+  return 1;
+}
+
+void HopStop (void)
+// The clocks are left as the last hop sent set them
+{
+  if (!hopactive) return;
+  ReleaseTimer2 (TIMER2_HOP);
+  if (hopmode == HOP_TRIGGER) detachInterrupt (digitalPinToInterrupt (HOP_TRIGGER_PIN));
+  hopactive = 0;
+}
+
+void HopPoll (void)
+// Called from loop(). Pack hops until the ring is full.  A one shot stops once its last hop was sent
+{
+  Hop_Entry *e;
+  Hop_Step *s;
+  unsigned char i, clk, last, oe;
+
+  if (!hopactive) return;
+
+  while (!hopdone && (unsigned char)(hophead - hoptail) < HOP_AHEAD) {
+    e = &hoptable[hopnext];
+    s = &hopring[hophead & (HOP_AHEAD - 1)];
+
+    for (i=0; i<MAXCLK * SI_MSREGS; i++) s->regs[i] = hoplast[i];
+    if (e->freq) {
+      for (clk=0; clk<MAXCLK; clk++) {
+        if (e->mask & (1 << clk)) Si5351MSPayload (SI_MAX_PLL_FREQ, e->freq, &s->regs[clk * SI_MSREGS]);
+      }
+    }
+
+    s->first = MAXCLK * SI_MSREGS;
+    last = 0;
+    for (i=0; i<MAXCLK * SI_MSREGS; i++) {
+      if (s->regs[i] != hoplast[i]) {
+        if (s->first == MAXCLK * SI_MSREGS) s->first = i;
+        last = i;
+      }
+      hoplast[i] = s->regs[i];
+    }
+    s->count = (s->first == MAXCLK * SI_MSREGS) ? 0 : last - s->first + 1;
+
+    oe = e->on ? hopoe & ~e->mask : hopoe | e->mask;
+    s->flags = (oe != hopoe) ? HOP_STEP_OE : 0;
+    s->oe = hopoe = oe;
+    s->dwell = e->dwell;
+
+    if (++hopnext >= hopentries) {
+      hopnext = 0;
+      s->flags |= HOP_STEP_LAST;
+      if (hopmode == HOP_ONESHOT) hopdone = 1;
+    }
+    hophead++;
+  }
+
+  if (hopdone && hophead == hoptail) HopStop ();
+}
+
+void HopTick (void)
+// Called from the Timer2 ISR every 1ms. Ticks that arrive while a step is being sent still count
+// down its dwell
+{
+  Hop_Step *s;
+
+  if (!hopactive || hoparmed) return;
+  if (hopcountdown > 1) {
+    hopcountdown--;
+    return;
+  }
+  if (hopsending) return;
+  if (hophead == hoptail || i2cbusy) {
+    hoplate++;
+    return;
+  }
+
+  hopsending = 1;
+  s = &hopring[hoptail & (HOP_AHEAD - 1)];
+  hopcountdown = s->dwell;
+  sei();
+  if (s->count) Si5351RepeatedWriteRegister (SIREG_42_MSYN0_1 + s->first, s->count, &s->regs[s->first]);
+  if (s->flags & HOP_STEP_OE) Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, s->oe);
+  cli();
+  if ((s->flags & HOP_STEP_LAST) && hopmode == HOP_TRIGGER) hoparmed = 1;
+  hoptail++;
+  hopsteps++;
+  hopsending = 0;
+}
+
+void HopReport (void)
+{
+  unsigned char i;
+
+  Serial.print (hopactive ? F("Hop: on") : F("Hop: off"));
+  Serial.print (F(" Hops: "));
+  Serial.print (hopsteps);
+  Serial.print (F(" Late: "));
+  Serial.print (hoplate);
+  Serial.print (F(" Triggers: "));
+  Serial.println (hoptriggers);
+
+  for (i=0; i<hopentries; i++) {
+    Serial.print (i);
+    Serial.print (F(": "));
+    Serial.print (hoptable[i].mask);
+    Serial.print (' ');
+    Serial.print (hoptable[i].freq);
+    Serial.print (' ');
+    Serial.print (hoptable[i].dwell);
+    Serial.println (hoptable[i].on ? F(" on") : F(" off"));
+  }
+}
+
+#endif // ENABLE_HOP
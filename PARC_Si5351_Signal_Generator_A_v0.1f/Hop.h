@@ -0,0 +1,57 @@
+#ifndef _HOP_H_
+#define _HOP_H_
+
+// Hop table playback.  Each entry sets the clocks in its mask to a frequency, turns them on or off and
+// holds for its dwell.  Hops are timed by Timer2 in 1ms ticks like the sweep.  The PLLs are left at
+// SI_MAX_PLL_FREQ and the register payload of each hop is packed in loop() up to HOP_AHEAD hops before
+// it is due.  The Timer2 ISR only sends it.
+
+#define HOP_ENTRIES         16          // Entries in the hop table
+#define HOP_AHEAD           4           // Hops packed ahead of time. Must be a power of 2
+#define HOP_TRIGGER_PIN     2           // External trigger input (INT0), falling edge
+#define HOP_MIN_FREQ        1000000UL   // No R_DIV below this
+#define HOP_MAX_FREQ        SI_MIN_MSRATIO6_FREQ
+#define HOP_MAX_DWELL       60000       // ms
+
+// The hop table is stored in EEPROM after the boot record. Entry count then the entries
+#define HOP_ADDRESS         (BOOT_MENU_ADDRESS + 1)
+
+// Start modes
+#define HOP_ONESHOT         'O'         // Play the table once
+#define HOP_LOOP            'L'         // Play the table over and over
+#define HOP_TRIGGER         'T'         // Play the table once for each falling edge on HOP_TRIGGER_PIN
+
+// Packed hop flags
+#define HOP_STEP_OE         0x1         // Output enable register changes
+#define HOP_STEP_LAST       0x2         // Last entry of the table
+
+typedef struct {
+  unsigned long freq;           // Hz. 0 leaves the frequency of the clocks unchanged
+  unsigned int dwell;           // ms
+  unsigned char mask;           // SI_ENABLE_CLKx bits
+  unsigned char on;             // 1 to turn the clocks on, 0 to turn them off
+} Hop_Entry;
+
+// Registers for one hop.  count multisynth registers from SIREG_42_MSYN0_1 + first are sent and then
+// the output enable register if HOP_STEP_OE is set
+typedef struct {
+  unsigned int dwell;
+  unsigned char first, count, oe, flags;
+  unsigned char regs[MAXCLK * SI_MSREGS];
+} Hop_Step;
+
+extern Hop_Entry hoptable[HOP_ENTRIES];
+extern unsigned char hopentries;
+extern volatile unsigned char hopactive;
+
+unsigned char HopSet (unsigned char index, unsigned char mask, unsigned long freq, unsigned int dwell, unsigned char on);
+void HopClear (void);
+void HopSave (void);
+unsigned char HopLoad (void);
+unsigned char HopStart (char mode);
+void HopStop (void);
+void HopPoll (void);
+void HopTick (void);
+void HopReport (void);
+
+#endif // _HOP_H_
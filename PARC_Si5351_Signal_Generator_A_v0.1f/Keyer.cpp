@@ -0,0 +1,345 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to key a Si5351 clock for CW.
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+*/
+
+#include "Arduino.h"
+
+#include <EEPROM.h>
+
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
+#include "VE3OOI_Si5351_v2.1.h"
+#include "i2c.h"
+#include "Timer.h"
+#include "Hop.h"
+#include "Keyer.h"
+
+#ifdef ENABLE_KEYER
+
+// The key state wanted (keyerwant) is set by the pin change ISR, the Timer2 tick or the message sender and
+// KeyerApply() sends it.  A change that can not be sent because a write is in progress or loop() is using the
+// I2C bus is sent on the next tick.  Key to RF latency is measured from the input edge to the end of the write.
+
+// Morse code from ',' to 'Z'. The elements follow the leading 1 bit from the left, 0 is a dit and 1 is a dah
+const unsigned char morsecode[] PROGMEM = {
+  0x73, 0x61, 0x55, 0x32, 0x3F, 0x2F, 0x27, 0x23, 0x21, 0x20, 0x30, 0x38,   // ,-./01234567
+  0x3C, 0x3E, 0x00, 0x00, 0x00, 0x31, 0x00, 0x4C, 0x00, 0x05, 0x18, 0x1A,   // 89:;<=>?@ABC
+  0x0C, 0x02, 0x12, 0x0E, 0x10, 0x04, 0x17, 0x0D, 0x14, 0x07, 0x06, 0x0F,   // DEFGHIJKLMNO
+  0x16, 0x1D, 0x0A, 0x08, 0x03, 0x09, 0x11, 0x0B, 0x19, 0x1B, 0x1C          // PQRSTUVWXYZ
+};
+
+volatile unsigned char keyeractive;
+char keyermode;
+unsigned char keyeroeup, keyeroedown;           // Output enable register with the clock keyed up and down
+unsigned int keyerunit;                         // ms per dit
+
+volatile unsigned char keyerwant, keyerrf, keyersending, keyerfromkey;
+volatile unsigned char keyerpins;               // Debounced inputs, KEYER_DIT_BIT and KEYER_DAH_BIT
+volatile unsigned char keyerlock[2];            // Debounce ms left for the dit and dah inputs
+volatile unsigned char keyerelement, keyerlast, keyerlatch;
+volatile unsigned int keyercount;               // ms left in the element or gap
+volatile unsigned long keyeredge;               // TimerTimestamp() of the input edge not yet sent
+
+// Message being sent
+char keyertext[KEYER_MESSAGE_LEN];
+volatile unsigned char keyermsg, keyerpos, keyercode, keyerbits;
+volatile unsigned long keyerrepeat, keyerrepeatms;
+
+// Statistics in us
+volatile unsigned long keyerwrites, keyerkeyed, keyerlatsum;
+volatile unsigned int keyerlatmax, keyerwritemax;
+
+
+static void KeyerApply (void)
+// Send the wanted key state.  Called from an ISR with interrupts off
+{
+  unsigned long start, t;
+  unsigned char want;
+
+  while (!keyersending && !i2cbusy && keyerwant != keyerrf) {
+    want = keyerwant;
+    keyersending = 1;
+    start = TimerTimestamp();
+    sei();
+    Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, want ? keyeroedown : keyeroeup);
+    cli();
+    t = TimerTimestamp();
+    keyerrf = want;
+
+    keyerwrites++;
+    if ((t - start) * TIMER_TICK_US > keyerwritemax) keyerwritemax = (t - start) * TIMER_TICK_US;
+    if (keyerfromkey) {
+      keyerfromkey = 0;
+      keyerkeyed++;
+      t = (t - keyeredge) * TIMER_TICK_US;
+      keyerlatsum += t;
+      if (t > keyerlatmax) keyerlatmax = t;
+    }
+    keyersending = 0;
+  }
+}
+
+static void KeyerStartElement (unsigned char element)
+{
+  keyerelement = keyerlast = element;
+  keyercount = (element == KEYER_DAH) ? 3 * keyerunit : keyerunit;
+  keyerwant = 1;
+}
+
+static void KeyerNextElement (void)
+// Start the next message or paddle element when the gap after the last element has ended
+{
+  unsigned char c;
+
+  if (keyermsg) {
+    if (!keyerbits) {
+      c = keyertext[keyerpos];
+      if (!c) {
+        keyermsg = 0;
+        return;
+      }
+      keyerpos++;
+      if (c == ' ') {
+        keyercount = 4 * keyerunit;           // 7 units with the gap after the last character
+        return;
+      }
+      if (c < ',' || c > 'Z' || !(keyercode = pgm_read_byte (&morsecode[c - ',']))) return;
+      for (keyerbits=7; !(keyercode & (1 << keyerbits)); keyerbits--);
+    }
+    keyerbits--;
+    KeyerStartElement ((keyercode & (1 << keyerbits)) ? KEYER_DAH : KEYER_DIT);
+    return;
+  }
+
+  if (keyermode == KEYER_STRAIGHT) return;
+
+  // Squeezed paddles alternate elements
+  if (keyerlast == KEYER_DIT && ((keyerlatch | keyerpins) & KEYER_DAH_BIT)) {
+    keyerlatch &= ~KEYER_DAH_BIT;
+    KeyerStartElement (KEYER_DAH);
+  } else if ((keyerlatch | keyerpins) & KEYER_DIT_BIT) {
+    keyerlatch &= ~KEYER_DIT_BIT;
+    KeyerStartElement (KEYER_DIT);
+  } else if ((keyerlatch | keyerpins) & KEYER_DAH_BIT) {
+    keyerlatch &= ~KEYER_DAH_BIT;
+    KeyerStartElement (KEYER_DAH);
+  }
+}
+
+static void KeyerInputs (void)
+// Leading edge debounce. A change is taken at once and the input is then ignored for KEYER_DEBOUNCE_MS
+{
+  unsigned char changed, pressed;
+
+  changed = (~KEYER_PORT & (KEYER_DIT_BIT | KEYER_DAH_BIT)) ^ keyerpins;
+  if (keyerlock[0]) changed &= ~KEYER_DIT_BIT;
+  if (keyerlock[1]) changed &= ~KEYER_DAH_BIT;
+  if (!changed) return;
+
+  keyerpins ^= changed;
+  if (changed & KEYER_DIT_BIT) keyerlock[0] = KEYER_DEBOUNCE_MS;
+  if (changed & KEYER_DAH_BIT) keyerlock[1] = KEYER_DEBOUNCE_MS;
+  pressed = changed & keyerpins;
+
+  // A key press stops a message and the element being sent
+  if (pressed && (keyermsg || keyerrepeat)) {
+    keyermsg = 0;
+    keyerrepeat = 0;
+    keyerbits = 0;
+    keyerelement = KEYER_NONE;
+    keyercount = 0;
+    keyerwant = 0;
+  }
+
+  if (keyermode == KEYER_STRAIGHT) {
+    if (!(changed & KEYER_DIT_BIT)) return;
+    keyerwant = (keyerpins & KEYER_DIT_BIT) ? 1 : 0;
+  } else {
+    keyerlatch |= pressed;
+    if (keyerelement != KEYER_NONE || keyercount) return;
+    KeyerNextElement ();
+    if (keyerelement == KEYER_NONE) return;
+  }
+  keyeredge = TimerTimestamp();
+  keyerfromkey = 1;
+  KeyerApply ();
+}
+
+ISR(PCINT2_vect)
+{
+  if (keyeractive && !keyersending) KeyerInputs ();
+}
+
+unsigned char KeyerStart (char mode, unsigned char wpm, unsigned char clk)
+// Key clk with a straight key or paddles.  The clock should already be set to its frequency.
+// Returns 0 if an argument is not valid or Timer2 is in use
+{
+  unsigned char reg;
+
+  if (mode != KEYER_STRAIGHT && mode != KEYER_IAMBIC_A && mode != KEYER_IAMBIC_B) return 0;
+  if (wpm < KEYER_MIN_WPM || wpm > KEYER_MAX_WPM || clk >= MAXCLK) return 0;
+  if (!ClaimTimer2 (TIMER2_KEYER) || keyeractive) return 0;
+
+  reg = Si5351ReadRegister (SIREG_3_OUTPUT_ENABLE_CTL);
+  keyeroedown = reg & ~(1 << clk);
+  keyeroeup = reg | (1 << clk);
+  Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, keyeroeup);
+
+  keyermode = mode;
+  keyerunit = 1200 / wpm;
+  keyerwant = keyerrf = 0;
+  keyersending = keyerfromkey = 0;
+  keyerelement = keyerlast = KEYER_NONE;
+  keyerlatch = keyerpins = 0;
+  keyerlock[0] = keyerlock[1] = 0;
+  keyercount = 0;
+  keyermsg = 0;
+  keyerrepeat = 0;
+  keyerwrites = keyerkeyed = keyerlatsum = 0;
+  keyerlatmax = keyerwritemax = 0;
+
+  pinMode (KEYER_DIT_PIN, INPUT_PULLUP);
+  pinMode (KEYER_DAH_PIN, INPUT_PULLUP);
+  keyeractive = 1;
+  PCMSK2 |= (1 << PCINT19) | (1 << PCINT20);    // D3 and D4
+  PCICR |= (1 << PCIE2);
+  EnableTimers (2, TIMER2_1MS);
+  return 1;
+}
+
+void KeyerStop (void)
+// The clock is left keyed up
+{
+  if (!keyeractive) return;
+  PCMSK2 &= ~((1 << PCINT19) | (1 << PCINT20));
+  ReleaseTimer2 (TIMER2_KEYER);
+  keyeractive = 0;
+  Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, keyeroeup);
+}
+
+unsigned char KeyerSetMessage (unsigned char index, char *text)
+// Store a message in EEPROM.  Returns 0 if it is too long or has a character that can not be sent
+{
+  unsigned char i, c;
+
+  if (index >= KEYER_MESSAGES || strlen (text) >= KEYER_MESSAGE_LEN) return 0;
+  for (i=0; text[i]; i++) {
+    c = text[i] = toupper (text[i]);
+    if (c != ' ' && (c < ',' || c > 'Z' || !pgm_read_byte (&morsecode[c - ',']))) return 0;
+  }
+  for (i=0; i<=strlen (text); i++) EEPROM.update (KEYER_ADDRESS + index * KEYER_MESSAGE_LEN + i, text[i]);
+  return 1;
+}
+
+static unsigned char KeyerReadMessage (unsigned char index, char *text)
+// Returns the length. A message that was never stored is empty
+{
+  unsigned char i;
+
+  for (i=0; i<KEYER_MESSAGE_LEN - 1; i++) {
+    text[i] = EEPROM.read (KEYER_ADDRESS + index * KEYER_MESSAGE_LEN + i);
+    if (text[i] < ' ' || text[i] > 'Z') break;
+  }
+  text[i] = 0;
+  return i;
+}
+
+void KeyerListMessages (void)
+{
+  char text[KEYER_MESSAGE_LEN];
+  unsigned char i;
+
+  for (i=0; i<KEYER_MESSAGES; i++) {
+    KeyerReadMessage (i, text);
+    Serial.print (i);
+    Serial.print (F(": "));
+    Serial.println (text);
+  }
+}
+
+unsigned char KeyerSend (unsigned char index, unsigned int seconds)
+// Send a message once, or every seconds from the start of one send to the next.  The message being sent is
+// stopped first so an index that is not valid only stops it.  Returns 0 if the keyer is not running or the
+// message is not valid or empty
+{
+  if (!keyeractive) return 0;
+
+  cli();
+  keyermsg = 0;
+  keyerrepeat = 0;
+  keyerbits = 0;
+  sei();
+  if (index >= KEYER_MESSAGES || !KeyerReadMessage (index, keyertext)) return 0;
+
+  cli();
+  keyerpos = keyerbits = 0;
+  keyerrepeat = keyerrepeatms = (unsigned long)seconds * 1000;
+  keyermsg = 1;
+  sei();
+  return 1;
+}
+
+void KeyerTick (void)
+// Called from the Timer2 ISR every 1ms
+{
+  if (!keyeractive || keyersending) return;
+
+  // An input that changed while it was locked is read again once the lock ends
+  if (keyerlock[0] && !--keyerlock[0]) KeyerInputs ();
+  if (keyerlock[1] && !--keyerlock[1]) KeyerInputs ();
+
+  // Timed messages restart when the period ends or when the last send ends after it
+  if (keyerrepeat) {
+    if (keyerrepeatms) keyerrepeatms--;
+    if (!keyerrepeatms && !keyermsg) {
+      keyerpos = keyerbits = 0;
+      keyermsg = 1;
+      keyerrepeatms = keyerrepeat;
+    }
+  }
+
+  // The latch of the opposite paddle is set while an element is sent
+  if (keyerelement == KEYER_DIT) keyerlatch |= keyerpins & KEYER_DAH_BIT;
+  else if (keyerelement == KEYER_DAH) keyerlatch |= keyerpins & KEYER_DIT_BIT;
+
+  if (keyercount && --keyercount) {
+    KeyerApply ();
+    return;
+  }
+
+  if (keyerelement != KEYER_NONE) {
+    // Element sent.  A gap of one element, three after the last element of a message character
+    keyerelement = KEYER_NONE;
+    keyerwant = 0;
+    keyercount = (keyermsg && !keyerbits) ? 3 * keyerunit : keyerunit;
+    if (keyermode == KEYER_IAMBIC_A && !keyerpins) keyerlatch = 0;
+  } else {
+    KeyerNextElement ();
+  }
+  KeyerApply ();
+}
+
+void KeyerReport (void)
+// The maximum keying rate is the number of key changes per second the slowest register write allows
+{
+  Serial.print (keyeractive ? F("Keyer: on") : F("Keyer: off"));
+  Serial.print (F(" WPM: "));
+  Serial.print (keyerunit ? 1200 / keyerunit : 0);
+  Serial.print (F(" Writes: "));
+  Serial.print (keyerwrites);
+  Serial.print (F(" Latency us: "));
+  Serial.print (keyerkeyed ? keyerlatsum / keyerkeyed : 0);
+  Serial.print ('/');
+  Serial.print (keyerlatmax);
+  Serial.print (F(" Write us: "));
+  Serial.print (keyerwritemax);
+  Serial.print (F(" Max rate/s: "));
+  Serial.println (keyerwritemax ? 1000000UL / keyerwritemax : 0);
+}
+
+#endif // ENABLE_KEYER
@@ -0,0 +1,44 @@
+#ifndef _KEYER_H_
+#define _KEYER_H_
+
+// CW keyer.  A clock is keyed only through its bit in the output enable register.  The register values for
+// key up and key down are read once when the keyer starts so each key change is one register write.
+// A straight key or paddle edge is handled in the pin change ISR.  Elements and gaps are timed by the
+// Timer2 1ms tick.  The LCD is still updated but the keyer waits for it if a key change happens during an update
+
+#define KEYER_DIT_PIN       3           // Dit paddle or straight key, closed to ground
+#define KEYER_DAH_PIN       4           // Dah paddle, closed to ground
+#define KEYER_PORT          PIND
+#define KEYER_DIT_BIT       0x08        // PD3
+#define KEYER_DAH_BIT       0x10        // PD4
+#define KEYER_DEBOUNCE_MS   5           // Changes of a key input are ignored for this long after an edge
+
+#define KEYER_MIN_WPM       5
+#define KEYER_MAX_WPM       50
+#define KEYER_DEFAULT_WPM   20
+
+#define KEYER_MESSAGES      2
+#define KEYER_MESSAGE_LEN   32          // Including the terminator
+#define KEYER_ADDRESS       (HOP_ADDRESS + 1 + HOP_ENTRIES * sizeof(Hop_Entry))   // Messages are stored after the hop table
+
+// Modes
+#define KEYER_STRAIGHT      'S'
+#define KEYER_IAMBIC_A      'A'         // Squeeze keying stops with the element being sent
+#define KEYER_IAMBIC_B      'B'         // Squeeze keying sends one more opposite element
+
+// Elements
+#define KEYER_NONE          0
+#define KEYER_DIT           1
+#define KEYER_DAH           2
+
+extern volatile unsigned char keyeractive;
+
+unsigned char KeyerStart (char mode, unsigned char wpm, unsigned char clk);
+void KeyerStop (void);
+unsigned char KeyerSetMessage (unsigned char index, char *text);
+void KeyerListMessages (void);
+unsigned char KeyerSend (unsigned char index, unsigned int seconds);
+void KeyerTick (void);
+void KeyerReport (void);
+
+#endif // _KEYER_H_
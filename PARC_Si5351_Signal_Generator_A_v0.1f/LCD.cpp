@@ -12,36 +12,25 @@
 #include "Arduino.h"
 
 #include <stdint.h>
-#include <Wire.h>  // Comes with Arduino IDE
 
 #include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
 #include "UART.h"                             // VE3OOI Serial Interface Routines (TTY Commands)
 #include "LCD.h"
 #include "Encoder.h"
 #include "Timer.h"
-
-//========================================================
-// LCD Library
-// Can use either LiquidCrystal or HD44780 library.
-// define below selects which library to use
-//========================================================
-#define USE_HD44780     // if this is defined, will use the HD44780 libary
-                        // if commented out, will use LiquidCrystal library
+#include "Profile.h"
+#include "Display.h"
+#include "OLED.h"
+#include "i2c.h"
 
 // LCD geometry
 const int LCD_COLS = 20;
 const int LCD_ROWS = 4;
 
-#ifdef USE_HD44780
-#include <hd44780.h>                        // main hd44780 header
-#include <hd44780ioClass/hd44780_I2Cexp.h>  // i2c expander i/o class header
-hd44780_I2Cexp lcd; // declare lcd object: auto locate & auto config expander chip
+#define LCD_RUN_LENGTH 8        // Most changed characters sent in one go by LCDFlush()
 
-#else
-#include <LiquidCrystal_I2C.h>
-LiquidCrystal_I2C lcd(0x3F, 2, 1, 0, 4, 5, 6, 7, 3, POSITIVE);  // Set the LCD I2C address
-#endif  //USE_HD44780
-//========================================================
+// The display is driven through a backend (see Display.cpp) so the library can be swapped
+LCDBackend *lcd;
 
 
 extern char header1[HEADER1];
@@ -61,130 +50,312 @@ extern volatile int calibration_mult;
 
 // LCD Menu 
 extern volatile unsigned char MenuSelection, ClkSelection;
-extern char RootMenuOptions[MAXMENU_ITEMS][MAXMENU_LEN];
+extern const char RootMenuOptions[MAXMENU_ITEMS][MAXMENU_LEN];
 
 extern Sig_Gen_Struct sg;
 
+// LCD shadow.  lcdshadow[] holds what should be on the display and lcddirty[] has a bit set for each
+// character that changed but has not been sent yet.  Characters are sent by LCDFlush() which loop()
+// calls with a time budget so display updates never hold up input handling or Si5351 updates.
+// lcdcol/lcdrow is where the LCD will put the next character (the LCD address counter).  The cursor
+// and blink state and the selected (blinking) position are tracked so commands are only sent when
+// they change.
+char lcdshadow[LCD_ROWS][LCD_COLS];
+unsigned char lcddirty[(LCD_ROWS*LCD_COLS+7)/8];
+unsigned char lcdpendingcells;
+unsigned char lcdcol, lcdrow;
+unsigned char lcdselcol, lcdselrow;
+unsigned char lcdcursor;
+
+
 void SetupLCD (void)
 {
-/*
-  int status = lcd.begin(LCD_COLS, LCD_ROWS);
-  if(status) // non zero status means it was unsuccesful
-  {
-    status = -status; // convert negative status value to positive number
+  lcd = LCDGetBackend (LCD_DEFAULT_BACKEND);
+  lcd->begin(LCD_COLS, LCD_ROWS);
+  lcd->setCursor(0,0);                        //Goto at position 0 line 0
+  lcd->cursor(0);
+
+  // begin() clears the display
+  memset (lcdshadow, ' ', sizeof(lcdshadow));
+  memset (lcddirty, 0, sizeof(lcddirty));
+  lcdpendingcells = 0;
+  lcdcol = lcdrow = 0;
+  lcdselcol = lcdselrow = 0;
+  lcdcursor = 0;
+}
+
+void LCDPutChar (unsigned char col, unsigned char row, char c)
+// Put a character in the shadow. It is marked to be sent by LCDFlush() only if it changed
+{
+  unsigned char i;
+
+  if (col >= LCD_COLS || row >= LCD_ROWS) return;
+  if (lcdshadow[row][col] == c) return;
+  lcdshadow[row][col] = c;
+
+  i = row * LCD_COLS + col;
+  if (!(lcddirty[i >> 3] & (1 << (i & 7)))) {
+    lcddirty[i >> 3] |= (1 << (i & 7));
+    lcdpendingcells++;
+  }
+}
+
+void LCDFlush (unsigned int budget)
+// Send changed characters to the LCD. Returns once budget us have been used but always sends
+// at least one character. A budget of 0 sends everything
+{
+  unsigned long start;
+  unsigned char i, n, col, row, busy;
+
+  // The I2C bus belongs to the Timer2 ISR while a sweep, hop table or beacon runs. Changes are sent once it stops.
+  // The keyer runs for as long as the operator is sending so it waits for i2cbusy to clear instead.
+  // The counter does not use the I2C bus
+  if (timer2owner != TIMER2_FREE && timer2owner != TIMER2_KEYER && timer2owner != TIMER2_COUNTER) return;
+  busy = i2cbusy;
+  i2cbusy = 1;
+
+  if (!lcdpendingcells) {
+    lcd->update (!budget);
+    i2cbusy = busy;
+    return;
+  }
+  PROFILE_START(t);
+  start = TimerTimestamp();
+
+  // Start at the LCD address counter so a run of changed characters is sent without cursor commands
+  if (lcdcol < LCD_COLS && lcdrow < LCD_ROWS) i = lcdrow * LCD_COLS + lcdcol;
+  else i = 0;
+
+  while (lcdpendingcells) {
+    if (lcddirty[i >> 3] & (1 << (i & 7))) {
+      row = i / LCD_COLS;
+      col = i - row * LCD_COLS;
+      if (col != lcdcol || row != lcdrow) lcd->setCursor(col, row);
+
+      // Collect the changed characters that follow on the same row and send them together
+      n = 0;
+      do {
+        lcddirty[i >> 3] &= ~(1 << (i & 7));
+        lcdpendingcells--;
+        i++;
+        n++;
+      } while (n < LCD_RUN_LENGTH && col + n < LCD_COLS && (lcddirty[i >> 3] & (1 << (i & 7))));
+
+      lcd->write((const unsigned char *)&lcdshadow[row][col], n);
+
+      // The LCD address counter does not follow rows in order so past the last column it is unknown.
+      // LCD_COLS never matches a column so the next write will set the cursor
+      lcdcol = col + n;
+      lcdrow = row;
+
+      if (budget && (TimerTimestamp() - start) * TIMER_TICK_US >= budget) break;
+      if (i >= LCD_ROWS * LCD_COLS) i = 0;
+      continue;
+    }
+    if (++i >= LCD_ROWS * LCD_COLS) i = 0;
+  }
+
+  LCDRestoreCursor ();
+  lcd->update (!budget);
+  i2cbusy = busy;
+  PROFILE_END(PROFILE_LCD_FLUSH, t);
+}
 
-    // begin() failed so blink error code using the onboard LED if possible
-    hd44780::fatalError(status); // does not return
+void LCDRestoreCursor (void)
+// Move the LCD address counter back to the selected position if the cursor is visible.
+// Left until LCDFlush() has sent all changed characters
+{
+  unsigned char busy;
+
+  if (lcdpendingcells) return;
+  if (lcdcursor && (lcdcol != lcdselcol || lcdrow != lcdselrow)) {
+    busy = i2cbusy;
+    i2cbusy = 1;
+    lcd->setCursor(lcdselcol, lcdselrow);
+    i2cbusy = busy;
+    lcdcol = lcdselcol;
+    lcdrow = lcdselrow;
   }
-*/
-  lcd.begin(LCD_COLS, LCD_ROWS);
+}
+
+// Powers of ten used by the number formatter
+const unsigned long decimalpow10[10] PROGMEM = {
+  1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL
+};
+
+unsigned char FormatDecimal (char *buf, unsigned long num, unsigned char width)
+// Write num as exactly width zero padded digits and terminate the string. Replaces sprintf("%0*lu").
+// Each digit is found by subtracting its power of ten (at most 9 times) so there is no 32 bit divide.
+// If num does not fit the high digits are found the same way and dropped so only the low digits are written.
+// Returns the number of characters written
+{
+  unsigned long p;
+  unsigned char i;
+  char d;
 
-  lcd.backlight();
-  lcd.setCursor(0,0);                         //Goto at position 0 line 0
-  lcd.noCursor(); 
-  lcd.noBlink(); 
+  if (width > 10) width = 10;
+  i = (width < 10 && num >= pgm_read_dword(&decimalpow10[width])) ? 10 : width;
+
+  for (; i; i--) {
+    p = pgm_read_dword(&decimalpow10[i-1]);
+    d = '0';
+    while (num >= p) {
+      num -= p;
+      d++;
+    }
+    if (i <= width) *buf++ = d;
+  }
+  *buf = 0;
+  return width;
+}
+
+unsigned char FormatSigned (char *buf, long num, unsigned char width)
+// Same as FormatDecimal() with a leading + or - included in width. Replaces sprintf("%+0*ld")
+{
+  if (num < 0) {
+    *buf = '-';
+    num = -num;
+  } else {
+    *buf = '+';
+  }
+  return FormatDecimal (buf+1, (unsigned long)num, width-1) + 1;
+}
+
+void LCDPrint (unsigned char col, unsigned char row, const char *str)
+{
+  while (*str) LCDPutChar (col++, row, *str++);
+  LCDRestoreCursor ();
+}
+
+void LCDPrintF (unsigned char col, unsigned char row, const __FlashStringHelper *str)
+// Same as LCDPrint() for strings in flash (i.e. F("..."))
+{
+  const char *p = (const char *)str;
+  char c;
+
+  while ((c = pgm_read_byte(p++))) LCDPutChar (col++, row, c);
+  LCDRestoreCursor ();
 }
 
 void LCDDisplayHeader (void) 
 {
   unsigned char i;
+  PROFILE_START(t);
   LCDClearScreen ();
-  lcd.print(header1);
-  lcd.setCursor(0,1);                         //Goto at position 0 line 1
-  lcd.print(header2);
+  LCDPrint (0, 0, header1);
+  LCDPrint (0, 1, header2);
   
-  lcd.setCursor(0, 2);
   for (i=0; i<19; i++) {
-    lcd.print((char)0xFF);
+    LCDPutChar (i, 2, (char)0xFF);
+    LCDFlush (0);
     delay (50);
   }
-  lcd.setCursor(0, 3);
   for (i=0; i<19; i++) {
-    lcd.print((char)0xFF);
+    LCDPutChar (i, 3, (char)0xFF);
+    LCDFlush (0);
     delay (50);
   }
   delay (500);
+  PROFILE_END(PROFILE_LCD_HEADER, t);
 }
 
 void LCDClearScreen (void)
 {
-  lcd.clear();   
-  lcd.noCursor(); 
-  lcd.noBlink(); 
+  unsigned char busy;
+
+  busy = i2cbusy;
+  i2cbusy = 1;
+  lcd->clear();
+  memset (lcdshadow, ' ', sizeof(lcdshadow));
+  memset (lcddirty, 0, sizeof(lcddirty));
+  lcdpendingcells = 0;
+  lcdcol = lcdrow = 0;
+
+  if (lcdcursor) {
+    lcd->cursor(0);
+    lcdcursor = 0;
+  }
+  i2cbusy = busy;
 }
 
 void LCDErrorMsg (unsigned char pos, char *str) 
+// Messages are usually followed by a delay() so everything is sent now
 {
   if ( (pos+strlen(str)) > 19) {
-    lcd.setCursor(pos, 3);                         //Goto at position 0 line 1
-    lcd.print(F("TOO LONG")); 
+    LCDPrintF (pos, 3, F("TOO LONG")); 
     LCDSelectLine (pos, 3, 1);  
+    LCDFlush (0);
     return;
   }
   LCDSelectLine (pos, 3, 1);  
-  lcd.setCursor(pos, 3);                         //Goto at position 0 line 1
-  lcd.print(str);
+  LCDPrint (pos, 3, str);
   LCDSelectLine (pos, 3, 1);  
+  LCDFlush (0);
 }
 
 void LCDClearErrorMsg (unsigned char pos) 
 {
-  lcd.setCursor(pos, 3);                         //Goto at position 0 line 1
-  lcd.print(clearlcderrmsg);
+  LCDPrint (pos, 3, clearlcderrmsg);
   LCDSelectLine (pos, 3, 0);  
 }
 
 
 void LCDSelectLine (unsigned char pos, unsigned char line, unsigned char enable)
 {
-  if (enable) {
-    lcd.setCursor(pos,line);                         //Goto at position 8 line 0
-    lcd.cursor(); 
-    lcd.blink(); 
-  } else {
-    lcd.setCursor(pos,line);                         //Goto at position 0 line 1
-    lcd.noCursor(); 
-    lcd.noBlink(); 
+  unsigned char busy;
+
+  lcdselcol = pos;
+  lcdselrow = line;
+
+  if ((enable && !lcdcursor) || (!enable && lcdcursor)) {
+    busy = i2cbusy;
+    i2cbusy = 1;
+    lcd->cursor(enable);
+    i2cbusy = busy;
   }
+  lcdcursor = enable;
+
+  LCDRestoreCursor ();
 }
 
 void LCDDisplayMenuOption (unsigned char line) 
 {  
-  lcd.setCursor(0, 3);                         //Goto at position 7 line 2
-  lcd.print( RootMenuOptions[line] );
+  PROFILE_START(t);
+  LCDPrintF (0, 3, (const __FlashStringHelper *)RootMenuOptions[line]);
+  PROFILE_END(PROFILE_LCD_MENU, t);
 }
 
 void LCDDisplayClockMode (unsigned char line)
 {
-    lcd.setCursor(12,line);
-      
+    PROFILE_START(t);
     switch (sg.ClkMode[line]) {
       case VFO_CLK_MODE:
-        lcd.print (F("VFO"));
+        LCDPrintF (12, line, F("VFO"));
         break;
         
       case LO_CLK_MODE:
-        lcd.print (F("LO "));
+        LCDPrintF (12, line, F("LO "));
         break;
         
       case IQ_CLK_MODE:
-        lcd.print (F("IQ "));
+        LCDPrintF (12, line, F("IQ "));
         break;
         
 
        
     }  
+    PROFILE_END(PROFILE_LCD_MODE, t);
 }
 
 void LCDDisplayClockStatus (unsigned char line)
 {
-    lcd.setCursor(16,line);
+    PROFILE_START(t);
     if (sg.ClkStatus[line]) {
-        lcd.print (F("ON "));
+        LCDPrintF (16, line, F("ON "));
     } else {
-        lcd.print (F("OFF"));
+        LCDPrintF (16, line, F("OFF"));
     }
-  
+    PROFILE_END(PROFILE_LCD_STATUS, t);
 }
 
 void LCDClearClockWindow (void)
@@ -197,67 +368,93 @@ void LCDClearClockWindow (void)
 
 void LCDDisplayNumber1D (int num, unsigned char pos, unsigned char row)
 {
-    lcd.setCursor(pos, row);
-    memset (clkentry, 0, sizeof(clkentry));         // Terminate the string  
-    sprintf (clkentry, "%d", num);
-    lcd.print( clkentry );
+    PROFILE_START(t);
+    FormatDecimal (clkentry, (unsigned long)num, 1);
+    LCDPrint (pos, row, clkentry);
+    PROFILE_END(PROFILE_LCD_NUM1D, t);
 }
 
 void LCDDisplayNumber3D (int num, unsigned char pos, unsigned char row)
 {
-    lcd.setCursor(pos, row);
-    memset (clkentry, 0, sizeof(clkentry));         // Terminate the string  
-    sprintf (clkentry, "%+04d", num);
-    lcd.print( clkentry );
+    PROFILE_START(t);
+    FormatSigned (clkentry, num, 4);
+    LCDPrint (pos, row, clkentry);
+    PROFILE_END(PROFILE_LCD_NUM3D, t);
 }
 
 
 void LCDDisplayOffsetFrequency (unsigned char line)
 {
-    lcd.setCursor(0,line);
-    memset (clkentry, 0, sizeof(clkentry));         // Terminate the string  
-    sprintf (clkentry, "Offset%u: %+010ld", (unsigned int)line, sg.ClkOffset[line]);
-    lcd.print( clkentry );
+    PROFILE_START(t);
+    // "OffsetN: +000000000"
+    LCDPrintF (0, line, F("Offset"));
+    clkentry[0] = '0' + line;
+    clkentry[1] = ':';
+    clkentry[2] = ' ';
+    FormatSigned (&clkentry[3], sg.ClkOffset[line], 10);
+    LCDPrint (6, line, clkentry);
+    PROFILE_END(PROFILE_LCD_OFFSET, t);
 }
 
 void LCDDisplayClockFrequency (unsigned char line)
 {
-    lcd.setCursor(0,line);
-    memset (clkentry, 0, sizeof(clkentry));         // Terminate the string  
-    sprintf (clkentry, "%u:%09lu", (unsigned int)line, sg.ClkFreq[line]);
-    lcd.print( clkentry );
-
+    PROFILE_START(t);
+    // "N:000000000". Only digits that changed are sent to the LCD
+    clkentry[0] = '0' + line;
+    clkentry[1] = ':';
+    FormatDecimal (&clkentry[2], sg.ClkFreq[line], 9);
+    LCDPrint (0, line, clkentry);
+#ifdef ENABLE_OLED
+    if (line == ClkSelection) OLEDDisplayFrequency (sg.ClkFreq[line]);
+#endif // ENABLE_OLED
+    PROFILE_END(PROFILE_LCD_FREQ, t);
 }
 
 void LCDDisplayIQClockFrequency (unsigned char line)
 {
-    lcd.setCursor(0,line);
-    memset (clkentry, 0, sizeof(clkentry));         // Terminate the string
-    sprintf (clkentry, "%u:%09lu", (unsigned int)line, sg.IQClkFreq[line]);
-    lcd.print( clkentry );
+    PROFILE_START(t);
+    clkentry[0] = '0' + line;
+    clkentry[1] = ':';
+    FormatDecimal (&clkentry[2], sg.IQClkFreq[line], 9);
+    LCDPrint (0, line, clkentry);
+#ifdef ENABLE_OLED
+    if (line == ClkSelection) OLEDDisplayFrequency (sg.IQClkFreq[line]);
+#endif // ENABLE_OLED
+    PROFILE_END(PROFILE_LCD_IQFREQ, t);
 }
 
 void LCDDisplayLOClockFrequency (unsigned char line)
 {
     long fq;
+    PROFILE_START(t);
 //    if (sg.ClkMode[line] == VFO_CLK_MODE) {
 //      LCDDisplayClockFrequency(line);
 //      return;
 //    }
     fq = (long)sg.ClkFreq[line] + sg.ClkOffset[line];
     if (fq < 0) fq = 0;
-    lcd.setCursor(0,line);
-    memset (clkentry, 0, sizeof(clkentry));  
-    sprintf (clkentry, "%u:%09lu", (unsigned int)line, fq);
-    lcd.print( clkentry );
+    clkentry[0] = '0' + line;
+    clkentry[1] = ':';
+    FormatDecimal (&clkentry[2], (unsigned long)fq, 9);
+    LCDPrint (0, line, clkentry);
+#ifdef ENABLE_OLED
+    if (line == ClkSelection) OLEDDisplayFrequency ((unsigned long)fq);
+#endif // ENABLE_OLED
+    PROFILE_END(PROFILE_LCD_LOFREQ, t);
 }
 
 void LCDDisplayClockEntry (unsigned char line) 
 {
-    LCDClearLine(line);
+    PROFILE_START(t);
+    // Blank only the gaps between the fields. Clearing the whole line first would send every character twice
     LCDDisplayClockFrequency(line);
+    LCDPutChar (11, line, ' ');
     LCDDisplayClockMode(line);
+    LCDPutChar (15, line, ' ');
     LCDDisplayClockStatus(line);
+    LCDPutChar (19, line, ' ');
+    LCDRestoreCursor ();
+    PROFILE_END(PROFILE_LCD_ENTRY, t);
 }
 
 void LCDClearLine (unsigned char line) 
@@ -266,6 +463,85 @@ void LCDClearLine (unsigned char line)
 //  memset (clean, 0x20, sizeof(clean));
 //  clean[20] = 0x0;              // terminate the string
 
-  lcd.setCursor(0,line);        // Goto POSITION
-  lcd.print (clearlcdline);      // Clear the line
+  LCDPrint (0, line, clearlcdline);      // Clear the line
+}
+
+
+#ifdef ENABLE_LCD_BENCHMARK
+extern char okmsg[LCD_ERROR_MSG_LENGTH];
+
+void LCDBenchmarkSession (void)
+// Fixed UI session: draw the clock window and menu, tune 100 steps of 10Hz, scroll the menu, show a message
+{
+  unsigned long fq;
+  unsigned char i;
+
+  LCDClearScreen ();
+  for (i=0; i<3; i++) LCDDisplayClockEntry (i);
+  LCDDisplayMenuOption (0);
+  LCDFlush (0);
+
+  fq = sg.ClkFreq[0];
+  LCDSelectLine (10, 0, 1);
+  for (i=0; i<100; i++) {
+    sg.ClkFreq[0] += 10;
+    LCDDisplayClockFrequency (0);
+    LCDFlush (0);
+  }
+  sg.ClkFreq[0] = fq;
+  LCDSelectLine (0, 3, 0);
+
+  for (i=0; i<MAXMENU_ITEMS; i++) {
+    LCDDisplayMenuOption (i);
+    LCDFlush (0);
+  }
+
+  LCDErrorMsg (11, okmsg);
+  LCDClearErrorMsg (11);
+  LCDFlush (0);
+}
+
+void LCDBenchmark (void)
+// Run the same session on every backend compiled in and report the bus bytes and time for each.
+// The display is redrawn from the saved shadow afterwards
+{
+  char saved[LCD_ROWS][LCD_COLS];
+  LCDBackend *active, *b;
+  unsigned long start, t;
+  unsigned char id, col, row, selcol, selrow, cursor;
+
+  active = lcd;
+  LCDFlush (0);
+  memcpy (saved, lcdshadow, sizeof(saved));
+  selcol = lcdselcol;
+  selrow = lcdselrow;
+  cursor = lcdcursor;
+
+  // Columns: backend, bytes sent, time in us
+  for (id=0; id<LCD_BACKENDS; id++) {
+    if (!(b = LCDGetBackend (id))) continue;
+    if (b != active) b->begin (LCD_COLS, LCD_ROWS);
+    lcd = b;
+    lcdcursor = 0;              // begin() leaves the cursor off
+    b->busbytes = 0;
+
+    start = TimerTimestamp();
+    LCDBenchmarkSession ();
+    t = TimerTimestamp() - start;
+
+    Serial.print (LCDBackendName (id));
+    Serial.print (' ');
+    Serial.print (b->busbytes);
+    Serial.print (' ');
+    Serial.println (t * TIMER_TICK_US);
+  }
+
+  lcd = active;
+  LCDClearScreen ();
+  for (row=0; row<LCD_ROWS; row++) {
+    for (col=0; col<LCD_COLS; col++) LCDPutChar (col, row, saved[row][col]);
+  }
+  LCDSelectLine (selcol, selrow, cursor);
+  LCDFlush (0);
 }
+#endif // ENABLE_LCD_BENCHMARK
@@ -11,6 +11,13 @@ void LCDClearClockWindow (void);
 void LCDClearLine (unsigned char line);
 
 void LCDSelectLine (unsigned char pos, unsigned char line, unsigned char enable);
+void LCDPutChar (unsigned char col, unsigned char row, char c);
+void LCDRestoreCursor (void);
+void LCDFlush (unsigned int budget);
+void LCDPrint (unsigned char col, unsigned char row, const char *str);
+void LCDPrintF (unsigned char col, unsigned char row, const __FlashStringHelper *str);
+unsigned char FormatDecimal (char *buf, unsigned long num, unsigned char width);
+unsigned char FormatSigned (char *buf, long num, unsigned char width);
 
 void LCDDisplayFrequency (void);
 void LCDDisplayNumber3D (int num, unsigned char row, unsigned char pos);
@@ -25,4 +32,6 @@ void LCDDisplayClockEntry (unsigned char line);
 void LCDDisplayClockMode (unsigned char line);
 void LCDDisplayClockStatus (unsigned char line);
 
+void LCDBenchmark (void);
+
 #endif // _MyLCD_H_
@@ -0,0 +1,76 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to report Si5351 errors without blocking the tuning path.
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+*/
+
+#include "Arduino.h"
+
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
+#include "LCD.h"
+#include "Log.h"
+
+// Errors are logged as an event code and a value in a ring and printed later from loop().
+// LogEvent() never waits for the UART so a retune takes the same time with or without errors.
+// Events are stored with interrupts held off for a few cycles so they can also be logged from an ISR.
+// Only loop() removes events.  If the ring is full new events are counted and reported as LOG_DROPPED.
+Log_Struct logring[LOG_ENTRIES];
+volatile unsigned char loghead, logtail, logdropped;
+
+
+void LogEvent (unsigned char code, unsigned long value)
+{
+  unsigned char sreg;
+
+  sreg = SREG;
+  cli();
+  if ((unsigned char)(loghead - logtail) >= LOG_ENTRIES) {
+    if (logdropped < 255) logdropped++;
+  } else {
+    logring[loghead & (LOG_ENTRIES - 1)].code = code;
+    logring[loghead & (LOG_ENTRIES - 1)].value = value;
+    loghead++;
+  }
+  SREG = sreg;
+}
+
+void LogDrain (void)
+// Called from loop().  Events are printed as "E<code> <value>" only while the whole line fits in the
+// serial transmit buffer. Without the CLI the code of the latest event is shown on the LCD
+{
+  unsigned char sreg, dropped;
+  Log_Struct *e;
+
+  // Lost events are reported once there is room in the ring
+  if (logdropped && (unsigned char)(loghead - logtail) < LOG_ENTRIES) {
+    sreg = SREG;
+    cli();
+    dropped = logdropped;
+    logdropped = 0;
+    SREG = sreg;
+    LogEvent (LOG_DROPPED, dropped);
+  }
+
+#ifndef REMOVE_CLI
+  while (loghead != logtail && Serial.availableForWrite() >= LOG_LINE_LEN) {
+    e = &logring[logtail & (LOG_ENTRIES - 1)];
+    Serial.print ('E');
+    Serial.print (e->code);
+    Serial.print (' ');
+    Serial.println (e->value);
+    logtail++;
+  }
+#else
+  unsigned char head = loghead;
+
+  if (head != logtail) {
+    e = &logring[(unsigned char)(head - 1) & (LOG_ENTRIES - 1)];
+    LCDPutChar (LOG_LCD_COL, 3, '0' + e->code % 10);
+    logtail = head;
+  }
+#endif // REMOVE_CLI
+}
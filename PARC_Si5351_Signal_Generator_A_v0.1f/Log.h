@@ -0,0 +1,26 @@
+#ifndef _LOG_H_
+#define _LOG_H_
+
+#define LOG_ENTRIES   8           // Size of the event ring. Must be a power of 2
+#define LOG_LINE_LEN  18          // Longest line printed for an event, e.g. "E255 4294967295\r\n"
+#define LOG_LCD_COL   19          // Without the CLI the latest event code is shown here on the menu line
+
+// Event codes and the value logged with them
+#define LOG_MS_DIV      1         // Multisynth divider out of range, divider
+#define LOG_PLL_DIV     2         // PLL feedback divider out of range, divider
+#define LOG_PLL_LOCK    3         // PLL lost lock after programming, Si5351 status
+#define LOG_PHASE       4         // No PLL multiplier for an I/Q frequency, frequency
+#define LOG_I2C_WRITE   5         // Si5351 register write failed, register << 8 | Wire error
+#define LOG_I2C_READ    6         // Si5351 register read failed, register << 8 | Wire error
+#define LOG_DROPPED     7         // Events lost because the ring was full, count
+#define LOG_SYMBOL_TIME 8         // Beacon transmission ended, worst symbol timing error in us
+
+typedef struct {
+  unsigned long value;
+  unsigned char code;
+} Log_Struct;
+
+void LogEvent (unsigned char code, unsigned long value);
+void LogDrain (void);
+
+#endif // _LOG_H_
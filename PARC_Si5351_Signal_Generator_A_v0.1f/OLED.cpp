@@ -0,0 +1,256 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to drive a 128x64 SSD1306/SH1106 OLED.
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+ */
+
+#include "Arduino.h"
+
+#include <stdint.h>
+
+#include "Display.h"
+#include "LCD.h"
+#include "OLED.h"
+
+#ifdef ENABLE_OLED
+
+#include <Wire.h>
+#ifndef ARDUINO
+#include <stdio.h>
+#endif // ARDUINO
+
+// The framebuffer takes half of the RAM so nothing else is buffered.  oleddirty has a bit set for each
+// page that changed since it was last sent.  Host builds also dump each frame sent to a PBM file.
+unsigned char oledfb[OLED_PAGES][OLED_WIDTH];
+unsigned char oleddirty;
+unsigned char oledsendpage, oledsendcol;    // Page being sent and the next column to send
+#ifndef ARDUINO
+unsigned int oledframe;
+#endif // ARDUINO
+
+// 5x7 font for 0x20 to 0x7E. Each byte is a column with bit 0 at the top. Row 7 is left clear
+const unsigned char oledfont[][5] PROGMEM = {
+  {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00}, {0x14, 0x7F, 0x14, 0x7F, 0x14},   // sp ! " #
+  {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62}, {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00},   // $ % & '
+  {0x00, 0x1C, 0x22, 0x41, 0x00}, {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x14, 0x08, 0x3E, 0x08, 0x14}, {0x08, 0x08, 0x3E, 0x08, 0x08},   // ( ) * +
+  {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00}, {0x20, 0x10, 0x08, 0x04, 0x02},   // , - . /
+  {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00}, {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4B, 0x31},   // 0 1 2 3
+  {0x18, 0x14, 0x12, 0x7F, 0x10}, {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},   // 4 5 6 7
+  {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x36, 0x36, 0x00, 0x00}, {0x00, 0x56, 0x36, 0x00, 0x00},   // 8 9 : ;
+  {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14}, {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06},   // < = > ?
+  {0x32, 0x49, 0x79, 0x41, 0x3E}, {0x7E, 0x11, 0x11, 0x11, 0x7E}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},   // @ A B C
+  {0x7F, 0x41, 0x41, 0x22, 0x1C}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x01, 0x01}, {0x3E, 0x41, 0x41, 0x51, 0x32},   // D E F G
+  {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00}, {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41},   // H I J K
+  {0x7F, 0x40, 0x40, 0x40, 0x40}, {0x7F, 0x02, 0x04, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},   // L M N O
+  {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46}, {0x46, 0x49, 0x49, 0x49, 0x31},   // P Q R S
+  {0x01, 0x01, 0x7F, 0x01, 0x01}, {0x3F, 0x40, 0x40, 0x40, 0x3F}, {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x7F, 0x20, 0x18, 0x20, 0x7F},   // T U V W
+  {0x63, 0x14, 0x08, 0x14, 0x63}, {0x03, 0x04, 0x78, 0x04, 0x03}, {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x00},   // X Y Z [
+  {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7F, 0x00}, {0x04, 0x02, 0x01, 0x02, 0x04}, {0x40, 0x40, 0x40, 0x40, 0x40},   // \ ] ^ _
+  {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78}, {0x7F, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20},   // ` a b c
+  {0x38, 0x44, 0x44, 0x48, 0x7F}, {0x38, 0x54, 0x54, 0x54, 0x18}, {0x08, 0x7E, 0x09, 0x01, 0x02}, {0x08, 0x14, 0x54, 0x54, 0x3C},   // d e f g
+  {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x44, 0x3D, 0x00}, {0x00, 0x7F, 0x10, 0x28, 0x44},   // h i j k
+  {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x18, 0x04, 0x78}, {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38},   // l m n o
+  {0x7C, 0x14, 0x14, 0x14, 0x08}, {0x08, 0x14, 0x14, 0x18, 0x7C}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20},   // p q r s
+  {0x04, 0x3F, 0x44, 0x40, 0x20}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C}, {0x3C, 0x40, 0x30, 0x40, 0x3C},   // t u v w
+  {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0C, 0x50, 0x50, 0x50, 0x3C}, {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00},   // x y z {
+  {0x00, 0x00, 0x7F, 0x00, 0x00}, {0x00, 0x41, 0x36, 0x08, 0x00}, {0x02, 0x01, 0x02, 0x04, 0x02}                                    // | } ~
+};
+
+// Page addressing mode, 128x64, charge pump on. The SH1106 has no addressing mode command
+// and uses a DC-DC control command instead of the charge pump
+const unsigned char oledinit[] PROGMEM = {
+#ifdef OLED_SH1106
+  0xAE, 0xD5, 0x80, 0xA8, 0x3F, 0xD3, 0x00, 0x40, 0xAD, 0x8B, 0xA1, 0xC8,
+  0xDA, 0x12, 0x81, 0x80, 0xD9, 0x22, 0xDB, 0x35, 0xA4, 0xA6, 0xAF
+#else
+  0xAE, 0xD5, 0x80, 0xA8, 0x3F, 0xD3, 0x00, 0x40, 0x8D, 0x14, 0x20, 0x02, 0xA1, 0xC8,
+  0xDA, 0x12, 0x81, 0xCF, 0xD9, 0xF1, 0xDB, 0x40, 0xA4, 0xA6, 0xAF
+#endif // OLED_SH1106
+};
+
+
+void OLEDInit (void)
+{
+  unsigned char i;
+
+  Wire.begin();
+  Wire.beginTransmission(OLED_ADDRESS);
+  Wire.write((uint8_t)0x00);                 // Commands follow
+  for (i=0; i<sizeof(oledinit); i++) Wire.write(pgm_read_byte(&oledinit[i]));
+  Wire.endTransmission();
+
+  OLEDClear ();
+}
+
+void OLEDClearPages (unsigned char page, unsigned char pages)
+{
+  for (; pages && page < OLED_PAGES; page++, pages--) {
+    memset (oledfb[page], 0, OLED_WIDTH);
+    oleddirty |= (1 << page);
+  }
+}
+
+void OLEDClear (void)
+{
+  OLEDClearPages (0, OLED_PAGES);
+}
+
+unsigned char OLEDFontColumn (char c, unsigned char col)
+// Column of a character. 0xFF is the LCD full block used by the splash, other codes are blank
+{
+  if ((unsigned char)c == 0xFF) return 0x7F;
+  if (c < 0x20 || c > 0x7E) return 0;
+  return pgm_read_byte(&oledfont[c - 0x20][col]);
+}
+
+void OLEDDrawChar (unsigned char x, unsigned char page, char c)
+// 5x7 character with its gap column. Row 7 (the underline) is kept
+{
+  unsigned char i, *p;
+
+  if (page >= OLED_PAGES || x > OLED_WIDTH - OLED_CHAR_PITCH) return;
+  p = &oledfb[page][x];
+  for (i=0; i<OLED_CHAR_PITCH-1; i++) p[i] = (p[i] & 0x80) | OLEDFontColumn (c, i);
+  p[i] &= 0x80;
+  oleddirty |= (1 << page);
+}
+
+void OLEDDrawBigChar (unsigned char x, unsigned char page, char c)
+// Double size character over two pages. Each font bit becomes 2x2 pixels
+{
+  unsigned char i, j, col;
+  unsigned int big;
+
+  if (page + 1 >= OLED_PAGES || x > OLED_WIDTH - OLED_BIG_PITCH) return;
+  for (i=0; i<OLED_BIG_PITCH; i+=2) {
+    col = (i < 10) ? OLEDFontColumn (c, i >> 1) : 0;
+    big = 0;
+    for (j=0; j<8; j++) {
+      if (col & (1 << j)) big |= (3U << (j << 1));
+    }
+    oledfb[page][x+i] = oledfb[page][x+i+1] = (unsigned char)big;
+    oledfb[page+1][x+i] = oledfb[page+1][x+i+1] = (unsigned char)(big >> 8);
+  }
+  oleddirty |= (3 << page);
+}
+
+void OLEDUnderline (unsigned char x, unsigned char page, unsigned char on)
+// Cursor. Row 7 under a character
+{
+  unsigned char i;
+
+  if (page >= OLED_PAGES || x > OLED_WIDTH - OLED_CHAR_PITCH) return;
+  for (i=0; i<OLED_CHAR_PITCH-1; i++) {
+    if (on) oledfb[page][x+i] |= 0x80;
+    else oledfb[page][x+i] &= ~0x80;
+  }
+  oleddirty |= (1 << page);
+}
+
+void OLEDDisplayFrequency (unsigned long freq)
+// Frequency in MHz with double size digits ("  7.100000"). Leading zeros are blanked
+{
+  char digits[OLED_FREQ_DIGITS+1];
+  unsigned char i, x;
+
+  FormatDecimal (&digits[1], freq, OLED_FREQ_DIGITS-1);
+  digits[0] = digits[1];
+  digits[1] = digits[2];
+  digits[2] = digits[3];
+  digits[3] = '.';
+  for (i=0; i<2 && digits[i] == '0'; i++) digits[i] = ' ';
+
+  x = (OLED_WIDTH - OLED_FREQ_DIGITS * OLED_BIG_PITCH) / 2;
+  for (i=0; i<OLED_FREQ_DIGITS; i++, x += OLED_BIG_PITCH) OLEDDrawBigChar (x, OLED_FREQ_PAGE, digits[i]);
+}
+
+void OLEDPlot (unsigned char x, unsigned char width, unsigned char level)
+// Bar in width columns of the plot area from column x. A level of 255 fills the area
+{
+  unsigned char i, k, top, col;
+  unsigned char *p;
+
+  // Pixel row (from the top of the area) where the bar starts
+  top = OLED_PLOT_PAGES * 8 - (((unsigned int)level * (OLED_PLOT_PAGES * 8)) >> 8);
+
+  for (k=0; k<OLED_PLOT_PAGES; k++) {
+    if (top <= (k << 3)) col = 0xFF;
+    else if (top >= (k << 3) + 8) col = 0;
+    else col = 0xFF << (top - (k << 3));
+
+    p = &oledfb[OLED_PLOT_PAGE + k][x];
+    for (i=0; i<width && x+i<OLED_WIDTH; i++) p[i] = col;
+  }
+  oleddirty |= (((1 << OLED_PLOT_PAGES) - 1) << OLED_PLOT_PAGE);
+}
+
+#ifndef ARDUINO
+void OLEDDumpFrame (void)
+// Host build. Write the framebuffer as it is on the display. P1 is plain text so frames can be diffed
+{
+  char name[16];
+  FILE *fp;
+  unsigned char x, y;
+
+  snprintf (name, sizeof(name), OLED_PBM_NAME, oledframe++);
+  if (!(fp = fopen (name, "w"))) return;
+  fprintf (fp, "P1\n%u %u\n", OLED_WIDTH, OLED_PAGES * 8);
+  for (y=0; y<OLED_PAGES * 8; y++) {
+    for (x=0; x<OLED_WIDTH; x++) fputc ((oledfb[y >> 3][x] & (1 << (y & 7))) ? '1' : '0', fp);
+    fputc ('\n', fp);
+  }
+  fclose (fp);
+}
+#endif // ARDUINO
+
+unsigned int OLEDSendPages (unsigned char all)
+// Send one transaction of changed pages, or everything that changed if all is set. Returns the bytes
+// put on the bus. A page is 128 data bytes sent in transactions of up to BUFFER_LENGTH-1 bytes after
+// the data control byte so each call takes about 3ms at 100kHz
+{
+  unsigned char page;
+  unsigned int bytes = 0;
+  unsigned char n, i;
+
+  if (!oleddirty && !oledsendcol) return 0;
+
+  do {
+    if (!oledsendcol) {
+      // Start the next changed page. It is marked dirty again if it changes while being sent
+      for (page=0; !(oleddirty & (1 << page)); page++);
+      oleddirty &= ~(1 << page);
+      oledsendpage = page;
+
+      Wire.beginTransmission(OLED_ADDRESS);
+      Wire.write((uint8_t)0x00);             // Commands follow
+      Wire.write(0xB0 | page);
+      Wire.write((uint8_t)(OLED_COLUMN_OFFSET & 0xF));
+      Wire.write(0x10 | (OLED_COLUMN_OFFSET >> 4));
+      Wire.endTransmission();
+      bytes += 5;
+    }
+
+    n = OLED_WIDTH - oledsendcol;
+    if (n > BUFFER_LENGTH - 1) n = BUFFER_LENGTH - 1;
+    Wire.beginTransmission(OLED_ADDRESS);
+    Wire.write(0x40);                         // Data follows
+    for (i=0; i<n; i++) Wire.write(oledfb[oledsendpage][oledsendcol+i]);
+    Wire.endTransmission();
+    bytes += n + 2;
+
+    oledsendcol += n;
+    if (oledsendcol >= OLED_WIDTH) oledsendcol = 0;
+  } while (all && (oleddirty || oledsendcol));
+
+#ifndef ARDUINO
+  if (!oleddirty && !oledsendcol) OLEDDumpFrame ();
+#endif // ARDUINO
+
+  return bytes;
+}
+
+#endif // ENABLE_OLED
@@ -0,0 +1,42 @@
+#ifndef _OLED_H_
+#define _OLED_H_
+
+// SSD1306/SH1106 128x64 I2C OLED.  The display is drawn in a 1KB framebuffer (8 pages of 128 columns,
+// one byte is 8 vertical pixels with bit 0 at the top).  Only pages that changed are sent.
+//
+// Layout: the 20x4 LCD text is on pages 0 to 3 (5x7 font, row 7 of each page is the cursor underline),
+// the frequency being tuned is shown with double size digits on pages 4 and 5 and pages 6 and 7 are a
+// plot area for the levels measured by the analyzer.
+
+#define OLED_ADDRESS        0x3C
+#define OLED_WIDTH          128
+#define OLED_PAGES          8
+
+#define OLED_CHAR_PITCH     6           // 5x7 font plus one column gap
+#define OLED_BIG_PITCH      12          // Double size font
+#define OLED_TEXT_X         4           // 20 LCD columns are centered
+#define OLED_TEXT_PAGES     4           // LCD rows are pages 0 to 3
+#define OLED_FREQ_PAGE      4           // Big frequency digits use pages 4 and 5
+#define OLED_PLOT_PAGE      6           // Plot area uses pages 6 and 7
+#define OLED_PLOT_PAGES     2
+#define OLED_FREQ_DIGITS    10          // "MMM.HHHHHH"
+
+#ifdef OLED_SH1106
+#define OLED_COLUMN_OFFSET  2           // SH1106 has 132 columns of RAM, the panel starts at column 2
+#else
+#define OLED_COLUMN_OFFSET  0
+#endif // OLED_SH1106
+
+#define OLED_PBM_NAME       "oled%04u.pbm"    // Host builds dump a PBM file for each frame sent
+
+void OLEDInit (void);
+void OLEDClear (void);
+void OLEDClearPages (unsigned char page, unsigned char pages);
+void OLEDDrawChar (unsigned char x, unsigned char page, char c);
+void OLEDDrawBigChar (unsigned char x, unsigned char page, char c);
+void OLEDUnderline (unsigned char x, unsigned char page, unsigned char on);
+void OLEDDisplayFrequency (unsigned long freq);
+void OLEDPlot (unsigned char x, unsigned char width, unsigned char level);
+unsigned int OLEDSendPages (unsigned char all);
+
+#endif // _OLED_H_
@@ -21,21 +21,27 @@
 #include "Encoder.h"
 #include "Timer.h"
 #include "VE3OOI_Si5351_v2.1.h"
+#include "Trace.h"
+#include "Profile.h"
+#include "Protocol.h"
+#include "Log.h"
+#include "Sweep.h"
+#include "Hop.h"
+#include "Beacon.h"
+#include "Keyer.h"
+#include "Analyzer.h"
+#include "Counter.h"
+#include "Calibrate.h"
+#include "Track.h"
 
 
-#ifndef REMOVE_CLI
 #include "UART.h"                             // VE3OOI Serial Interface Routines (TTY Commands)
 
-// These variables are defined in UART.cpp and used for Serial interface
-// rbuff is used to store all keystrokes which is parsed by Execute()
-// commands[] and numbers[] store all characters or numbers entered provided they
-// are separated by spaces.
+#ifndef REMOVE_CLI
+// These variables are used in UART.cpp for Serial interface
+// rbuff is used to store all keystrokes which are parsed in place by ExecuteSerial()
 // ctr is counter used to process entries
-// command_entries contains the total number of charaters/numbers entered
 char rbuff[RBUFF];
-char commands[MAX_COMMAND_ENTRIES];
-unsigned char command_entries;
-unsigned long numbers[MAX_COMMAND_ENTRIES];
 unsigned char ctr;
 #endif // REMOVE_CLI
 
@@ -56,7 +62,7 @@ volatile int rotaryInc;
 // LCD Menu
 volatile unsigned char MenuSelection, ClkSelection;
 
-char RootMenuOptions[MAXMENU_ITEMS][MAXMENU_LEN] = {
+const char RootMenuOptions[MAXMENU_ITEMS][MAXMENU_LEN] PROGMEM = {
   {"VFO ENABLE"},
   {"MIX ENABLE"},
   {"I/Q ENABLE"},
@@ -65,7 +71,13 @@ char RootMenuOptions[MAXMENU_ITEMS][MAXMENU_LEN] = {
   {"SAVE      "},
   {"RECALL    "},
   {"CLI ENABLE"},
-  {"RESET     "}
+  {"RESET     "},
+#ifdef ENABLE_SWEEP
+  {"SWEEP     "},
+#endif // ENABLE_SWEEP
+#ifdef ENABLE_COUNTER
+  {"COUNTER   "},
+#endif // ENABLE_COUNTER
 };
 
 char header1[HEADER1] = {'P', 'A', 'R', 'C', ' ', 'S', 'I', 'G', ' ', 'G', 'E', 'N', ' ', 'A', '0', '.', '1', 'F', ' ', 0x0};
@@ -73,6 +85,10 @@ char header2[HEADER2] = {' ', '(', 'C', ')', 'V', 'E', '3', 'O', 'O', 'I', 0x0};
 
 char clkentry [CLKENTRYLEN];
 
+#ifdef ENABLE_COUNTER
+unsigned int countermenugate = COUNTER_DEFAULT_GATE;    // ms
+#endif // ENABLE_COUNTER
+
 char prompt[6] = {0xa, 0xd, ':', '>', ' ', 0x0};
 char ovflmsg[9] = {'O', 'v', 'e', 'r', 'f', 'l', 'o', 'w', 0x0};
 char errmsg[4] = {'E', 'r', 'r', 0x0};
@@ -82,16 +98,37 @@ char clearlcderrmsg[LCD_ERROR_MSG_LENGTH];
 
 char okmsg[LCD_ERROR_MSG_LENGTH];
 
+// Frequency display refresh. The Si5351 is retuned on every detent but the display is redrawn
+// from loop() no faster than LCD_REFRESH_MS. A pending refresh is always drawn once input stops.
+unsigned char lcdpending;
+unsigned long lcdrefresh;
+
 // Specific Sig Gen parameters
 Sig_Gen_Struct sg;
-Sig_Gen_Struct mem[MAX_MEMORIES];
+
+#ifdef ENABLE_FAST_BOOT
+// Fast boot. bootmenu is what FastBoot() restored at power up: the clock window whose outputs are
+// running (VFO_ENABLE, LO_ENABLE or IQ_ENABLE), BOOT_NO_OUTPUTS or BOOT_NO_RECORD.  outputsmenu is the
+// clock window the outputs were last turned on from.  sg and outputsmenu are autosaved to the boot
+// record once they have not changed for AUTOSAVE_MEMORY_MS.  A checksum is used to notice changes.
+unsigned char bootmenu = BOOT_NO_RECORD;
+unsigned char outputsmenu = BOOT_NO_OUTPUTS;
+unsigned int autosavesum, bootsavedsum;
+unsigned long autosavepoll, autosavetime;
+unsigned long bootrfus;
+#endif // ENABLE_FAST_BOOT
 
 
 
 // the setup function runs once when you press reset or power the board
 void setup() {
   // define the baud rate for TTY communications. Note CR and LF must be sent by terminal program
-  Serial.begin(9600);
+  Serial.begin(SERIAL_BAUD);
+
+#ifdef ENABLE_FAST_BOOT
+  // Outputs first. Everything else is set up once the Si5351 is running
+  FastBoot ();
+#endif // ENABLE_FAST_BOOT
 
   SetupLCD ();
   
@@ -101,16 +138,37 @@ void setup() {
 
   Reset ();
 
-  if (sg.correction > 1000 || sg.correction < -1000) {
+  if (sg.correction > MAXIMUM_CORRECTION || sg.correction < -MAXIMUM_CORRECTION) {
     sg.correction = 0;
   }
   
+#ifdef ENABLE_FAST_BOOT
+  // Already set up if FastBoot() restored the outputs. Later Reset()s start with the outputs off
+  if (bootmenu >= BOOT_NO_OUTPUTS) setupSi5351(sg.correction);
+  bootmenu = BOOT_NO_RECORD;
+#else
   setupSi5351(sg.correction);
+#endif // ENABLE_FAST_BOOT
 
   SetupEncoder();
 
+#ifndef ENABLE_FAST_BOOT
   MenuSelection = 0;
   ClkSelection = 0;
+#else
+  // Reset() has set these. MenuSelection is the restored clock window after a fast boot
+
+  // Time to first RF (0 if no outputs were restored) and to the end of setup(). micros() starts
+  // with the sketch so the bootloader and power up delays are not included
+  Serial.print (F("RF us: "));
+  Serial.print (bootrfus);
+  Serial.print (F(" Ready us: "));
+  Serial.println (micros());
+#endif // ENABLE_FAST_BOOT
+
+#ifdef ENABLE_PROFILER
+  ProfileReset();
+#endif // ENABLE_PROFILER
 }
 
 
@@ -120,15 +178,27 @@ void setup() {
 // the loop function runs over and over again forever
 void loop()
 {
+  PROFILE_START(loopstart);
 
 #ifndef REMOVE_CLI
   // Look for characters entered from the keyboard and process them
   // This function is part of the UART package.
   if (flags & CLI_MODE) {
+    PROFILE_START(serialstart);
     ProcessSerial ();
+    PROFILE_END(PROFILE_SERIAL, serialstart);
   }
 #endif // REMOVE_CLI
 
+#ifdef ENABLE_BINARY_PROTOCOL
+  // Binary frames are accepted in every mode
+  ProtocolPoll();
+#endif // ENABLE_BINARY_PROTOCOL
+
+#ifdef ENABLE_INPUT_TRACE
+  TraceReplayPoll();
+#endif // ENABLE_INPUT_TRACE
+
   if (flags & MASTER_RESET) {
     Reset();
   }
@@ -157,38 +227,68 @@ void loop()
 
     } else if (flags & MEMORY_RECALL_MODE) {
       GetRotaryNumber (0, (int)(MAX_MEMORIES-1), 1, 11, 3);
+
+#ifdef ENABLE_SWEEP
+    } else if (flags & SWEEP_MODE) {
+      MenuSweepMode();
+#endif // ENABLE_SWEEP
+
+#ifdef ENABLE_COUNTER
+    } else if (flags & COUNTER_MODE) {
+      MenuCounterMode();
+#endif // ENABLE_COUNTER
     }
+
+    RefreshFrequencyDisplay (0);
+
+#ifdef ENABLE_FAST_BOOT
+    AutosaveBoot ();
+#endif // ENABLE_FAST_BOOT
     
   } else {
-    flags &= ~ROTARY_CW;
-    flags &= ~ROTARY_CCW;
+    GetRotaryCount();               // Discard any detents
     flags &= ~PBUTTON1_PUSHED;
     flags &= ~PBUTTON2_PUSHED;
     digitalWrite(LED_BUILTIN, LOW);
   }
 
-
+#ifdef ENABLE_SWEEP
+  // Compute the next sweep steps ahead of the Timer2 deadlines
+  SweepPoll ();
+#endif // ENABLE_SWEEP
+#ifdef ENABLE_HOP
+  HopPoll ();
+#endif // ENABLE_HOP
+#ifdef ENABLE_BEACON
+  BeaconPoll ();
+#endif // ENABLE_BEACON
+#ifdef ENABLE_ANALYZER
+  AnalyzerPoll ();
+#endif // ENABLE_ANALYZER
+
+  // Report logged errors without waiting for the UART
+  LogDrain ();
+
+  // Send a slice of any pending LCD changes
+  LCDFlush (LCD_FLUSH_BUDGET_US);
+
+  PROFILE_END(PROFILE_LOOP, loopstart);
 }
 
 
 void GetRotaryNumber (int lnum, int hnum, int maxinc, unsigned char x, unsigned char y)
 {
   unsigned char pos;
+  long temp;
+  Sig_Gen_Struct m;
   pos = FrequencyDigitUpdate(rotaryInc) + ROTARY_NUMBER_OFFSET;
 
-  if (flags & ROTARY_CW) {
-    rotaryNumber += rotaryInc;
-    if (rotaryNumber > hnum) rotaryNumber = hnum; 
-
-  } else if (flags & ROTARY_CCW) {
-    rotaryNumber -= rotaryInc;
-    if (rotaryNumber < lnum) rotaryNumber = lnum;     
-  }
-  
-
   if ( (flags & ROTARY_CW) || (flags & ROTARY_CCW) ) {
-    flags &= ~ROTARY_CW;
-    flags &= ~ROTARY_CCW;
+    // Apply all detents queued since the last update in one step
+    temp = (long)rotaryNumber + (long)GetRotaryCount() * (long)rotaryInc;
+    if (temp > hnum) temp = hnum; 
+    if (temp < lnum) temp = lnum;     
+    rotaryNumber = (int)temp;
 
     if (flags & MEMORY_RECALL_MODE || flags & MEMORY_SAVE_MODE) {
       LCDDisplayNumber1D (rotaryNumber, x, y);
@@ -197,10 +297,9 @@ void GetRotaryNumber (int lnum, int hnum, int maxinc, unsigned char x, unsigned
     } else if (flags & CALIBRATION_MODE) {
       LCDDisplayNumber3D (rotaryNumber, x, y);
       LCDSelectLine (pos, y, 1);
-      setupSi5351 (rotaryNumber);
-      UpdateFrequency (0);
-      UpdateFrequency (1);
-      UpdateFrequency (2);
+      // Only the PLL registers change so the outputs stay on while the PLLs are reset
+      SetSi5351Correction ((long)rotaryNumber * CORRECTION_ROTARY_PPB);
+      TuneFrequencies (SI_ENABLE_CLK0 | SI_ENABLE_CLK1 | SI_ENABLE_CLK2);
     }
     digitalWrite(LED_BUILTIN, LOW);
 
@@ -219,10 +318,7 @@ void GetRotaryNumber (int lnum, int hnum, int maxinc, unsigned char x, unsigned
   if (flags & PBUTTON1_PUSHED) {
     if (flags & MEMORY_SAVE_MODE) {
       flags |= DISABLE_BUTTONS;
-      // mem[0] is autoupdated ever few seconds
-      memcpy ((char *)&mem[rotaryNumber], (char *)&sg, sizeof(sg));
-      SetMemClkStatus (0, rotaryNumber);
-      EEPROM.put(0, mem);
+      MemSave (rotaryNumber);
       flags &= ~DISABLE_BUTTONS; 
       LCDErrorMsg(11, okmsg);
       delay (3000);
@@ -231,11 +327,8 @@ void GetRotaryNumber (int lnum, int hnum, int maxinc, unsigned char x, unsigned
 
     } else if (flags & MEMORY_RECALL_MODE) {
       flags |= DISABLE_BUTTONS;
-      memset ((char *)&mem, 0, sizeof (mem));
-      EEPROM.get(0, mem);
-      if (mem[rotaryNumber].flags == (MEM_ID | VERSION)) {
-        memset ((char *)&sg, 0, sizeof (sg));
-        memcpy ((char *)&sg, (char *)&mem[rotaryNumber], sizeof(sg));
+      if (MemRecall (rotaryNumber, &m)) {
+        memcpy ((char *)&sg, (char *)&m, sizeof(sg));
         LCDErrorMsg(11, okmsg);
         delay (3000);
         LCDClearErrorMsg(10);
@@ -248,10 +341,10 @@ void GetRotaryNumber (int lnum, int hnum, int maxinc, unsigned char x, unsigned
       flags &= ~MEMORY_RECALL_MODE;
       
     } else if (flags & CALIBRATION_MODE) {
-      sg.correction = rotaryNumber;
-      memcpy ((char *)&mem[0], (char *)&sg, sizeof(sg));
-      SetMemClkStatus (0, 0);
-      EEPROM.put(0, mem);
+      // A correction from the CLI that is not a whole number of steps is kept unless it was changed
+      if (rotaryNumber != (int)(sg.correction / CORRECTION_ROTARY_PPB)) sg.correction = (long)rotaryNumber * CORRECTION_ROTARY_PPB;
+      SetSi5351Correction (sg.correction);
+      MemSave (0);
       LCDErrorMsg(11, okmsg);
       delay (3000);
       LCDClearErrorMsg(11);
@@ -286,26 +379,25 @@ void MenuClockFrequencyMode (void)
 {
   long temp;
   unsigned char pos;
+#ifdef ENABLE_LATENCY_STATS
+  unsigned long detent;
+#endif // ENABLE_LATENCY_STATS
   pos = FrequencyDigitUpdate(frequency_inc) + FREQUENCY_DISPLAY_SHIFT;
 
-  if (flags & ROTARY_CW) {
-    sg.ClkFreq[ClkSelection] += frequency_inc;
-    if (sg.ClkFreq[ClkSelection] > HighFrequencyLimit(ClkSelection)) {
-      sg.ClkFreq[ClkSelection] = HighFrequencyLimit(ClkSelection);
-      pos = FrequencyDigitUpdate(frequency_inc) + FREQUENCY_DISPLAY_SHIFT;
-      LCDSelectLine (pos, ClkSelection, 1);
-    }
+  if ( (flags & ROTARY_CW) || (flags & ROTARY_CCW) ) {
+#ifdef ENABLE_LATENCY_STATS
+    detent = LatencyStart();
+#endif // ENABLE_LATENCY_STATS
 
-  } else if (flags & ROTARY_CCW) {
-    temp = (long)sg.ClkFreq[ClkSelection] - (long)frequency_inc;
-    if (temp < (long)LowFrequencyLimit(ClkSelection) || temp < 0) {
-      sg.ClkFreq[ClkSelection] = LowFrequencyLimit(ClkSelection);
-      pos = FrequencyDigitUpdate(frequency_inc) + FREQUENCY_DISPLAY_SHIFT;
-      LCDSelectLine (pos, ClkSelection, 1);
+    // Apply all detents queued since the last update so there is only one retune
+    temp = (long)sg.ClkFreq[ClkSelection] + (long)GetRotaryCount() * (long)frequency_inc;
+    if (temp > (long)HighFrequencyLimit(ClkSelection)) {
+      temp = HighFrequencyLimit(ClkSelection);
 
-    } else {
-      sg.ClkFreq[ClkSelection] -= frequency_inc;
+    } else if (temp < (long)LowFrequencyLimit(ClkSelection)) {
+      temp = LowFrequencyLimit(ClkSelection);
     }
+    sg.ClkFreq[ClkSelection] = (unsigned long)temp;
 
     if (flags & LO_FREQUENCY_MODE) {
       temp = (long)sg.ClkFreq[ClkSelection] + sg.ClkOffset[ClkSelection];
@@ -313,20 +405,13 @@ void MenuClockFrequencyMode (void)
         sg.ClkFreq[ClkSelection] = (unsigned long)absl(sg.ClkOffset[ClkSelection]) + LowFrequencyLimit(ClkSelection);
       }
     }
-  }
-
-  if ( (flags & ROTARY_CW) || (flags & ROTARY_CCW) ) {
-    flags &= ~ROTARY_CW;
-    flags &= ~ROTARY_CCW;
 
-    if (flags & LO_FREQUENCY_MODE ) {
-      LCDDisplayLOClockFrequency (ClkSelection); 
-    } else  {
-      LCDDisplayClockFrequency  (ClkSelection);  
-    }
-    
+    // Synthesizer first, display later from loop()
     UpdateFrequency (ClkSelection);
-    LCDSelectLine (pos, ClkSelection, 1);
+#ifdef ENABLE_LATENCY_STATS
+    LatencyRecord (detent);
+#endif // ENABLE_LATENCY_STATS
+    lcdpending |= LCD_PENDING_CLK;
     digitalWrite(LED_BUILTIN, LOW);
   }
 
@@ -339,6 +424,7 @@ void MenuClockFrequencyMode (void)
   }
 
   if (flags & PBUTTON1_PUSHED) {
+    RefreshFrequencyDisplay (1);
     if (sg.ClkStatus[ClkSelection]) {
       sg.ClkStatus[ClkSelection] = 0;
       LCDDisplayClockStatus(ClkSelection);
@@ -356,6 +442,7 @@ void MenuClockFrequencyMode (void)
   }
 
   if (flags & PBUTTON2_PUSHED) {
+    RefreshFrequencyDisplay (1);
     flags |= CLOCK_WINDOW_MODE;
     flags &= ~CLOCK_FREQUENCY_MODE;
     LCDSelectLine(0, ClkSelection, 1);
@@ -369,40 +456,36 @@ void MenuIQClockFrequencyMode (void)
 {
   long temp;
   unsigned char pos;
+#ifdef ENABLE_LATENCY_STATS
+  unsigned long detent;
+#endif // ENABLE_LATENCY_STATS
   pos = FrequencyDigitUpdate(frequency_inc) + FREQUENCY_DISPLAY_SHIFT;
 
-  if (flags & ROTARY_CW) {
-    sg.IQClkFreq[ClkSelection] += frequency_inc;
-    if (sg.IQClkFreq[ClkSelection] > HighFrequencyLimit(ClkSelection)) {
-      sg.IQClkFreq[ClkSelection] = HighFrequencyLimit(ClkSelection);
-      pos = FrequencyDigitUpdate(frequency_inc) + FREQUENCY_DISPLAY_SHIFT;
-      LCDSelectLine (pos, ClkSelection, 1);
-    }
+  if ( (flags & ROTARY_CW) || (flags & ROTARY_CCW) ) {
+#ifdef ENABLE_LATENCY_STATS
+    detent = LatencyStart();
+#endif // ENABLE_LATENCY_STATS
 
-  } else if (flags & ROTARY_CCW) {
-    temp = (long)sg.IQClkFreq[ClkSelection] - (long)frequency_inc;
-    if (temp < (long)LowFrequencyLimit(ClkSelection) || temp < 0) {
-      sg.IQClkFreq[ClkSelection] = LowFrequencyLimit(ClkSelection);
-      pos = FrequencyDigitUpdate(frequency_inc) + FREQUENCY_DISPLAY_SHIFT;
-      LCDSelectLine (pos, ClkSelection, 1);
+    // Apply all detents queued since the last update so there is only one retune
+    temp = (long)sg.IQClkFreq[ClkSelection] + (long)GetRotaryCount() * (long)frequency_inc;
+    if (temp > (long)HighFrequencyLimit(ClkSelection)) {
+      temp = HighFrequencyLimit(ClkSelection);
 
-    } else {
-      sg.IQClkFreq[ClkSelection] -= frequency_inc;
+    } else if (temp < (long)LowFrequencyLimit(ClkSelection)) {
+      temp = LowFrequencyLimit(ClkSelection);
     }
+    sg.IQClkFreq[ClkSelection] = (unsigned long)temp;
 
-  }
-
-  if ( (flags & ROTARY_CW) || (flags & ROTARY_CCW) ) {
-    flags &= ~ROTARY_CW;
-    flags &= ~ROTARY_CCW;
     sg.IQClkFreq[0] = sg.IQClkFreq[ClkSelection]; 
     sg.IQClkFreq[1] = 0; 
     sg.IQClkFreq[2] = sg.IQClkFreq[ClkSelection]; 
-    LCDDisplayIQClockFrequency (0);
-    LCDDisplayIQClockFrequency (1);
-    LCDDisplayIQClockFrequency (2);
+
+    // Synthesizer first, display later from loop()
     UpdateIQFrequency (ClkSelection);
-    LCDSelectLine (pos, ClkSelection, 1);
+#ifdef ENABLE_LATENCY_STATS
+    LatencyRecord (detent);
+#endif // ENABLE_LATENCY_STATS
+    lcdpending |= LCD_PENDING_IQ;
     digitalWrite(LED_BUILTIN, LOW);
   }
 
@@ -415,6 +498,7 @@ void MenuIQClockFrequencyMode (void)
   }
 
   if (flags & PBUTTON1_PUSHED) {
+    RefreshFrequencyDisplay (1);
     if (!ClkSelection) ClkSelection = 2;
     else ClkSelection = 0;
     LCDSelectLine(pos, ClkSelection, 1);
@@ -423,6 +507,7 @@ void MenuIQClockFrequencyMode (void)
   }
 
   if (flags & PBUTTON2_PUSHED) {
+    RefreshFrequencyDisplay (1);
     ClearFlags();
     flags |= MENU_MODE;
     LCDSelectLine(0, 3, 1);
@@ -441,29 +526,17 @@ void MenuClockFrequencyOffsetMode (void)
   pos = FrequencyDigitUpdate(offset_inc);
   pos += OFFSET_DISPLAY_SHIFT;
 
-  if (flags & ROTARY_CW) {
-    sg.ClkOffset[ClkSelection] += offset_inc;
-    if (sg.ClkOffset[ClkSelection] > MAXIMUM_OFFSET_FREQUENCY) {
-      sg.ClkOffset[ClkSelection] = MAXIMUM_OFFSET_FREQUENCY;
-    }
-
-  } else if (flags & ROTARY_CCW) {
-    temp = sg.ClkOffset[ClkSelection] - offset_inc;
-    if (temp <  (-MAXIMUM_OFFSET_FREQUENCY) ) {
-      sg.ClkOffset[ClkSelection] = (-MAXIMUM_OFFSET_FREQUENCY);
-
-      // This may be redundant but keep it for future
-    } else if (sg.ClkOffset[ClkSelection] > 1000000 && temp < 1000000) {
-      sg.ClkOffset[ClkSelection] -= offset_inc;
+  if ( (flags & ROTARY_CW) || (flags & ROTARY_CCW) ) {
+    // Apply all detents queued since the last update in one step
+    temp = sg.ClkOffset[ClkSelection] + (long)GetRotaryCount() * offset_inc;
+    if (temp > MAXIMUM_OFFSET_FREQUENCY) {
+      temp = MAXIMUM_OFFSET_FREQUENCY;
 
-    } else {
-      sg.ClkOffset[ClkSelection] -= offset_inc;
+    } else if (temp <  (-MAXIMUM_OFFSET_FREQUENCY) ) {
+      temp = (-MAXIMUM_OFFSET_FREQUENCY);
     }
-  }
+    sg.ClkOffset[ClkSelection] = temp;
 
-  if ( (flags & ROTARY_CW) || (flags & ROTARY_CCW) ) {
-    flags &= ~ROTARY_CW;
-    flags &= ~ROTARY_CCW;
     LCDDisplayOffsetFrequency (ClkSelection);
     pos = FrequencyDigitUpdate(offset_inc);
     pos += OFFSET_DISPLAY_SHIFT;
@@ -503,18 +576,13 @@ void MenuClockFrequencyOffsetMode (void)
 void MenuClockWindowMode ()
 {
   unsigned char pos;
-
-  if (flags & ROTARY_CW) {
-    if (++ClkSelection >= MAXCLK) ClkSelection = 0;
-
-  } else if (flags & ROTARY_CCW) {
-    if (!ClkSelection) ClkSelection = MAXCLK - 1;
-    else ClkSelection--;
-  }
+  int steps;
 
   if ( (flags & ROTARY_CW) || (flags & ROTARY_CCW) ) {
-    flags &= ~ROTARY_CW;
-    flags &= ~ROTARY_CCW;
+    // Move by the net number of detents, wrapping around
+    steps = GetRotaryCount() % MAXCLK;
+    if (steps < 0) steps += MAXCLK;
+    ClkSelection = (ClkSelection + steps) % MAXCLK;
     LCDSelectLine(0, ClkSelection, 1);
     digitalWrite(LED_BUILTIN, LOW);
   }
@@ -539,8 +607,7 @@ void MenuClockWindowMode ()
         LCDDisplayClockEntry(0);
         LCDDisplayClockEntry(2);
       }
-      UpdateFrequency (0);
-      UpdateFrequency (2);      
+      UpdateFrequencies (SI_ENABLE_CLK0 | SI_ENABLE_CLK2);
       LCDSelectLine(0, ClkSelection, 1);
     }
 #endif // ENABLE_SWAP_VFO
@@ -584,23 +651,13 @@ void MenuClockWindowMode ()
 
 void MenuDisplayMode ()
 {
-  if (flags & ROTARY_CW) {
-    MenuSelection++;
-    if (MenuSelection >= MAXMENU_ITEMS) {
-      MenuSelection = 0;
-    }
-
-  } else if (flags & ROTARY_CCW) {
-    if (MenuSelection) {
-      MenuSelection--;
-    } else {
-      MenuSelection = MAXMENU_ITEMS - 1;
-    }
-  }
+  int steps;
 
   if ( (flags & ROTARY_CW) || (flags & ROTARY_CCW) ) {
-    flags &= ~ROTARY_CW;
-    flags &= ~ROTARY_CCW;
+    // Move by the net number of detents, wrapping around
+    steps = GetRotaryCount() % MAXMENU_ITEMS;
+    if (steps < 0) steps += MAXMENU_ITEMS;
+    MenuSelection = (MenuSelection + steps) % MAXMENU_ITEMS;
     LCDDisplayMenuOption (MenuSelection);
     LCDSelectLine(0, 3, 1);
     digitalWrite(LED_BUILTIN, LOW);
@@ -630,6 +687,12 @@ void DoMenu(void)
 {
   unsigned char pos;
 
+#ifdef ENABLE_FAST_BOOT
+  // Every option starts by resetting the Si5351. Only the clock windows turn outputs back on
+  if (MenuSelection == VFO_ENABLE || MenuSelection == LO_ENABLE || MenuSelection == IQ_ENABLE) outputsmenu = MenuSelection;
+  else outputsmenu = BOOT_NO_OUTPUTS;
+#endif // ENABLE_FAST_BOOT
+
   switch (MenuSelection) {
     case VFO_ENABLE:
       ResetSi5351();
@@ -719,7 +782,6 @@ void DoMenu(void)
 
     case SET_OFFSET:
       ResetSi5351();
-      SetMemClkStatus (0, 0);
       
       ClearFlags();
       flags |= OFFSET_FREQUENCY_MODE;
@@ -737,7 +799,6 @@ void DoMenu(void)
 
     case CALIBRATE:
       ResetSi5351();
-      SetMemClkStatus (1, 0);
       sg.ClkMode[0] = VFO_CLK_MODE;
       sg.ClkMode[1] = VFO_CLK_MODE;
       sg.ClkMode[2] = VFO_CLK_MODE;
@@ -753,11 +814,9 @@ void DoMenu(void)
       LCDDisplayClockEntry(1);
       LCDDisplayClockEntry(2);
 
-      UpdateFrequency (0);
-      UpdateFrequency (1);
-      UpdateFrequency (2);      
+      UpdateFrequencies (SI_ENABLE_CLK0 | SI_ENABLE_CLK1 | SI_ENABLE_CLK2);
 
-      rotaryNumber = sg.correction;
+      rotaryNumber = (int)(sg.correction / CORRECTION_ROTARY_PPB);
       rotaryInc = 10;
       LCDDisplayNumber3D (rotaryNumber, 11, 3);
       pos = FrequencyDigitUpdate(rotaryInc) + ROTARY_NUMBER_OFFSET;
@@ -767,7 +826,6 @@ void DoMenu(void)
 
     case SAVE:
       ResetSi5351();
-      SetMemClkStatus (0, 0);
       RefreshLCD();
       
       ClearFlags();
@@ -781,7 +839,6 @@ void DoMenu(void)
 
     case RECALL:
       ResetSi5351();
-      SetMemClkStatus (0, 0);
       RefreshLCD();
       
       ClearFlags();
@@ -817,11 +874,124 @@ void DoMenu(void)
       Reset();
       return;
       break;
+
+#ifdef ENABLE_SWEEP
+    case SWEEP:
+      // The LCD is not updated while the sweep runs so everything is sent before it starts
+      ResetSi5351();
+      ClearFlags();
+      flags |= SWEEP_MODE;
+
+      LCDClearClockWindow();
+      LCDPrintF (0, 0, F("SWEEP CLK0"));
+      LCDPrintF (0, 1, F("FROM"));
+      pos = FormatDecimal (clkentry, sweepcfg.start, 10);
+      clkentry[pos] = 0;
+      LCDPrint (5, 1, clkentry);
+      LCDPrintF (0, 2, F("TO"));
+      pos = FormatDecimal (clkentry, sweepcfg.stop, 10);
+      clkentry[pos] = 0;
+      LCDPrint (5, 2, clkentry);
+      LCDPrintF (11, 3, F("RUN"));
+      LCDSelectLine (11, 3, 0);
+      LCDFlush (0);
+
+      SweepStart (SI_CLK0);
+      break;
+#endif // ENABLE_SWEEP
+
+#ifdef ENABLE_COUNTER
+    case COUNTER:
+      ClearFlags();
+      flags |= COUNTER_MODE;
+
+      LCDClearClockWindow();
+      LCDPrintF (0, 0, F("COUNTER D5"));
+      LCDPrintF (0, 1, F("GATE"));
+      pos = FormatDecimal (clkentry, countermenugate, 5);
+      clkentry[pos] = 0;
+      LCDPrint (5, 1, clkentry);
+      LCDPrintF (10, 1, F("ms"));
+      LCDPrintF (11, 3, F("RUN"));
+      LCDSelectLine (11, 3, 0);
+
+      CounterStart (countermenugate);
+      break;
+#endif // ENABLE_COUNTER
   }
 
 
 }
 
+#ifdef ENABLE_SWEEP
+void MenuSweepMode (void)
+// A button stops the sweep.  The steps per second achieved are shown once it has stopped
+{
+  unsigned char pos;
+
+  GetRotaryCount();               // Discard any detents
+
+  if (flags & (ROTARY_PUSH | PBUTTON1_PUSHED | PBUTTON2_PUSHED)) {
+    flags &= ~(ROTARY_PUSH | PBUTTON1_PUSHED | PBUTTON2_PUSHED);
+    digitalWrite(LED_BUILTIN, LOW);
+    SweepStop ();
+  }
+  if (sweepactive) return;
+
+  pos = FormatDecimal (clkentry, SweepRate(), 5);
+  clkentry[pos] = 0;
+  LCDPrint (11, 3, clkentry);
+  LCDPrintF (16, 3, F("/s"));
+
+  ClearFlags();
+  flags |= MENU_MODE;
+  LCDSelectLine(0, 3, 1);
+}
+#endif // ENABLE_SWEEP
+
+#ifdef ENABLE_COUNTER
+void MenuCounterMode (void)
+// The rotary changes the gate by 10x steps.  A button stops the counter
+{
+  uint64_t mhz;
+  int steps;
+  unsigned char pos;
+
+  steps = GetRotaryCount();
+  if (steps) {
+    while (steps > 0 && countermenugate < COUNTER_MAX_GATE) {
+      countermenugate *= 10;
+      steps--;
+    }
+    while (steps < 0 && countermenugate > COUNTER_MIN_GATE) {
+      countermenugate /= 10;
+      steps++;
+    }
+    pos = FormatDecimal (clkentry, countermenugate, 5);
+    clkentry[pos] = 0;
+    LCDPrint (5, 1, clkentry);
+    CounterStop ();
+    CounterStart (countermenugate);
+  }
+
+  if (flags & (ROTARY_PUSH | PBUTTON1_PUSHED | PBUTTON2_PUSHED)) {
+    flags &= ~(ROTARY_PUSH | PBUTTON1_PUSHED | PBUTTON2_PUSHED);
+    digitalWrite(LED_BUILTIN, LOW);
+    CounterStop ();
+    ClearFlags();
+    flags |= MENU_MODE;
+    LCDSelectLine(0, 3, 1);
+    return;
+  }
+
+  if (CounterRead (&mhz)) {
+    CounterFormat (clkentry, mhz);
+    LCDPrint (0, 2, clkentry);
+    LCDPrintF (13, 2, F("Hz"));
+  }
+}
+#endif // ENABLE_COUNTER
+
 void ClearFlags ()
 {
   flags &= ~MENU_MODE;
@@ -834,6 +1004,8 @@ void ClearFlags ()
   flags &= ~MEMORY_SAVE_MODE;
   flags &= ~MEMORY_RECALL_MODE;
   flags &= ~CLI_MODE;
+  flags &= ~SWEEP_MODE;
+  flags &= ~COUNTER_MODE;
 //  flags &= ~MASTER_RESET;       // This should never be cleared.
   
 }
@@ -934,20 +1106,48 @@ void UpdateIQFrequency (unsigned char line)
   
 }
 
-void SetMemClkStatus (unsigned char stat, unsigned char index) 
+void MemSave (unsigned char index)
+// Memories are only kept in EEPROM. They are always saved with the outputs off
 {
-    mem[index].ClkStatus[0] = mem[index].ClkStatus[1] = mem[index].ClkStatus[2] = stat;
+  Sig_Gen_Struct m;
+
+  memcpy ((char *)&m, (char *)&sg, sizeof(m));
+  m.ClkStatus[0] = m.ClkStatus[1] = m.ClkStatus[2] = 0;
+  EEPROM.put(MEM_ADDRESS(index), m);
 }
 
+unsigned char MemRecall (unsigned char index, Sig_Gen_Struct *m)
+// Returns 1 if the memory is valid
+{
+  EEPROM.get(MEM_ADDRESS(index), *m);
+  return (m->flags == (MEM_ID | VERSION));
+}
 
-void UpdateFrequency (unsigned char line)
+
+unsigned long OutputFrequency (unsigned char line)
 {
   unsigned long freq;
 
   freq = sg.ClkFreq[line];
 
+  // In LO mode the output is the frequency shown, which includes the offset
+  if (sg.ClkMode[line] == LO_CLK_MODE) freq = (unsigned long)((long)freq + sg.ClkOffset[line]);
+
   if (freq < LowFrequencyLimit(line)) freq = LowFrequencyLimit(line);
   if (freq > HighFrequencyLimit(line)) freq = HighFrequencyLimit(line);
+  return freq;
+}
+
+void UpdateFrequency (unsigned char line)
+{
+  unsigned long freq;
+
+  freq = OutputFrequency (line);
+
+#ifdef ENABLE_TRACKING
+  // Clocks following this one are retuned with it
+  if (TrackUpdate (line, freq)) return;
+#endif // ENABLE_TRACKING
   
   switch (line) {
     case 0:
@@ -967,6 +1167,34 @@ void UpdateFrequency (unsigned char line)
 
 }
 
+void StageFrequencies (unsigned char mask)
+// Stage the clocks in mask (SI_ENABLE_CLKx bits) at their output frequencies
+{
+  unsigned char line;
+
+  for (line=0; line<MAXCLK; line++) {
+    if (!(mask & (1 << line))) continue;
+    Si5351StageFrequency (line, (line == 1) ? SI_PLL_B : SI_PLL_A, OutputFrequency (line));   // PLLs as UpdateFrequency()
+#ifdef ENABLE_TRACKING
+    TrackStage (line, OutputFrequency (line));
+#endif // ENABLE_TRACKING
+  }
+}
+
+void UpdateFrequencies (unsigned char mask)
+// Set the clocks in mask so they go live together with one PLL reset.  Clocks on the same PLL start in phase
+{
+  StageFrequencies (mask);
+  Si5351CommitSync ();
+}
+
+void TuneFrequencies (unsigned char mask)
+// Retune the running clocks in mask without turning their outputs off.  Only changed registers are sent
+{
+  StageFrequencies (mask);
+  Si5351Commit ();
+}
+
 void EnableFrequency (unsigned char line)
 {
   UpdateFrequency(line);
@@ -989,6 +1217,43 @@ void DisableFrequency (unsigned char line)
   }
 }
 
+void RefreshFrequencyDisplay (unsigned char force)
+// Redraw frequencies changed by the rotary. Unless forced it is rate limited to LCD_REFRESH_MS
+{
+  unsigned char pos;
+
+  if (!lcdpending) return;
+  if (!force && (millis() - lcdrefresh) < LCD_REFRESH_MS) return;
+  lcdrefresh = millis();
+
+  if (lcdpending & LCD_PENDING_IQ) {
+    LCDDisplayIQClockFrequency (0);
+    LCDDisplayIQClockFrequency (1);
+    LCDDisplayIQClockFrequency (2);
+
+  } else if (flags & LO_FREQUENCY_MODE) {
+    LCDDisplayLOClockFrequency (ClkSelection); 
+
+  } else {
+    LCDDisplayClockFrequency  (ClkSelection);  
+  }
+
+#ifdef ENABLE_TRACKING
+  // Clocks that followed the one being tuned
+  for (pos=0; pos<MAXCLK && !(lcdpending & LCD_PENDING_IQ); pos++) {
+    if (!(trackchanged & (1 << pos))) continue;
+    if (flags & LO_FREQUENCY_MODE) LCDDisplayLOClockFrequency (pos);
+    else LCDDisplayClockFrequency (pos);
+  }
+  trackchanged = 0;
+#endif // ENABLE_TRACKING
+  lcdpending = 0;
+
+  // Put the cursor back on the digit being tuned
+  pos = FrequencyDigitUpdate(frequency_inc) + FREQUENCY_DISPLAY_SHIFT;
+  LCDSelectLine (pos, ClkSelection, 1);
+}
+
 void RefreshLCD (void)
 {
   LCDClearScreen();
@@ -1003,6 +1268,14 @@ void RefreshLCD (void)
 
 void Reset (void)
 {
+  unsigned char restore;
+
+#ifdef ENABLE_FAST_BOOT
+  // At power up sg may come from the boot record and the outputs may already be running
+  restore = bootmenu;
+#else
+  restore = BOOT_NO_RECORD;
+#endif // ENABLE_FAST_BOOT
   
 #ifndef REMOVE_CLI
   ResetSerial();
@@ -1012,7 +1285,26 @@ void Reset (void)
   Serial.flush();
 #endif // REMOVE_CLI
 
-  ResetSi5351();
+#ifdef ENABLE_SWEEP
+  SweepStop ();
+#endif // ENABLE_SWEEP
+#ifdef ENABLE_HOP
+  HopStop ();
+#endif // ENABLE_HOP
+#ifdef ENABLE_BEACON
+  BeaconStop ();
+#endif // ENABLE_BEACON
+#ifdef ENABLE_KEYER
+  KeyerStop ();
+#endif // ENABLE_KEYER
+#ifdef ENABLE_ANALYZER
+  AnalyzerStop ();
+#endif // ENABLE_ANALYZER
+#ifdef ENABLE_COUNTER
+  CounterStop ();
+#endif // ENABLE_COUNTER
+
+  if (restore >= BOOT_NO_OUTPUTS) ResetSi5351();
 
   frequency_clk = DEFAULT_FREQUENCY;
   frequency_inc = DEFAULT_FREQUENCY_INCREMENT;
@@ -1029,27 +1321,23 @@ void Reset (void)
   okmsg[1] = 'K';
 
   // Read sg from EEPROM
-  memset ((char *)&sg, 0, sizeof (sg));
-  memset ((char *)&mem, 0, sizeof (mem));
-  EEPROM.get(0, mem);
-  memcpy ((char *)&sg, (char *)&mem[0], sizeof(sg));
+  if (restore == BOOT_NO_RECORD) EEPROM.get(MEM_ADDRESS(0), sg);
 
   if (sg.flags != (MEM_ID | VERSION)) {
     sg.flags = (MEM_ID | VERSION);
     sg.ClkFreq[0] = 1000000;
     sg.ClkFreq[1] = 1000000;
     sg.ClkFreq[2] = 1000000;
-    sg.IQClkFreq[0] = 3000000;
+    sg.IQClkFreq[0] = SI_MIN_IQ_OUT_FREQ;
     sg.IQClkFreq[1] = 0;
-    sg.IQClkFreq[2] = 3000000;
+    sg.IQClkFreq[2] = SI_MIN_IQ_OUT_FREQ;
     sg.ClkOffset[0] = 0;
     sg.ClkOffset[1] = 0;
     sg.ClkOffset[2] = 0;
     sg.ClkMode[0] = sg.ClkMode[1] = sg.ClkMode[2] = VFO_CLK_MODE;
     sg.ClkStatus[0] = sg.ClkStatus[1] = sg.ClkStatus[2] = 0;
     sg.correction = 0;
-    memcpy ((char *)&mem[0], (char *)&sg, sizeof(sg));
-    EEPROM.put(0, mem);
+    MemSave (0);
   }
 
   rotaryNumber = 0;
@@ -1058,15 +1346,118 @@ void Reset (void)
   ResetEncoder();
 
   // LCD Menu
+#ifndef ENABLE_FAST_BOOT
   LCDDisplayHeader();
+#endif // ENABLE_FAST_BOOT
 
   MenuSelection = 0;
   ClkSelection = 0;
+  lcdpending = 0;
 
+#ifdef ENABLE_FAST_BOOT
+  if (restore < BOOT_NO_OUTPUTS) BootDisplay (restore);
+  else
+#endif // ENABLE_FAST_BOOT
   RefreshLCD();
 
   flags = MENU_MODE;
+
+#ifdef ENABLE_FAST_BOOT
+  outputsmenu = (restore >= BOOT_NO_OUTPUTS) ? BOOT_NO_OUTPUTS : restore;
+#endif // ENABLE_FAST_BOOT
+
+#ifdef ENABLE_INPUT_TRACE
+  // Start a new recording unless this Reset() is the start of a replay
+  if (!TRACE_REPLAYING) TraceReset();
+#endif // ENABLE_INPUT_TRACE
+}
+
+#ifdef ENABLE_FAST_BOOT
+void FastBoot (void)
+// Called first in setup(). Loads sg from the boot record and turns the outputs that were on back on
+// before the LCD, encoder and timers are set up. Reset() then draws the restored window
+{
+  unsigned char i, mask = 0;
+
+  bootmenu = BOOT_NO_RECORD;
+  EEPROM.get (BOOT_RECORD_ADDRESS, sg);
+  outputsmenu = EEPROM.read (BOOT_MENU_ADDRESS);
+  bootsavedsum = BootChecksum ();           // Already in EEPROM so it is not written again
+  if (sg.flags != (MEM_ID | VERSION)) return;
+
+  bootmenu = BOOT_NO_OUTPUTS;
+  if (outputsmenu != VFO_ENABLE && outputsmenu != LO_ENABLE && outputsmenu != IQ_ENABLE) return;
+  if (!sg.ClkStatus[0] && !sg.ClkStatus[1] && !sg.ClkStatus[2]) return;
+  if (sg.correction > MAXIMUM_CORRECTION || sg.correction < -MAXIMUM_CORRECTION) sg.correction = 0;
+
+  setupSi5351 (sg.correction);
+  if (outputsmenu == IQ_ENABLE) {
+    UpdateIQFrequency (0);
+  } else {
+    for (i=0; i<MAXCLK; i++) {
+      if (sg.ClkStatus[i]) mask |= 1 << i;
+    }
+    UpdateFrequencies (mask);
+  }
+  bootrfus = micros();
+  bootmenu = outputsmenu;
+}
+
+void BootDisplay (unsigned char menu)
+// Draw the clock window restored by FastBoot(). It is left in the menu (as after PBUTTON2) so the
+// outputs keep running until an option is selected
+{
+  unsigned char i;
+
+  LCDClearScreen ();
+  for (i=0; i<MAXCLK; i++) {
+    if (menu == IQ_ENABLE) LCDDisplayIQClockFrequency (i);
+    else if (menu == LO_ENABLE) LCDDisplayLOClockFrequency (i);
+    else LCDDisplayClockFrequency (i);
+    LCDDisplayClockMode (i);
+    LCDDisplayClockStatus (i);
+  }
+  MenuSelection = menu;
+  LCDDisplayMenuOption (MenuSelection);
+  LCDSelectLine (0, 3, 1);
+}
+
+unsigned int BootChecksum (void)
+// Rotate and add over sg and outputsmenu. Only used to notice changes
+{
+  unsigned char *p;
+  unsigned char i;
+  unsigned int sum;
+
+  p = (unsigned char *)&sg;
+  sum = outputsmenu;
+  for (i=0; i<sizeof(sg); i++) sum = ((sum << 1) | (sum >> 15)) + p[i];
+  return sum;
+}
+
+void AutosaveBoot (void)
+// Called from loop(). Writes the boot record once sg and outputsmenu have been unchanged for
+// AUTOSAVE_MEMORY_MS so tuning does not wear the EEPROM. EEPROM.put() only writes bytes that changed
+{
+  unsigned int sum;
+
+  if (flags & CALIBRATION_MODE) return;       // All outputs are on while calibrating
+  if ((millis() - autosavepoll) < AUTOSAVE_POLL_MS) return;
+  autosavepoll = millis();
+
+  sum = BootChecksum ();
+  if (sum != autosavesum) {
+    autosavesum = sum;
+    autosavetime = autosavepoll;
+    return;
+  }
+  if (sum == bootsavedsum || (autosavepoll - autosavetime) < AUTOSAVE_MEMORY_MS) return;
+
+  EEPROM.put (BOOT_RECORD_ADDRESS, sg);
+  EEPROM.update (BOOT_MENU_ADDRESS, outputsmenu);
+  bootsavedsum = sum;
 }
+#endif // ENABLE_FAST_BOOT
 
 long absl (long v)
 {
@@ -1079,170 +1470,522 @@ long absl (long v)
 #ifndef REMOVE_CLI
 
 // Place program specific content here
-void ExecuteSerial (char *str)
+// Note: Whenever a parameter is stated as [CLK] the square brackets are not entered. The square brackets means
+// that this is a command line parameter entered after the command.
+// E.g. F [CLK] [FREQ] would be mean "F 0 7000000" is entered (no square brackets entered)
+// Frequencies can have up to 3 decimals, e.g. "F 0 7000000.5"
+
+#ifdef ENABLE_LCD_BENCHMARK
+// Display backend benchmark. Syntax: B
+void CLIBenchmark (CLIArg *arg, unsigned char n)
 {
-  // num defined the actual number of entries process from the serial buffer
-  // i is a generic counter
-  unsigned char num;
-  unsigned char clk, phase;
-
-  // This function called when serial input in present in the serial buffer
-  // The serial buffer is parsed and characters and numbers are scraped and entered
-  // in the commands[] and numbers[] variables.
-  num = ParseSerial (str);
-
-  // Process the commands
-  // Note: Whenever a parameter is stated as [CLK] the square brackets are not entered. The square brackets means
-  // that this is a command line parameter entered after the command.
-  // E.g. F [CLK] [FREQ] would be mean "F 0 7000000" is entered (no square brackets entered)
-  switch (commands[0]) {
-
-    // Calibrate the Si5351.
-    // Syntax: C [CAL] [FREQ], where CAL is the new Calibration value and FREQ is the frequency to output
-    // Syntax: C , If no parameters specified, it will display current calibration value
-    // Bascially you can set the initial CAL to 100 and check fequency accurate. Adjust up/down as needed
-    // numbers[0] will contain the correction, numbers[1] will be the frequency in Hz
-    case 'C':             // Calibrate
-      // First, Check inputs to validate
-      if (numbers[0] == 0UL && numbers[1] == 0UL) {
-        Serial.print (F("Correction: "));
-        Serial.println (sg.correction);
-        break;
-        
-      } else if (numbers[0] > 500) {
-        Serial.println (F("Bad Cal"));
-        break;
-        
-      } else if (numbers[1] < SI_MIN_OUT_FREQ || numbers[1] > SI_MAX_OUT_FREQ) {
-        Serial.println (F("Bad Freq"));
-        break;
-      }
+  LCDBenchmark();
+}
+#endif // ENABLE_LCD_BENCHMARK
 
-      // New value defined so read the old values and display what will be done
-      Serial.print (F("Old Correction: "));
-      Serial.println (sg.correction);
-      Serial.print ("New Correction: ");
-      
-      // Store the new value entered    
-      if (commands[1] == '-') sg.correction = - (int)numbers[0];
-      
-      else sg.correction = (int)numbers[0];
-      Serial.println (sg.correction);
-
-      // Reset the Si5351 and then display frequency based on new setting     
-      setupSi5351(sg.correction);
-      memcpy ((char *)&mem[0], (char *)&sg, sizeof(sg));
-      EEPROM.put(0, mem);
-      SetFrequency (SI_CLK0, SI_PLL_A, numbers[1]);
-      SetFrequency (SI_CLK1, SI_PLL_A, numbers[1]);
-      SetFrequency (SI_CLK2, SI_PLL_A, numbers[1]);
-      break;
+// Calibrate the Si5351.
+// Syntax: C [CAL] [FREQ], where CAL is the new Calibration value in ppb and FREQ is the frequency to output
+// Syntax: C , If no parameters specified, it will display current calibration value
+// Bascially you can set the initial CAL to 10000 (10ppm) and check fequency accurate. Adjust up/down as needed
+void CLICalibrate (CLIArg *arg, unsigned char n)
+{
+  unsigned long freq = CLIHz (&arg[1]);
 
-    case 'F':             // Set Frequency
-      // Validate inputs
-      if (numbers [0] > 2UL) {
-        Serial.println (F("Bad Clk"));
-        break;
-      }
+  // First, Check inputs to validate
+  if (!n) {
+    Serial.print (F("Correction: "));
+    Serial.println (sg.correction);
+    return;
+    
+  } else if (absl (arg[0].s) > MAXIMUM_CORRECTION) {
+    Serial.println (F("Bad Cal"));
+    return;
+    
+  } else if (freq < SI_MIN_OUT_FREQ || freq > SI_MAX_OUT_FREQ) {
+    Serial.println (F("Bad Freq"));
+    return;
+  }
 
-      if (numbers[1] < SI_MIN_OUT_FREQ || numbers[1] > SI_MAX_OUT_FREQ) {
-        Serial.println (F("Bad Freq"));
-        break;
-      }
+  // New value defined so read the old values and display what will be done
+  Serial.print (F("Old Correction: "));
+  Serial.println (sg.correction);
+  Serial.print (F("New Correction: "));
+  
+  // Store the new value entered    
+  sg.correction = arg[0].s;
+  Serial.println (sg.correction);
 
-      // set frequency
-      if (numbers[0] == 0UL) {
-        if (commands[1] == 'A') SetFrequency (SI_CLK0, SI_PLL_A, numbers[1]);
-        else SetFrequency (SI_CLK0, SI_PLL_B, numbers[1]); 
+  // Reset the Si5351 and then display frequency based on new setting     
+  setupSi5351(sg.correction);
+  MemSave (0);
+  // All from PLLA so the three outputs are in phase
+  Si5351StageFrequency (SI_CLK0, SI_PLL_A, freq);
+  Si5351StageFrequency (SI_CLK1, SI_PLL_A, freq);
+  Si5351StageFrequency (SI_CLK2, SI_PLL_A, freq);
+  Si5351CommitSync ();
+}
 
-      } else if (numbers[0] == 1UL) {
-        if (commands[1] == 'A') SetFrequency (SI_CLK1, SI_PLL_A, numbers[1]);
-        else SetFrequency (SI_CLK1, SI_PLL_B, numbers[1]);
+// Set Frequency. Syntax: F [CLK] [FREQ] [PLL], where PLL is A or B (default B)
+void CLIFrequency (CLIArg *arg, unsigned char n)
+{
+  unsigned long freq = CLIHz (&arg[1]);
 
-      } else if (numbers[0] == 2UL) {
-        if (commands[1] == 'A') SetFrequency (SI_CLK2, SI_PLL_A, numbers[1]);
-        else SetFrequency (SI_CLK2, SI_PLL_B, numbers[1]);
+  // Validate inputs
+  if (arg[0].u > 2UL) {
+    Serial.println (F("Bad Clk"));
+    return;
+  }
 
-      }
-      break;
+  if (freq < SI_MIN_OUT_FREQ || freq > SI_MAX_OUT_FREQ) {
+    Serial.println (F("Bad Freq"));
+    return;
+  }
 
-    case 'I':             // Memory setting
-      memset ((char *)&mem, 0xFF, sizeof (mem));
-      EEPROM.put(0, mem);
-      break;
+  // set frequency. SI_CLK0 to SI_CLK2 are 0 to 2
+  SetFrequency ((unsigned char)arg[0].u, (arg[2].c == 'A') ? SI_PLL_A : SI_PLL_B, freq);
+}
 
+// Invalidate all memories (and the boot record). Syntax: I
+void CLIInvalidate (CLIArg *arg, unsigned char n)
+{
+  unsigned int i;
 
-    case 'M':             // Memory setting
-      printMem(0);
-      printMem(1);
-      printMem(2);
-      printMem(3);
-      break;
+  for (i=0; i<MEM_ADDRESS(MAX_MEMORIES); i++) EEPROM.update(i, 0xFF);
+#ifdef ENABLE_FAST_BOOT
+  for (i=BOOT_RECORD_ADDRESS; i<BOOT_MENU_ADDRESS; i++) EEPROM.update(i, 0xFF);
+#endif // ENABLE_FAST_BOOT
+}
 
-    // Phase controls
-    case 'P':
-      if (numbers[0] > 2UL){
-        Serial.println (F("Bad CLK"));
-        return;
-      }
-      clk = (unsigned char)numbers[0];
-      
-      if (numbers[1] > 128UL || numbers[1] <  4UL  ){
-        Serial.println (F("Bad Phase"));
-        return;
-      }
-      phase = (unsigned char)numbers[1];
+#ifdef ENABLE_LATENCY_STATS
+// Rotary to RF latency. Syntax: L to display the histogram, L 1 to clear it
+void CLILatency (CLIArg *arg, unsigned char n)
+{
+  if (arg[0].u == 1UL) LatencyReset();
+  else LatencyReport();
+}
+#endif // ENABLE_LATENCY_STATS
+
+// Display the memories. Syntax: M
+void CLIMemories (CLIArg *arg, unsigned char n)
+{
+  unsigned char i;
 
-      Serial.print (F("Clk: "));
-      Serial.print (clk);
-      Serial.print (F(" Phase: "));
-      Serial.println (phase);
+  for (i=0; i<MAX_MEMORIES; i++) printMem(i);
+}
 
-      UpdatePhaseRegister (clk, phase);     
-      break;
+// Phase of a running clock in degrees (0 to 359) from the clocks on the same PLL. Syntax: P [CLK] [PHASE]
+void CLIPhase (CLIArg *arg, unsigned char n)
+{
+  if (arg[0].u > 2UL){
+    Serial.println (F("Bad CLK"));
+    return;
+  }
+  
+  if (arg[1].u >= SI_MAX_PHASE || !SetPhase ((unsigned char)arg[0].u, (unsigned int)arg[1].u)) {
+    Serial.println (F("Bad Phase"));
+    return;
+  }
 
-    case 'Q':             // Reset
-      if (numbers[0] < SI_MIN_IQ_OUT_FREQ || numbers[1] > SI_MAX_IQ_OUT_FREQ) {
-        Serial.println (F("Bad Freq"));
-        break;
-      }
-              
-      SetIQFrequency (SI_CLK0, SI_CLK2, SI_PLL_A, numbers[0]);
-      
-      break;
+  Serial.print (F("Clk: "));
+  Serial.print (arg[0].u);
+  Serial.print (F(" Phase: "));
+  Serial.println (arg[1].u);
+}
 
-    // This command reset the Si5351.  A reset zeros all parameters including the correction/calibration value
-    // Therefore the calibration must be re-read from eeprom
-    case 'R':             // Reset
-      Reset();
+// I/Q output on CLK0 and CLK2. Syntax: Q [FREQ]
+void CLIIQFrequency (CLIArg *arg, unsigned char n)
+{
+  unsigned long freq = CLIHz (&arg[0]);
+
+  if (freq < SI_MIN_IQ_OUT_FREQ || freq > SI_MAX_IQ_OUT_FREQ) {
+    Serial.println (F("Bad Freq"));
+    return;
+  }
+          
+  SetIQFrequency (SI_CLK0, SI_CLK2, SI_PLL_A, freq);
+}
+
+// This command reset the Si5351.  A reset zeros all parameters including the correction/calibration value
+// Therefore the calibration must be re-read from eeprom. Syntax: R
+void CLIReset (CLIArg *arg, unsigned char n)
+{
+  Reset();
+}
+
+#ifdef ENABLE_INPUT_TRACE
+// Input trace. Syntax: T to dump the recorded events, T 1 to Reset() and replay them
+void CLITrace (CLIArg *arg, unsigned char n)
+{
+  if (arg[0].u == 1UL) TraceReplay();
+  else TraceDump();
+}
+#endif // ENABLE_INPUT_TRACE
+
+#ifdef ENABLE_PROFILER
+// CPU usage by region. Syntax: U to display the profile, U 1 to clear it
+void CLIProfile (CLIArg *arg, unsigned char n)
+{
+  if (arg[0].u == 1UL) ProfileReset();
+  else ProfileReport();
+}
+#endif // ENABLE_PROFILER
+
+#ifdef ENABLE_SWEEP
+// Configure the sweep. Syntax: W [START] [STOP] [N] [DWELL] [MODE] [SPACING]
+// N is the number of points, or the step in Hz for spacing S. DWELL is in ms
+// MODE is S (single), C (continuous) or T (triangle). SPACING is L (linear), G (log) or S (step). Defaults are S and L
+void CLISweepConfigure (CLIArg *arg, unsigned char n)
+{
+  if (!SweepConfigure (CLIHz (&arg[0]), CLIHz (&arg[1]), arg[2].u, (arg[3].u > 0xFFFFUL) ? 0 : (unsigned int)arg[3].u,
+                       arg[4].c ? arg[4].c : SWEEP_SINGLE, arg[5].c ? arg[5].c : SWEEP_LINEAR)) {
+    Serial.println (F("Bad Sweep"));
+  }
+}
+
+// Run the sweep. Syntax: S to show the status, S G [CLK] to start and S X to stop
+void CLISweep (CLIArg *arg, unsigned char n)
+{
+  if (arg[0].c == 'G') {
+    if (arg[1].u > 2UL || !SweepStart ((unsigned char)arg[1].u)) Serial.println (F("Bad Sweep"));
+  } else if (arg[0].c == 'X') {
+    SweepStop ();
+  } else {
+    SweepReport ();
+  }
+}
+#endif // ENABLE_SWEEP
+
+#ifdef ENABLE_HOP
+// Set a hop table entry. Syntax: H [INDEX] [MASK] [FREQ] [DWELL] [ON]
+// MASK has bit 0 for CLK0 to bit 2 for CLK2. FREQ 0 leaves the frequency unchanged. DWELL is in ms. ON is 1 (default) or 0
+void CLIHop (CLIArg *arg, unsigned char n)
+{
+  if (arg[0].u > 0xFFUL || arg[1].u > 0xFFUL || arg[3].u > 0xFFFFUL || arg[4].u > 1UL ||
+      !HopSet ((unsigned char)arg[0].u, (unsigned char)arg[1].u, CLIHz (&arg[2]), (unsigned int)arg[3].u, (n < 5) ? 1 : (unsigned char)arg[4].u)) {
+    Serial.println (F("Bad Hop"));
+  }
+}
+
+// Hop table playback. Syntax: J to show the status and table, J O, J L or J T to play it once, in a loop
+// or once per trigger, J X to stop, J S to save the table to eeprom, J R to read it back and J C to clear it
+void CLIHopPlay (CLIArg *arg, unsigned char n)
+{
+  switch (arg[0].c) {
+    case 0:
+      HopReport ();
+      return;
+
+    case 'X':
+      HopStop ();
+      return;
+
+    case 'S':
+      HopSave ();
+      return;
+
+    case 'R':
+      if (HopLoad ()) return;
       break;
 
-    // If an undefined command is entered, display an error message
+    case 'C':
+      HopClear ();
+      return;
+
     default:
-      ErrorOut ();
+      if (HopStart (arg[0].c)) return;
   }
+  Serial.println (F("Bad Hop"));
+}
+#endif // ENABLE_HOP
 
+#ifdef ENABLE_BEACON
+// Encode a WSPR message into the beacon symbol table. Syntax: D [CALL] [GRID] [DBM]
+void CLIWSPR (CLIArg *arg, unsigned char n)
+{
+  if (arg[2].u > 60UL || !BeaconWSPR (arg[0].str, arg[1].str, (unsigned char)arg[2].u)) Serial.println (F("Bad Beacon"));
+}
+
+#if defined(ENABLE_FT8) || defined(ENABLE_JT65)
+// Encode a standard FT8 or JT65 message into the beacon symbol table. Syntax: Z [MODE] [CALL1] [CALL2] [EXTRA]
+// MODE is F (FT8) or J (JT65). CALL1 can be CQ, QRZ or DE. EXTRA is a grid, a report such as -07 or R-07, RRR,
+// 73, RR73 (FT8) or RO (JT65) and can be left out, e.g. Z F CQ VE3OOI FN03
+void CLIMessage (CLIArg *arg, unsigned char n)
+{
+  char *extra = (n > 3) ? arg[3].str : NULL;
+
+#ifdef ENABLE_FT8
+  if (arg[0].c == BEACON_FT8 && BeaconFT8 (arg[1].str, arg[2].str, extra)) return;
+#endif // ENABLE_FT8
+#ifdef ENABLE_JT65
+  if (arg[0].c == BEACON_JT65 && BeaconJT65 (arg[1].str, arg[2].str, extra)) return;
+#endif // ENABLE_JT65
+  Serial.println (F("Bad Beacon"));
+}
+#endif // ENABLE_FT8 || ENABLE_JT65
+
+// Beacon transmission. Syntax: Y to show the status and symbols, Y G [FREQ] [CLK] [REPEAT] to transmit and Y X to stop
+// FREQ is tone 0. With REPEAT 1 a transmission starts every 2 minutes (WSPR), 15 seconds (FT8) or minute (JT65)
+void CLIBeacon (CLIArg *arg, unsigned char n)
+{
+  if (arg[0].c == 'G') {
+    if (arg[2].u > 2UL || arg[3].u > 1UL || !BeaconStart ((unsigned char)arg[2].u, arg[1].mhz, (unsigned char)arg[3].u)) {
+      Serial.println (F("Bad Beacon"));
+    }
+  } else if (arg[0].c == 'X') {
+    BeaconStop ();
+  } else {
+    BeaconReport ();
+  }
+}
+#endif // ENABLE_BEACON
+
+#ifdef ENABLE_KEYER
+// CW keyer. Syntax: K to show the status, K S, K A or K B [WPM] [CLK] to start with a straight key or
+// iambic mode A or B paddles and K X to stop. Set the clock frequency with F first. WPM is 20 and CLK 0 by default
+void CLIKeyer (CLIArg *arg, unsigned char n)
+{
+  if (arg[0].c == 'X') {
+    KeyerStop ();
+  } else if (n) {
+    if (arg[1].u > 0xFFUL || arg[2].u > 2UL ||
+        !KeyerStart (arg[0].c, (n < 2) ? KEYER_DEFAULT_WPM : (unsigned char)arg[1].u, (unsigned char)arg[2].u)) {
+      Serial.println (F("Bad Keyer"));
+    }
+  } else {
+    KeyerReport ();
+  }
+}
+
+// Keyer messages. Syntax: N to list the messages, N [INDEX] [TEXT] to store one in eeprom
+void CLIKeyerMessage (CLIArg *arg, unsigned char n)
+{
+  if (!n) {
+    KeyerListMessages ();
+  } else if (n < 2 || arg[0].u > 0xFFUL || !KeyerSetMessage ((unsigned char)arg[0].u, arg[1].str)) {
+    Serial.println (F("Bad Message"));
+  }
+}
+
+// Send a keyer message. Syntax: O [INDEX] [SECONDS] to send it once or every SECONDS, O to stop sending
+void CLIKeyerSend (CLIArg *arg, unsigned char n)
+{
+  if (!n) arg[0].u = KEYER_MESSAGES;          // Not valid, stops the message being sent
+  if (arg[0].u > 0xFFUL || arg[1].u > 0xFFFFUL || !KeyerSend ((unsigned char)arg[0].u, (unsigned int)arg[1].u)) {
+    if (n) Serial.println (F("Bad Message"));
+  }
+}
+#endif // ENABLE_KEYER
+
+#ifdef ENABLE_ANALYZER
+// Scalar network analyzer over the sweep set with W. Syntax: A to show the status, A C or A B [CLK] [SETTLE] [SAMPLES]
+// to measure with CSV or binary output and A X to stop. SETTLE is in us (default 100). SAMPLES is 1 to 64 (default 4)
+void CLIAnalyzer (CLIArg *arg, unsigned char n)
+{
+  if (arg[0].c == 'X') {
+    AnalyzerStop ();
+  } else if (n) {
+    if (arg[1].u > 2UL || arg[2].u > 0xFFFFUL || arg[3].u > 0xFFUL ||
+        !AnalyzerStart ((unsigned char)arg[1].u, (n < 3) ? ANALYZER_DEFAULT_SETTLE : (unsigned int)arg[2].u,
+                        (n < 4) ? ANALYZER_DEFAULT_SAMPLES : (unsigned char)arg[3].u, arg[0].c)) {
+      Serial.println (F("Bad Analyzer"));
+    }
+  } else {
+    AnalyzerReport ();
+  }
+}
+#endif // ENABLE_ANALYZER
+
+#ifdef ENABLE_COUNTER
+// Frequency counter on D5. Syntax: G to show the last reading, G [GATE] to count with a gate of 10 to 10000 ms
+// and G 0 to stop
+void CLICounter (CLIArg *arg, unsigned char n)
+{
+  if (!n) {
+    CounterReport ();
+    return;
+  }
+  CounterStop ();
+  if (arg[0].u && (arg[0].u > COUNTER_MAX_GATE || !CounterStart ((unsigned int)arg[0].u))) Serial.println (F("Bad Counter"));
+}
+#endif // ENABLE_COUNTER
+
+#ifdef ENABLE_AUTO_CALIBRATION
+// Crystal calibration from measured outputs. Syntax: V to show the points and solution, V P [FREQ] [MEAS] to add
+// an output set to FREQ and measured at MEAS Hz, V A to apply the solution and V C to clear the points.
+// With the counter V P [FREQ] sets CLK0, which must be wired to D5, to FREQ (up to 6MHz) and counts it for 10s
+void CLIAutoCalibrate (CLIArg *arg, unsigned char n)
+{
+  long correction, rms;
+  unsigned char i, mask = 0;
+
+  if (arg[0].c == 'P') {
+    if (n < 3) {
+#ifdef ENABLE_COUNTER
+      if (CalMeasure (CLIHz (&arg[1]))) {
+        CalReport ();
+        return;
+      }
+#endif // ENABLE_COUNTER
+    } else if (CalAddPoint (CLIHz (&arg[1]), arg[2].mhz)) {
+      CalReport ();
+      return;
+    }
+    Serial.println (F("Bad Cal"));
+
+  } else if (arg[0].c == 'A') {
+    if (!CalSolve (&correction, &rms)) {
+      Serial.println (F("Bad Cal"));
+      return;
+    }
+    Serial.print (F("Old Correction: "));
+    Serial.println (sg.correction);
+    sg.correction = correction;
+    Serial.print (F("New Correction: "));
+    Serial.println (sg.correction);
+
+    // The outputs that were on are set again with the new correction
+    setupSi5351 (sg.correction);
+    if (flags & IQ_FREQUENCY_MODE) {
+      UpdateIQFrequency (ClkSelection);
+    } else {
+      for (i=0; i<MAXCLK; i++) {
+        if (sg.ClkStatus[i]) mask |= 1 << i;
+      }
+      if (mask) UpdateFrequencies (mask);
+    }
+    MemSave (0);
+    CalClear ();
+
+  } else if (arg[0].c == 'C') {
+    CalClear ();
+  } else {
+    CalReport ();
+  }
+}
+#endif // ENABLE_AUTO_CALIBRATION
+
+#ifdef ENABLE_TRACKING
+// Clock tracking. Syntax: E to show the tracking, E [CLK] to stop CLK following and E [CLK] [MASTER] [MUL] [DIV] [OFFSET]
+// to make CLK follow MASTER at MASTER * MUL / DIV + OFFSET Hz. MUL and DIV are 1 by default
+void CLITrack (CLIArg *arg, unsigned char n)
+{
+  if (!n) {
+    TrackReport ();
+    return;
+  }
+  if (arg[0].u > 2UL || arg[1].u > 2UL || arg[2].u > TRACK_MAX_RATIO || arg[3].u > TRACK_MAX_RATIO ||
+      !TrackSet ((unsigned char)arg[0].u, (n < 2) ? TRACK_NONE : (unsigned char)arg[1].u,
+                 (n < 3) ? 1 : (unsigned int)arg[2].u, (n < 4) ? 1 : (unsigned int)arg[3].u, arg[4].s)) {
+    Serial.println (F("Bad Track"));
+    return;
+  }
+
+  // Move the new dependent to its frequency
+  if (n > 1 && sg.ClkStatus[arg[1].u]) UpdateFrequency ((unsigned char)arg[1].u);
+}
+#endif // ENABLE_TRACKING
+
+// Command letter, required arguments, argument types and handler.  A new command is one line here
+const CLICommand clicommands[] PROGMEM = {
+#ifdef ENABLE_ANALYZER
+  {'A', 0, "cuuu", CLIAnalyzer},
+#endif // ENABLE_ANALYZER
+#ifdef ENABLE_LCD_BENCHMARK
+  {'B', 0, "",    CLIBenchmark},
+#endif // ENABLE_LCD_BENCHMARK
+  {'C', 0, "sm",  CLICalibrate},
+#ifdef ENABLE_BEACON
+  {'D', 3, "aau", CLIWSPR},
+#endif // ENABLE_BEACON
+#ifdef ENABLE_TRACKING
+  {'E', 0, "uuuus", CLITrack},
+#endif // ENABLE_TRACKING
+  {'F', 2, "umc", CLIFrequency},
+#ifdef ENABLE_COUNTER
+  {'G', 0, "u",   CLICounter},
+#endif // ENABLE_COUNTER
+#ifdef ENABLE_HOP
+  {'H', 4, "uumuu", CLIHop},
+#endif // ENABLE_HOP
+  {'I', 0, "",    CLIInvalidate},
+#ifdef ENABLE_HOP
+  {'J', 0, "c",   CLIHopPlay},
+#endif // ENABLE_HOP
+#ifdef ENABLE_KEYER
+  {'K', 0, "cuu", CLIKeyer},
+#endif // ENABLE_KEYER
+#ifdef ENABLE_LATENCY_STATS
+  {'L', 0, "u",   CLILatency},
+#endif // ENABLE_LATENCY_STATS
+  {'M', 0, "",    CLIMemories},
+#ifdef ENABLE_KEYER
+  {'N', 0, "ur",  CLIKeyerMessage},
+  {'O', 0, "uu",  CLIKeyerSend},
+#endif // ENABLE_KEYER
+  {'P', 2, "uu",  CLIPhase},
+  {'Q', 1, "m",   CLIIQFrequency},
+  {'R', 0, "",    CLIReset},
+#ifdef ENABLE_SWEEP
+  {'S', 0, "cu",  CLISweep},
+#endif // ENABLE_SWEEP
+#ifdef ENABLE_INPUT_TRACE
+  {'T', 0, "u",   CLITrace},
+#endif // ENABLE_INPUT_TRACE
+#ifdef ENABLE_PROFILER
+  {'U', 0, "u",   CLIProfile},
+#endif // ENABLE_PROFILER
+#ifdef ENABLE_AUTO_CALIBRATION
+  {'V', 0, "cmm", CLIAutoCalibrate},
+#endif // ENABLE_AUTO_CALIBRATION
+#ifdef ENABLE_SWEEP
+  {'W', 4, "mmuucc", CLISweepConfigure},
+#endif // ENABLE_SWEEP
+#ifdef ENABLE_BEACON
+  {'Y', 0, "cmuu", CLIBeacon},
+#endif // ENABLE_BEACON
+#if defined(ENABLE_FT8) || defined(ENABLE_JT65)
+  {'Z', 3, "caaa", CLIMessage},
+#endif // ENABLE_FT8 || ENABLE_JT65
+};
+
+void ExecuteSerial (char *str)
+// This function called when a line has been entered.  The line is parsed in place and the command run
+{
+  DispatchSerial (str, clicommands, sizeof(clicommands) / sizeof(clicommands[0]));
 }
 
 
 void printMem (unsigned char i) 
 {
-  EEPROM.get(0, mem);
-  memset(rbuff,0,sizeof(rbuff));
-  if (mem[i].flags == (MEM_ID | VERSION)) {
-    sprintf (rbuff, "Mem: %d Corr: %d", i, mem[i].correction);
-    Serial.println (rbuff);
-    sprintf (rbuff, "\tVFO1: %ld VFO2: %ld VFO3: %ld", mem[i].ClkFreq[0], mem[i].ClkFreq[1], mem[i].ClkFreq[2]);
-    Serial.println (rbuff);
-    sprintf (rbuff, "\tOFF1: %ld OFF2: %ld OFF3: %ld", mem[i].ClkOffset[0], mem[i].ClkOffset[1], mem[i].ClkOffset[2]);
-    Serial.println (rbuff);
-    sprintf (rbuff, "\tIQ1: %ld IQ2: %ld IQ3: %ld", mem[i].IQClkFreq[0], mem[i].IQClkFreq[1], mem[i].IQClkFreq[2]);
-    Serial.println (rbuff);
-    memset(rbuff,0,sizeof(rbuff));
+  Sig_Gen_Struct m;
+
+  if (MemRecall (i, &m)) {
+    Serial.print (F("Mem: "));
+    Serial.print (i);
+    Serial.print (F(" Corr: "));
+    Serial.println (m.correction);
+    printMemValues (F("VFO"), (long *)m.ClkFreq);
+    printMemValues (F("OFF"), m.ClkOffset);
+    printMemValues (F("IQ"), (long *)m.IQClkFreq);
   } else {
     Serial.println ((char *)"MEM ERR");
   }
 
 }
 
+void printMemValues (const __FlashStringHelper *name, long *v)
+// Print one line of printMem(), e.g. "	VFO1: 7000000 VFO2: 7000000 VFO3: 7000000"
+{
+  unsigned char j;
+
+  for (j=0; j<MAXCLK; j++) {
+    Serial.print (j ? ' ' : '\t');
+    Serial.print (name);
+    Serial.print (j+1);
+    Serial.print (F(": "));
+    Serial.print (v[j]);
+  }
+  Serial.println ("");
+}
+
 #endif // REMOVE_CLI
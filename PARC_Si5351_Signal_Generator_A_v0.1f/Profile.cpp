@@ -0,0 +1,205 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to measure timing of the Sig Gen (latency and profiling).
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+*/
+
+#include "Arduino.h"
+
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
+#include "Timer.h"
+#include "Profile.h"
+
+#ifdef ENABLE_LATENCY_STATS
+
+// detenttime is stamped by the Timer1 ISR when a rotary detent is detected. The menu code picks it
+// up with LatencyStart() when it consumes the detent and calls LatencyRecord() once the Si5351
+// has acknowledged the last register byte of the retune.
+volatile unsigned long detenttime;
+
+unsigned int latencyhist[LATENCY_BUCKETS];
+unsigned int latencycount;
+unsigned long latencymin, latencymax;
+
+
+unsigned long LatencyStart (void)
+{
+  unsigned long t;
+  unsigned char sreg;
+
+  sreg = SREG;
+  cli();
+  t = detenttime;
+  SREG = sreg;
+  return t;
+}
+
+void LatencyRecord (unsigned long start)
+{
+  unsigned long us;
+  unsigned char i;
+
+  us = (TimerTimestamp() - start) * TIMER_TICK_US;
+
+  if (!latencycount || us < latencymin) latencymin = us;
+  if (us > latencymax) latencymax = us;
+  if (latencycount < 0xFFFF) latencycount++;
+
+  // Find the most significant bit, then use the next bit to split the octave in half
+  i = 0;
+  if (us > 1) {
+    for (i = 31; !(us & (1UL << i)); i--);
+    i = (i << 1) | ((us >> (i - 1)) & 1);
+  }
+  if (i >= LATENCY_BUCKETS) i = LATENCY_BUCKETS - 1;
+  if (latencyhist[i] < 0xFFFF) latencyhist[i]++;
+}
+
+void LatencyReset (void)
+{
+  memset ((char *)&latencyhist, 0, sizeof(latencyhist));
+  latencycount = 0;
+  latencymin = latencymax = 0;
+}
+
+unsigned long LatencyBucketLimit (unsigned char i)
+// Upper limit of a histogram bucket in us
+{
+  if (i & 1) return (1UL << ((i >> 1) + 1));
+  return (3UL << (i >> 1)) >> 1;
+}
+
+unsigned long LatencyPercentile (unsigned char pct)
+{
+  unsigned long rank, sum;
+  unsigned char i;
+
+  rank = ((unsigned long)latencycount * pct + 99) / 100;
+  sum = 0;
+  for (i=0; i<LATENCY_BUCKETS; i++) {
+    sum += latencyhist[i];
+    if (sum >= rank) break;
+  }
+  if (i >= LATENCY_BUCKETS) i = LATENCY_BUCKETS - 1;
+
+  // Percentile is reported as the bucket upper limit but never more than the measured max
+  if (LatencyBucketLimit(i) > latencymax) return latencymax;
+  return LatencyBucketLimit(i);
+}
+
+void LatencyReport (void)
+{
+  unsigned char i;
+
+  Serial.print (F("Latency us N: "));
+  Serial.print (latencycount);
+  if (!latencycount) {
+    Serial.println ("");
+    return;
+  }
+  Serial.print (F(" Min: "));
+  Serial.print (latencymin);
+  Serial.print (F(" P50: "));
+  Serial.print (LatencyPercentile(50));
+  Serial.print (F(" P99: "));
+  Serial.print (LatencyPercentile(99));
+  Serial.print (F(" Max: "));
+  Serial.println (latencymax);
+
+  // Non empty buckets as "<upper limit> count"
+  for (i=0; i<LATENCY_BUCKETS; i++) {
+    if (!latencyhist[i]) continue;
+    Serial.print ('<');
+    Serial.print (LatencyBucketLimit(i));
+    Serial.print (' ');
+    Serial.println (latencyhist[i]);
+  }
+}
+
+#endif // ENABLE_LATENCY_STATS
+
+
+#ifdef ENABLE_PROFILER
+
+// Regions are bracketed with PROFILE_START()/PROFILE_END() which read Timer1 through TimerTimestamp().
+// The resolution is one Timer1 count (64 CPU cycles, 4us) so short regions are only meaningful as
+// totals over many calls. Counts and totals are updated with interrupts off since the ISR is a region.
+Profile_Struct profile[PROFILE_REGIONS];
+unsigned long profilestart;
+
+const char profilenames[PROFILE_REGIONS][PROFILE_NAME_LEN] PROGMEM = {
+  "ISR", "Loop", "Serial", "PLL", "MSN",
+  "Header", "Menu", "ClkMode", "ClkStat", "Num1D", "Num3D",
+  "Offset", "ClkFreq", "IQFreq", "LOFreq", "ClkEntry", "Flush"
+};
+
+
+void ProfileRecord (unsigned char region, unsigned long start)
+{
+  unsigned long t;
+  unsigned char sreg;
+
+  t = TimerTimestamp() - start;
+
+  sreg = SREG;
+  cli();
+  profile[region].count++;
+  profile[region].total += t;
+  if (t > profile[region].max) profile[region].max = (t > 0xFFFF) ? 0xFFFF : (unsigned int)t;
+  SREG = sreg;
+}
+
+void ProfileReset (void)
+{
+  unsigned char sreg;
+
+  sreg = SREG;
+  cli();
+  memset ((char *)&profile, 0, sizeof(profile));
+  profilestart = TimerTimestamp();
+  SREG = sreg;
+}
+
+void ProfileReport (void)
+{
+  Profile_Struct p;
+  unsigned long elapsed, load;
+  unsigned char i, sreg;
+
+  // Columns: region, count, total us, average cycles, max cycles
+  for (i=0; i<PROFILE_REGIONS; i++) {
+    sreg = SREG;
+    cli();
+    memcpy ((char *)&p, (char *)&profile[i], sizeof(p));
+    if (!i) elapsed = TimerTimestamp() - profilestart;
+    SREG = sreg;
+
+    if (!i) {
+      // ISR load is the fraction of Timer1 counts spent in the ISR, in 0.1% units
+      load = elapsed ? (unsigned long)(((unsigned long long)p.total * 1000ULL) / elapsed) : 0;
+      Serial.print (F("ISR Load: "));
+      Serial.print (load / 10);
+      Serial.print ('.');
+      Serial.print (load % 10);
+      Serial.print (F("% Elapsed us: "));
+      Serial.println (elapsed * TIMER_TICK_US);
+    }
+    if (!p.count) continue;
+
+    Serial.print ((const __FlashStringHelper *)profilenames[i]);
+    Serial.print (' ');
+    Serial.print (p.count);
+    Serial.print (' ');
+    Serial.print (p.total * TIMER_TICK_US);
+    Serial.print (' ');
+    Serial.print ((unsigned long)(((unsigned long long)p.total * TIMER_TICK_CYCLES) / p.count));
+    Serial.print (' ');
+    Serial.println ((unsigned long)p.max * TIMER_TICK_CYCLES);
+  }
+}
+
+#endif // ENABLE_PROFILER
@@ -0,0 +1,61 @@
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+// Knob to RF latency histogram. Buckets are half octaves of microseconds,
+// bucket 2n covers [2^n, 1.5*2^n) and bucket 2n+1 covers [1.5*2^n, 2^(n+1))
+#define LATENCY_BUCKETS 44
+
+#ifdef ENABLE_LATENCY_STATS
+extern volatile unsigned long detenttime;
+#define LATENCY_STAMP()   (detenttime = TimerTimestamp())
+#else
+#define LATENCY_STAMP()   do {} while (0)
+#endif // ENABLE_LATENCY_STATS
+
+// Profiler regions. Nested regions are included in the outer region (e.g. PROFILE_LOOP
+// includes everything) and ISR time is included in whatever region it interrupted
+#define PROFILE_ISR             0     // ISR(TIMER1_COMPA_vect)
+#define PROFILE_LOOP            1     // One loop() iteration
+#define PROFILE_SERIAL          2     // ProcessSerial()
+#define PROFILE_PLL             3     // ProgramSi5351PLL()
+#define PROFILE_MSN             4     // ProgramSi5351MSN()
+#define PROFILE_LCD_HEADER      5     // LCDDisplay*() calls
+#define PROFILE_LCD_MENU        6
+#define PROFILE_LCD_MODE        7
+#define PROFILE_LCD_STATUS      8
+#define PROFILE_LCD_NUM1D       9
+#define PROFILE_LCD_NUM3D       10
+#define PROFILE_LCD_OFFSET      11
+#define PROFILE_LCD_FREQ        12
+#define PROFILE_LCD_IQFREQ      13
+#define PROFILE_LCD_LOFREQ      14
+#define PROFILE_LCD_ENTRY       15
+#define PROFILE_LCD_FLUSH       16    // LCDFlush()
+#define PROFILE_REGIONS         17
+
+#define PROFILE_NAME_LEN        9
+
+typedef struct {
+  unsigned long count;          // Times region was entered
+  unsigned long total;          // Total time in Timer1 counts (64 CPU cycles each)
+  unsigned int max;             // Longest time in Timer1 counts
+} Profile_Struct;
+
+#ifdef ENABLE_PROFILER
+#define PROFILE_START(t)      unsigned long t = TimerTimestamp()
+#define PROFILE_END(r, t)     ProfileRecord (r, t)
+#else
+#define PROFILE_START(t)
+#define PROFILE_END(r, t)
+#endif // ENABLE_PROFILER
+
+unsigned long LatencyStart (void);
+void LatencyRecord (unsigned long start);
+void LatencyReset (void);
+void LatencyReport (void);
+
+void ProfileRecord (unsigned char region, unsigned long start);
+void ProfileReset (void);
+void ProfileReport (void);
+
+#endif // _PROFILE_H_
@@ -0,0 +1,336 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to control the signal generator from test equipment over a binary protocol.
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+*/
+
+#include "Arduino.h"
+
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
+#include "VE3OOI_Si5351_v2.1.h"
+#include "Protocol.h"
+#include "Hop.h"
+#include "Beacon.h"
+
+#ifdef ENABLE_BINARY_PROTOCOL
+
+extern volatile unsigned long flags;
+extern volatile unsigned char MenuSelection;
+extern Sig_Gen_Struct sg;
+
+// Receive states
+#define PROTO_IDLE    0
+#define PROTO_LENGTH  1
+#define PROTO_DATA    2
+#define PROTO_CRC     3
+
+// Frame being received. protobuff holds the opcode and payload
+unsigned char protobuff[PROTO_MAX_PAYLOAD + 1];
+unsigned char protostate, protolen, protoctr, protocrc;
+unsigned long protostart;
+
+// Frequency list loaded with PROTO_OP_LOAD_LIST and stepped through with PROTO_OP_LIST_STEP
+unsigned long protolist[PROTO_LIST_ENTRIES];
+unsigned char protolistlen, protolistpos;
+
+unsigned int protoframes, protocrcerrors, prototimeouts, protorejected;
+
+static void ProtocolExecute (void);
+
+
+unsigned char ProtocolCRC8 (unsigned char crc, unsigned char c)
+// CRC-8, polynomial x^8 + x^2 + x + 1 (0x07)
+{
+  unsigned char i;
+
+  crc ^= c;
+  for (i=0; i<8; i++) {
+    if (crc & 0x80) crc = (crc << 1) ^ 0x07;
+    else crc <<= 1;
+  }
+  return crc;
+}
+
+unsigned char ProtocolReceive (unsigned char c, unsigned char textidle)
+// Called for each character received.  Returns 1 if the character is part of a frame.  textidle is
+// set when no text command is being entered so a sync character starts a frame
+{
+  switch (protostate) {
+    case PROTO_IDLE:
+      if (!textidle || c != PROTO_SYNC) return 0;
+      protostate = PROTO_LENGTH;
+      protostart = millis();
+      break;
+
+    case PROTO_LENGTH:
+      if (!c || c > sizeof(protobuff)) {
+        // Can not be a frame. Look for the next sync
+        protorejected++;
+        protostate = PROTO_IDLE;
+        break;
+      }
+      protolen = c;
+      protoctr = 0;
+      protocrc = ProtocolCRC8 (0, c);
+      protostate = PROTO_DATA;
+      break;
+
+    case PROTO_DATA:
+      protobuff[protoctr++] = c;
+      protocrc = ProtocolCRC8 (protocrc, c);
+      if (protoctr == protolen) protostate = PROTO_CRC;
+      break;
+
+    case PROTO_CRC:
+      protostate = PROTO_IDLE;
+      if (c != protocrc) {
+        protocrcerrors++;
+        protolen = 2;             // Reply with the status only
+        protobuff[1] = PROTO_ERR_CRC;
+        ProtocolReply ();
+        break;
+      }
+      protoframes++;
+      ProtocolExecute ();
+      break;
+  }
+  return 1;
+}
+
+void ProtocolPoll (void)
+// Drop a frame that was not completed in time.  Outside the CLI, frames are read here and any text is discarded
+{
+  if (protostate != PROTO_IDLE && (millis() - protostart) > PROTO_TIMEOUT_MS) {
+    prototimeouts++;
+    protostate = PROTO_IDLE;
+  }
+
+  if (flags & CLI_MODE) return;
+
+  while (Serial.available() > 0) ProtocolReceive ((unsigned char)Serial.read(), 1);
+}
+
+void ProtocolReply (void)
+// Send the reply in protobuff. protobuff[0] is the request opcode, protolen - 1 bytes from protobuff[1] are sent
+{
+  unsigned char i, crc;
+
+  protobuff[0] |= PROTO_REPLY;
+  crc = ProtocolCRC8 (0, protolen);
+  for (i=0; i<protolen; i++) crc = ProtocolCRC8 (crc, protobuff[i]);
+
+  Serial.write ((uint8_t)PROTO_SYNC);
+  Serial.write (protolen);
+  Serial.write (protobuff, protolen);
+  Serial.write (crc);
+}
+
+static unsigned char ProtocolPut (unsigned char pos, unsigned long v, unsigned char bytes)
+// Store v little endian in the reply. Returns the next position
+{
+  while (bytes--) {
+    protobuff[pos++] = (unsigned char)v;
+    v >>= 8;
+  }
+  return pos;
+}
+
+static uint64_t ProtocolMilliHz (unsigned char pos)
+{
+  uint64_t mhz = 0;
+  unsigned char i;
+
+  for (i=8; i; i--) mhz = (mhz << 8) | protobuff[pos + i - 1];
+  return mhz;
+}
+
+static unsigned long ProtocolHz (unsigned char pos)
+// Frequency at pos in milliHz rounded to Hz.  Returns 0 if it is too high for an unsigned long
+{
+  uint64_t mhz;
+
+  mhz = (ProtocolMilliHz (pos) + 500) / 1000;
+  if (mhz > 0xFFFFFFFFUL) return 0;
+  return (unsigned long)mhz;
+}
+
+static unsigned char ProtocolCheckClock (unsigned char clk, unsigned long hz)
+{
+  return (clk < MAXCLK && hz >= LowFrequencyLimit (clk) && hz <= HighFrequencyLimit (clk));
+}
+
+static void ProtocolSetClock (unsigned char clk, unsigned long hz)
+// Clocks are set like the VFO menu sets them so the LCD and memories see the same settings
+{
+  sg.ClkFreq[clk] = hz;
+  sg.ClkMode[clk] = VFO_CLK_MODE;
+  sg.ClkStatus[clk] = 1;
+  UpdateFrequency (clk);
+}
+
+static void ProtocolExecute (void)
+// Run the frame in protobuff and reply.  The reply is built in protobuff over the request
+{
+  unsigned char status = PROTO_OK;
+  unsigned char len = protolen - 1;         // Payload length
+  unsigned char pos = 2;                    // Reply data starts after the opcode and status
+  unsigned char i, clk;
+  unsigned long hz[MAXCLK];
+
+  switch (protobuff[0]) {
+    case PROTO_OP_PING:
+      pos = ProtocolPut (pos, VERSION, 2);
+      break;
+
+    case PROTO_OP_SET_FREQ:
+      if (len != 9) {
+        status = PROTO_ERR_LENGTH;
+        break;
+      }
+      clk = protobuff[1];
+      hz[0] = ProtocolHz (2);
+      if (!ProtocolCheckClock (clk, hz[0])) {
+        status = PROTO_ERR_ARG;
+        break;
+      }
+      ProtocolSetClock (clk, hz[0]);
+      break;
+
+    case PROTO_OP_SET_CLOCKS:
+      // Every clock is checked before any is changed and all are set in this loop() pass
+      if (!len || (protobuff[1] & ~((1 << MAXCLK) - 1))) {
+        status = PROTO_ERR_ARG;
+        break;
+      }
+      for (i=0, clk=0; clk<MAXCLK; clk++) if (protobuff[1] & (1 << clk)) i++;
+      if (len != 1 + 8 * i) {
+        status = PROTO_ERR_LENGTH;
+        break;
+      }
+      for (i=2, clk=0; clk<MAXCLK; clk++) {
+        if (!(protobuff[1] & (1 << clk))) continue;
+        hz[clk] = ProtocolHz (i);
+        i += 8;
+        if (!ProtocolCheckClock (clk, hz[clk])) status = PROTO_ERR_ARG;
+      }
+      if (status != PROTO_OK) break;
+      for (clk=0; clk<MAXCLK; clk++) if (protobuff[1] & (1 << clk)) ProtocolSetClock (clk, hz[clk]);
+      break;
+
+    case PROTO_OP_LOAD_LIST:
+      // Entries are stored from index. The list ends after the last entry loaded
+      if (!len || (len - 1) % 8 || protobuff[1] + (len - 1) / 8 > PROTO_LIST_ENTRIES) {
+        status = PROTO_ERR_LENGTH;
+        break;
+      }
+      for (i=0; i<(len - 1) / 8; i++) protolist[protobuff[1] + i] = ProtocolHz (2 + i * 8);
+      protolistlen = protobuff[1] + i;
+      protolistpos = 0;
+      protobuff[pos++] = protolistlen;
+      break;
+
+    case PROTO_OP_LIST_STEP:
+      // Set the clock to the next list entry. The list wraps around
+      clk = protobuff[1];
+      if (len != 1) {
+        status = PROTO_ERR_LENGTH;
+        break;
+      }
+      if (!protolistlen || protolistpos >= protolistlen) protolistpos = 0;
+      if (!ProtocolCheckClock (clk, protolist[protolistpos])) {
+        status = PROTO_ERR_ARG;
+        break;
+      }
+      ProtocolSetClock (clk, protolist[protolistpos]);
+      protobuff[pos++] = protolistpos++;
+      break;
+
+    case PROTO_OP_STATUS:
+      pos = ProtocolPut (pos, flags, 4);
+      protobuff[pos++] = MenuSelection;
+      for (clk=0; clk<MAXCLK; clk++) protobuff[pos++] = sg.ClkStatus[clk];
+      for (clk=0; clk<MAXCLK; clk++) pos = ProtocolPut (pos, sg.ClkFreq[clk], 4);
+      pos = ProtocolPut (pos, (unsigned long)sg.correction, 4);
+      break;
+
+    case PROTO_OP_COUNTERS:
+      pos = ProtocolPut (pos, protoframes, 2);
+      pos = ProtocolPut (pos, protocrcerrors, 2);
+      pos = ProtocolPut (pos, prototimeouts, 2);
+      pos = ProtocolPut (pos, protorejected, 2);
+      break;
+
+#ifdef ENABLE_HOP
+    case PROTO_OP_LOAD_HOPS:
+      // Entries are stored from index. The table ends after the last entry loaded
+      if (!len || (len - 1) % 12 || protobuff[1] + (len - 1) / 12 > HOP_ENTRIES) {
+        status = PROTO_ERR_LENGTH;
+        break;
+      }
+      for (i=0; i<(len - 1) / 12; i++) {
+        clk = 2 + i * 12;
+        if (!HopSet (protobuff[1] + i, protobuff[clk], ProtocolHz (clk + 4), protobuff[clk + 2] | (protobuff[clk + 3] << 8), protobuff[clk + 1])) {
+          status = PROTO_ERR_ARG;
+          break;
+        }
+      }
+      if (status != PROTO_OK) break;
+      hopentries = protobuff[1] + i;
+      protobuff[pos++] = hopentries;
+      break;
+
+    case PROTO_OP_HOP_RUN:
+      if (len != 1) {
+        status = PROTO_ERR_LENGTH;
+        break;
+      }
+      if (!protobuff[1]) HopStop ();
+      else if (!HopStart ((char)protobuff[1])) status = PROTO_ERR_ARG;
+      break;
+#endif // ENABLE_HOP
+
+#ifdef ENABLE_BEACON
+    case PROTO_OP_SYMBOLS:
+      if (len < 3) {
+        status = PROTO_ERR_LENGTH;
+        break;
+      }
+      i = BeaconLoad ((char)protobuff[1], protobuff[2], &protobuff[3], len - 2);
+      if (!i) {
+        status = PROTO_ERR_ARG;
+        break;
+      }
+      protobuff[pos++] = i;
+      break;
+
+    case PROTO_OP_BEACON:
+      if (!len) {
+        BeaconStop ();
+        break;
+      }
+      if (len != 10) {
+        status = PROTO_ERR_LENGTH;
+        break;
+      }
+      if (protobuff[2] > 1 || !BeaconStart (protobuff[1], ProtocolMilliHz (3), protobuff[2])) status = PROTO_ERR_ARG;
+      break;
+#endif // ENABLE_BEACON
+
+    default:
+      status = PROTO_ERR_OPCODE;
+  }
+
+  if (status != PROTO_OK) {
+    protorejected++;
+    pos = 2;
+  }
+  protobuff[1] = status;
+  protolen = pos;
+  ProtocolReply ();
+}
+
+#endif // ENABLE_BINARY_PROTOCOL
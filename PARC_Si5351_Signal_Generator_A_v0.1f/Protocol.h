@@ -0,0 +1,53 @@
+#ifndef _PROTOCOL_H_
+#define _PROTOCOL_H_
+
+// Binary framed protocol for test equipment.  It shares the serial port with the text CLI.  A frame
+// starts with PROTO_SYNC which is never part of a text command so a frame is recognized when no text
+// command is being entered.  Frames are not echoed.
+//
+//   PROTO_SYNC, length, opcode, payload (length - 1 bytes), CRC-8
+//
+// length counts the opcode and payload.  The CRC-8 (polynomial 0x07, initial value 0) covers length,
+// opcode and payload.  Multi byte values are little endian and frequencies are 64 bit milliHz.
+//
+// Every frame gets one reply, in order, with the same framing.  The reply opcode is the request opcode
+// with PROTO_REPLY set and the first payload byte is a PROTO_ status.  A frame is run and replied to in
+// the loop() pass it is completed in.  Frames can be pipelined: up to PROTO_WINDOW bytes of requests
+// that have not been replied to can be in flight without overflowing the serial receive buffer.
+// A frame that is not completed within PROTO_TIMEOUT_MS is dropped without a reply.  Text such as
+// logged errors can be sent between replies so a host should skip to PROTO_SYNC.
+
+#define PROTO_BAUD          1000000     // Exact on a 16MHz Arduino
+#define PROTO_SYNC          0xA5
+#define PROTO_MAX_PAYLOAD   33
+#define PROTO_TIMEOUT_MS    20
+#define PROTO_WINDOW        64          // HardwareSerial receive buffer
+#define PROTO_REPLY         0x80
+#define PROTO_LIST_ENTRIES  16
+
+// Opcodes and payloads
+#define PROTO_OP_PING       0x01        // -> status, VERSION (2)
+#define PROTO_OP_SET_FREQ   0x02        // clk, mHz (8) -> status
+#define PROTO_OP_SET_CLOCKS 0x03        // clk mask, mHz (8) for each clock in the mask -> status
+#define PROTO_OP_LOAD_LIST  0x04        // index, up to 4 mHz (8) -> status, list length
+#define PROTO_OP_LIST_STEP  0x05        // clk -> status, index used
+#define PROTO_OP_STATUS     0x06        // -> status, flags (4), menu, clock status (3), clock Hz (4 x 3), correction ppb (4)
+#define PROTO_OP_COUNTERS   0x07        // -> status, frames, CRC errors, timeouts, rejected (2 each)
+#define PROTO_OP_LOAD_HOPS  0x08        // index, up to 2 of mask, on, dwell ms (2), mHz (8) -> status, table length. Needs ENABLE_HOP
+#define PROTO_OP_HOP_RUN    0x09        // HOP_ start mode, or 0 to stop -> status. Needs ENABLE_HOP
+#define PROTO_OP_SYMBOLS    0x0A        // BEACON_ mode, index, up to 31 tones -> status, symbols loaded. Needs ENABLE_BEACON
+#define PROTO_OP_BEACON     0x0B        // clk, repeat, tone 0 mHz (8) -> status. No payload stops. Needs ENABLE_BEACON
+
+// Reply status
+#define PROTO_OK            0
+#define PROTO_ERR_LENGTH    1
+#define PROTO_ERR_ARG       2
+#define PROTO_ERR_OPCODE    3
+#define PROTO_ERR_CRC       4
+
+unsigned char ProtocolReceive (unsigned char c, unsigned char textidle);
+void ProtocolPoll (void);
+void ProtocolReply (void);
+unsigned char ProtocolCRC8 (unsigned char crc, unsigned char c);
+
+#endif // _PROTOCOL_H_
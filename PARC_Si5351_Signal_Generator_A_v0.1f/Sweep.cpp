@@ -0,0 +1,252 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to sweep the Si5351 output frequency.
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+*/
+
+#include "Arduino.h"
+
+#include <math.h>
+
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
+#include "VE3OOI_Si5351_v2.1.h"
+#include "i2c.h"
+#include "Timer.h"
+#include "Sweep.h"
+
+#ifdef ENABLE_SWEEP
+
+// The sweep is a list of points from start to stop.  loop() computes the multisynth payload of the
+// next points into a ring while the Timer2 ISR sends one every dwell ms.  Only the registers that
+// differ from the previous point are sent.  A step that is due while the ring is empty or while loop()
+// is in the middle of an I2C transaction is sent on the next tick and counted as late.
+// The ISR lets other interrupts in while it sends so Timer0 (millis), Timer1 (rotary) and the UART
+// are not held off for the length of a transaction.
+Sweep_Config sweepcfg = {SWEEP_DEFAULT_START, SWEEP_DEFAULT_STOP, SWEEP_DEFAULT_N, SWEEP_DEFAULT_DWELL, SWEEP_CONTINUOUS, SWEEP_LINEAR};
+
+Sweep_Step sweepring[SWEEP_AHEAD];
+volatile unsigned char sweephead, sweeptail;
+volatile unsigned char sweepactive, sweepsending;
+volatile unsigned int sweepcountdown;
+volatile unsigned long sweepsteps, sweeplate;
+unsigned long sweepstart, sweepstop;
+
+unsigned char sweepbase;                    // First multisynth register of the clock being swept
+unsigned char sweeplast[SI_MSREGS];         // Payload of the last point computed
+unsigned int sweeppoints;
+long sweepindex;                            // Next point to compute
+signed char sweepdir;
+unsigned char sweepdone;                    // Every point of a single sweep has been computed
+float sweeplogstep;
+
+
+unsigned int SweepPoints (void)
+// Set up the points of the configured sweep. Returns the number of points
+{
+  if (sweepcfg.spacing == SWEEP_STEP) {
+    sweeppoints = ((sweepcfg.start > sweepcfg.stop) ? sweepcfg.start - sweepcfg.stop : sweepcfg.stop - sweepcfg.start) / sweepcfg.n + 1;
+  } else {
+    sweeppoints = (unsigned int)sweepcfg.n;
+  }
+  sweeplogstep = log((float)sweepcfg.stop / (float)sweepcfg.start) / (float)(sweeppoints - 1);
+  return sweeppoints;
+}
+
+unsigned long SweepFrequency (long index)
+// Frequency of a point after SweepPoints()
+{
+  long span = (long)sweepcfg.stop - (long)sweepcfg.start;
+
+  switch (sweepcfg.spacing) {
+    case SWEEP_LOG:
+      return (unsigned long)((float)sweepcfg.start * exp(sweeplogstep * (float)index) + 0.5);
+
+    case SWEEP_STEP:
+      if (span < 0) return sweepcfg.start - index * sweepcfg.n;
+      return sweepcfg.start + index * sweepcfg.n;
+  }
+  return sweepcfg.start + (long)(((long long)span * index) / (sweeppoints - 1));
+}
+
+static void SweepAdvance (void)
+// Move to the next point for the repeat mode
+{
+  sweepindex += sweepdir;
+  if (sweepindex >= (long)sweeppoints) {
+    if (sweepcfg.mode == SWEEP_SINGLE) {
+      sweepdone = 1;
+    } else if (sweepcfg.mode == SWEEP_TRIANGLE) {
+      sweepdir = -1;
+      sweepindex = sweeppoints - 2;
+    } else {
+      sweepindex = 0;
+    }
+  } else if (sweepindex < 0) {
+    sweepdir = 1;
+    sweepindex = 1;
+  }
+}
+
+unsigned char SweepConfigure (unsigned long start, unsigned long stop, unsigned long n, unsigned int dwell, char mode, char spacing)
+// Returns 1 if the sweep is valid.  The sweep is not changed otherwise
+{
+  unsigned long span;
+
+  if (start < SWEEP_MIN_FREQ || start > SWEEP_MAX_FREQ || stop < SWEEP_MIN_FREQ || stop > SWEEP_MAX_FREQ || start == stop) return 0;
+  if (!dwell || dwell > SWEEP_MAX_DWELL) return 0;
+  if (mode != SWEEP_SINGLE && mode != SWEEP_CONTINUOUS && mode != SWEEP_TRIANGLE) return 0;
+
+  span = (start > stop) ? start - stop : stop - start;
+  switch (spacing) {
+    case SWEEP_LINEAR:
+    case SWEEP_LOG:
+      if (n < 2 || n > 0xFFFF) return 0;
+      break;
+
+    case SWEEP_STEP:
+      if (!n || n > span || span / n >= 0xFFFF) return 0;
+      break;
+
+    default:
+      return 0;
+  }
+
+  sweepcfg.start = start;
+  sweepcfg.stop = stop;
+  sweepcfg.n = n;
+  sweepcfg.dwell = dwell;
+  sweepcfg.mode = mode;
+  sweepcfg.spacing = spacing;
+  return 1;
+}
+
+unsigned char SweepStart (unsigned char clk)
+// Start the configured sweep on clk. Returns 0 if Timer2 is in use or clk is not valid
+{
+  if (clk >= MAXCLK || !ClaimTimer2 (TIMER2_SWEEP) || sweepactive) return 0;
+
+  SweepPoints ();
+
+  // The first point sets up the PLL, clock control and output enable. All sweep frequencies use SI_MAX_PLL_FREQ
+  SetFrequency (clk, (clk == SI_CLK1) ? SI_PLL_B : SI_PLL_A, sweepcfg.start);
+  Si5351MSPayload (SI_MAX_PLL_FREQ, sweepcfg.start, sweeplast);
+  sweepbase = SIREG_42_MSYN0_1 + clk * SI_MSREGS;
+
+  sweepindex = 0;
+  sweepdir = 1;
+  sweepdone = 0;
+  SweepAdvance ();
+
+  // Fill the ring before Timer2 starts
+  sweephead = sweeptail = 0;
+  sweepsteps = 1;
+  sweeplate = 0;
+  sweepcountdown = sweepcfg.dwell;
+  sweepactive = 1;
+  SweepPoll ();
+
+  sweepstart = millis();
+  EnableTimers (2, TIMER2_1MS);
+  return 1;
+}
+
+void SweepStop (void)
+// The output is left on the last frequency sent
+{
+  if (!sweepactive) return;
+  ReleaseTimer2 (TIMER2_SWEEP);
+  sweepactive = 0;
+  sweepstop = millis();
+}
+
+void SweepPoll (void)
+// Called from loop(). Compute payloads until the ring is full.  A single sweep stops once its last point was sent
+{
+  Sweep_Step *s;
+  unsigned char regs[SI_MSREGS];
+  unsigned char i, last;
+
+  if (!sweepactive) return;
+
+  while (!sweepdone && (unsigned char)(sweephead - sweeptail) < SWEEP_AHEAD) {
+    Si5351MSPayload (SI_MAX_PLL_FREQ, SweepFrequency (sweepindex), regs);
+    SweepAdvance ();
+
+    s = &sweepring[sweephead & (SWEEP_AHEAD - 1)];
+    s->first = SI_MSREGS;
+    last = 0;
+    for (i=0; i<SI_MSREGS; i++) {
+      s->regs[i] = regs[i];
+      if (regs[i] != sweeplast[i]) {
+        if (s->first == SI_MSREGS) s->first = i;
+        last = i;
+      }
+      sweeplast[i] = regs[i];
+    }
+    s->count = (s->first == SI_MSREGS) ? 0 : last - s->first + 1;
+    sweephead++;
+  }
+
+  if (sweepdone && sweephead == sweeptail) SweepStop ();
+}
+
+void SweepTick (void)
+// Called from the Timer2 ISR every 1ms. Ticks that arrive while a step is being sent still count
+// down its dwell
+{
+  Sweep_Step *s;
+
+  if (!sweepactive) return;
+  if (sweepcountdown > 1) {
+    sweepcountdown--;
+    return;
+  }
+  if (sweepsending) return;
+  if (sweephead == sweeptail || i2cbusy) {
+    sweeplate++;
+    return;
+  }
+
+  sweepsending = 1;
+  s = &sweepring[sweeptail & (SWEEP_AHEAD - 1)];
+  sweepcountdown = sweepcfg.dwell;
+  sei();
+  if (s->count) Si5351RepeatedWriteRegister (sweepbase + s->first, s->count, &s->regs[s->first]);
+  cli();
+  sweeptail++;
+  sweepsteps++;
+  sweepsending = 0;
+}
+
+unsigned long SweepRate (void)
+// Steps per second achieved by the running or last sweep
+{
+  unsigned long ms, steps;
+  unsigned char sreg;
+
+  sreg = SREG;
+  cli();
+  steps = sweepsteps;
+  SREG = sreg;
+
+  ms = (sweepactive ? millis() : sweepstop) - sweepstart;
+  if (!ms) return 0;
+  return (unsigned long)(((unsigned long long)steps * 1000 + ms / 2) / ms);
+}
+
+void SweepReport (void)
+{
+  Serial.print (sweepactive ? F("Sweep: on") : F("Sweep: off"));
+  Serial.print (F(" Steps: "));
+  Serial.print (sweepsteps);
+  Serial.print (F(" Late: "));
+  Serial.print (sweeplate);
+  Serial.print (F(" Steps/s: "));
+  Serial.println (SweepRate());
+}
+
+#endif // ENABLE_SWEEP
@@ -0,0 +1,55 @@
+#ifndef _SWEEP_H_
+#define _SWEEP_H_
+
+// Frequency sweep.  Steps are timed by Timer2 in 1ms ticks.  The PLL is left at SI_MAX_PLL_FREQ and
+// each step only rewrites the registers of the output multisynth that change.  The register payloads
+// are computed in loop() up to SWEEP_AHEAD steps before they are due and sent from the Timer2 ISR.
+
+#define SWEEP_AHEAD         4           // Steps computed ahead of time
+#define SWEEP_MIN_FREQ      1000000UL   // No R_DIV below this
+#define SWEEP_MAX_FREQ      SI_MIN_MSRATIO6_FREQ
+#define SWEEP_MAX_DWELL     60000       // ms
+
+// Repeat modes
+#define SWEEP_SINGLE        'S'         // Start to stop once
+#define SWEEP_CONTINUOUS    'C'         // Start to stop over and over
+#define SWEEP_TRIANGLE      'T'         // Start to stop and back over and over
+
+// Spacing of the steps
+#define SWEEP_LINEAR        'L'         // Linear, number of points given
+#define SWEEP_LOG           'G'         // Logarithmic, number of points given
+#define SWEEP_STEP          'S'         // Linear, step in Hz given
+
+// Default sweep used until one is configured
+#define SWEEP_DEFAULT_START 1000000UL
+#define SWEEP_DEFAULT_STOP  30000000UL
+#define SWEEP_DEFAULT_N     100
+#define SWEEP_DEFAULT_DWELL 10
+
+typedef struct {
+  unsigned long start, stop;
+  unsigned long n;              // Points, or step in Hz for SWEEP_STEP
+  unsigned int dwell;           // ms per step
+  char mode, spacing;
+} Sweep_Config;
+
+// Multisynth registers for one step.  Only count registers from first are sent
+typedef struct {
+  unsigned char first, count;
+  unsigned char regs[SI_MSREGS];
+} Sweep_Step;
+
+extern Sweep_Config sweepcfg;
+extern volatile unsigned char sweepactive;
+
+unsigned char SweepConfigure (unsigned long start, unsigned long stop, unsigned long n, unsigned int dwell, char mode, char spacing);
+unsigned int SweepPoints (void);
+unsigned long SweepFrequency (long index);
+unsigned char SweepStart (unsigned char clk);
+void SweepStop (void);
+void SweepPoll (void);
+void SweepTick (void);
+unsigned long SweepRate (void);
+void SweepReport (void);
+
+#endif // _SWEEP_H_
@@ -21,33 +21,105 @@
 #include "LCD.h"
 #include "Encoder.h"
 #include "Timer.h"
+#include "Trace.h"
+#include "Profile.h"
+#include "VE3OOI_Si5351_v2.1.h"
+#include "Sweep.h"
+#include "Hop.h"
+#include "Beacon.h"
+#include "Keyer.h"
+#include "Counter.h"
 
 extern volatile unsigned long flags;
 
+volatile unsigned long timerticks;      // Compare matches of the timer running the input ISR. Used for time stamps
+volatile unsigned long timerbase;       // Time stamp when the input ISR last moved between Timer1 and Timer2
+volatile unsigned char timerstamp2;     // Set while the input ISR and time stamps run from Timer2
+volatile unsigned char timer2owner;     // TIMER2_ user of the 1ms tick
 
 //////////////////////////////////
-// Timer1 ISR - TBD
+// Input ISR - rotary and push buttons. Run from Timer1 or from Timer2 while Timer1 is the counter
 //////////////////////////////////
-ISR(TIMER1_COMPA_vect)
+static void TimerInputs (void)
 {
-  if (!(flags & DISABLE_BUTTONS)) {
+  PROFILE_START(t);
+  if (!(flags & DISABLE_BUTTONS) && !TRACE_REPLAYING) {
     CheckEncoder();  
     CheckPushButtons ();  
     ReadPBEncoder();
   }
+  PROFILE_END(PROFILE_ISR, t);
+}
+
+//////////////////////////////////
+// Timer1 ISR
+//////////////////////////////////
+ISR(TIMER1_COMPA_vect)
+{
+  timerticks++;
+  TimerInputs ();
 }
 
 
 //////////////////////////////////
-// Timer2 ISR - used for encoder and pushbutton polling. It runs at 3ms
+// Timer2 ISR - used for sweep, hop, beacon and keyer timing. It runs at 1ms while one of them is running.
+// It runs at 0.5ms with the input ISR while Timer1 is the frequency counter
 //////////////////////////////////
 ISR(TIMER2_COMPA_vect)
 {
-
+  switch (timer2owner) {
+#ifdef ENABLE_SWEEP
+    case TIMER2_SWEEP:
+      SweepTick();
+      break;
+#endif // ENABLE_SWEEP
+#ifdef ENABLE_HOP
+    case TIMER2_HOP:
+      HopTick();
+      break;
+#endif // ENABLE_HOP
+#ifdef ENABLE_BEACON
+    case TIMER2_BEACON:
+      BeaconTick();
+      break;
+#endif // ENABLE_BEACON
+#ifdef ENABLE_KEYER
+    case TIMER2_KEYER:
+      KeyerTick();
+      break;
+#endif // ENABLE_KEYER
+#ifdef ENABLE_COUNTER
+    case TIMER2_COUNTER:
+      // The gate is read first.  The input ISR lets the counter time stamps in
+      timerticks++;
+      CounterTick();
+      sei();
+      TimerInputs();
+      break;
+#endif // ENABLE_COUNTER
+  }
 }
 
 
 
+//////////////////////////////////
+// Move the input ISR and time stamps to a timer. Called with interrupts off
+//////////////////////////////////
+static void TimerMoveInputs (unsigned char timer)
+{
+// The time so far is kept in timerbase and the ticks restart on the new timer so stamps carry on from
+// where they were.  The other timer's compare interrupt is turned off so its ticks are not counted
+  timerbase = TimerTimestamp();
+  timerticks = 0;
+  if (timer == 2) {
+    TIMSK1 &= ~(1 << OCIE1A);
+    timerstamp2 = 1;
+  } else {
+    TIMSK2 &= ~(1 << OCIE2A);
+    timerstamp2 = 0;
+  }
+}
+
 //////////////////////////////////
 //  Configure and enable a timer.
 //////////////////////////////////
@@ -62,6 +134,7 @@ void EnableTimers (unsigned char timer, unsigned int count)
       break;
 
     case 1:   // Timer 1 used for input devices (rotary, push buttons, etc)
+      TimerMoveInputs (1);
       TCCR1A = 0;     // reset Timer 5
       TCCR1B = 0;     // TCCRxB turns off timer
       TCNT1 = 0;      // Zero out counter
@@ -85,12 +158,16 @@ void EnableTimers (unsigned char timer, unsigned int count)
       // Set match register to 1795  for 113us (or 8850 Hz) with no prescalar for desired interval
       // for Prescalar 1/64, 27 for 113us, 5500 for 22 ms, 3750 for 15ms, 250 for 1ms
       // Set match register to 1000  for 64ms (or 15.6 Hz) with /1024 prescaller
+      // Timer2 is 8 bits and has its own prescaler table. 249 with /64 is 1ms
       OCR2A = count;                            // set compare match register for interval
-      TCCR2B |= (1 << WGM22);                   // turn on CTC mode
-      TCCR2B |= (1 << CS20) | (1 << CS21);      // Set CSx0/CSx1 for /64 prescaler
-//      TCCR2B |= (1 << CS20) | (1 << CS22);      // Set CSx0/CSx2 for /1024 prescaler
+      TCCR2A |= (1 << WGM21);                   // turn on CTC mode (mode 2, WGM22 is not used)
+      TCCR2B |= (1 << CS22);                    // Set CS22 for /64 prescaler
+//      TCCR2B |= (1 << CS20) | (1 << CS21) | (1 << CS22);      // Set CS20/CS21/CS22 for /1024 prescaler
       TIFR2 |= (1 << OCF2A) | (1 << OCF2B); // Clear Interrupt Flags (write 1)
       TIMSK2 |= (1 << OCIE2A);                  // enable timer compare interrupt:
+#ifdef ENABLE_COUNTER
+      if (timer2owner == TIMER2_COUNTER) TimerMoveInputs (2);
+#endif // ENABLE_COUNTER
       break;
 
   }
@@ -130,3 +207,62 @@ void DisableTimers (unsigned char timer)
   sei();          // enable global interrupts
 
 }
+
+//////////////////////////////////
+// Share the Timer2 1ms tick.
+//////////////////////////////////
+unsigned char ClaimTimer2 (unsigned char owner)
+{
+// Returns 0 if another user has Timer2. The owner starts the tick with EnableTimers (2, TIMER2_1MS)
+// once it is ready for it
+  if (timer2owner != TIMER2_FREE && timer2owner != owner) return 0;
+  timer2owner = owner;
+  return 1;
+}
+
+void ReleaseTimer2 (unsigned char owner)
+{
+  if (timer2owner != owner) return;
+  DisableTimers (2);
+  timer2owner = TIMER2_FREE;
+}
+
+//////////////////////////////////
+// Read a time stamp based on Timer1.
+//////////////////////////////////
+unsigned long TimerTimestamp (void)
+{
+// Returns the time in TIMER_TICK_US units (i.e. Timer1 counts) since the input ISR was enabled.
+// Safe to call from an ISR. The compare match (and ISR) happens one count before the counter
+// wraps to 0.  If the match happened but the ISR has not run yet and the counter has wrapped
+// the missing tick is added here. If the ISR already ran but the counter has not wrapped
+// the early tick is taken off.  While Timer1 is the frequency counter Timer2 (also /64) is read instead
+  unsigned long ticks;
+  unsigned int count, top;
+  unsigned char sreg, pending;
+
+  sreg = SREG;
+  cli();
+  ticks = timerticks;
+#ifdef ENABLE_COUNTER
+  if (timerstamp2) {
+    count = TCNT2;
+    top = OCR2A;
+    pending = TIFR2 & (1 << OCF2A);
+  } else
+#endif // ENABLE_COUNTER
+  {
+    count = TCNT1;
+    top = OCR1A;
+    pending = TIFR1 & (1 << OCF1A);
+  }
+  if (pending) {
+    if (count < (top >> 1)) ticks++;
+  } else if (count == top) {
+    ticks--;
+  }
+  ticks = timerbase + ticks * ((unsigned long)top + 1) + count;
+  SREG = sreg;
+
+  return ticks;
+}
@@ -7,6 +7,23 @@
 #define TIMER500   125         // Counter for 0.5 ms, default 125
 #define TIMER250   63           // Counter for .25 ms, default 63
 
+#define TIMER_TICK_US 4         // Timer1 runs with /64 prescaler, each count is 4 us
+#define TIMER_TICK_CYCLES 64    // CPU cycles per Timer1 count
+
+#define TIMER2_1MS 249          // Timer2 compare value for a 1ms tick with the /64 prescaler
+#define TIMER2_500US 124        // Timer2 compare value for a 0.5ms tick. Runs the input ISR for the counter
+
+// Users of the Timer2 1ms tick.  There is one at a time and it sends to the Si5351 from the ISR
+#define TIMER2_FREE   0
+#define TIMER2_SWEEP  1
+#define TIMER2_HOP    2
+#define TIMER2_BEACON 3
+#define TIMER2_KEYER  4
+#define TIMER2_ANALYZER 5       // No tick. Keeps the others off the Si5351 while the analyzer runs from loop()
+#define TIMER2_COUNTER  6       // Timer1 counts the input so Timer2 takes over its ISR and time stamps
+
+extern volatile unsigned char timer2owner;
+
 // Timer Control Routines
 void EnableTimers (unsigned char timer, unsigned int count);
 void DisableTimers (unsigned char timer);
@@ -14,6 +31,9 @@ void Pause (int dly);
 void DisableTimer0 (void);
 void SaveTimerRegisters (void);
 void RestoreTimerRegisters (void);
+unsigned long TimerTimestamp (void);
+unsigned char ClaimTimer2 (unsigned char owner);
+void ReleaseTimer2 (unsigned char owner);
 
 
 #endif // _TIMER_H_
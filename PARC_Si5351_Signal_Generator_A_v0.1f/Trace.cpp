@@ -0,0 +1,186 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to record and replay input events (rotary & push buttons).
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+*/
+
+#include "Arduino.h"
+
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
+#include "Encoder.h"
+#include "Timer.h"
+#include "Trace.h"
+
+#ifdef ENABLE_INPUT_TRACE
+
+extern volatile unsigned long flags;
+extern volatile unsigned long i2cbytes;
+extern volatile unsigned int i2csum;
+
+// The trace is a ring of input events. When its full the oldest event is overwritten.
+// Events are recorded from the Timer1 ISR after a Reset().  A replay does a Reset() and then
+// feeds the recorded events back into flags at the same relative times so the menu code
+// sees exactly the same input sequence. Each event is injected only after the previous one was
+// processed.  Detents are recorded as the net count the menu code took with GetRotaryCount() and
+// injected as one count, so they are applied in the same steps as recorded.  The Si5351 byte count and checksum
+// are recorded at each event so the register traffic of a recording and its replay can be compared.
+Trace_Struct trace[TRACE_ENTRIES];
+volatile unsigned char tracehead, tracecount;
+volatile unsigned char tracestate;
+unsigned char replayindex;
+unsigned long replaystart;
+
+#define TRACE_IDLE    2
+#define TRACE_INPUT_FLAGS (ROTARY_CW | ROTARY_CCW | ROTARY_PUSH | PBUTTON1_PUSHED | PBUTTON2_PUSHED | MASTER_RESET)
+
+
+void TraceReset (void)
+{
+  unsigned char sreg;
+
+  sreg = SREG;
+  cli();
+  memset ((char *)&trace, 0, sizeof(trace));
+  tracehead = tracecount = 0;
+  tracestate = TRACE_RECORD;
+  i2cbytes = 0;
+  i2csum = 0;
+  SREG = sreg;
+}
+
+void TraceEvent (unsigned char event)
+// Called from the Timer1 ISR when an input flag is set, or with interrupts off
+{
+  if (tracestate != TRACE_RECORD) return;
+
+  trace[tracehead].time = TimerTimestamp();
+  trace[tracehead].i2cbytes = i2cbytes;
+  trace[tracehead].i2csum = i2csum;
+  trace[tracehead].event = event;
+  trace[tracehead].count = 0;
+
+  if (++tracehead >= TRACE_ENTRIES) tracehead = 0;
+  if (tracecount < TRACE_ENTRIES) tracecount++;
+}
+
+void TraceRotary (int count)
+// Called with interrupts off when the menu code takes the net rotary count
+{
+  unsigned char idx;
+
+  if (tracestate != TRACE_RECORD) return;
+
+  TraceEvent ((count > 0) ? TRACE_ROTARY_CW : TRACE_ROTARY_CCW);
+  idx = (tracehead + TRACE_ENTRIES - 1) % TRACE_ENTRIES;
+  trace[idx].count = (count > 0) ? count : -count;        // Up to ROTARY_COUNT_MAX
+}
+
+unsigned char TraceIndex (unsigned char i)
+// Convert event number (0 is the oldest) into ring index
+{
+  return (tracehead + TRACE_ENTRIES - tracecount + i) % TRACE_ENTRIES;
+}
+
+void TraceDump (void)
+{
+  unsigned char i, idx;
+  unsigned long t0, bytes;
+
+  if (!tracecount) {
+    Serial.println (F("No Trace"));
+    return;
+  }
+
+  // Columns: event number, time in us since first event, event, detents, Si5351 bytes sent handling event, checksum
+  t0 = trace[TraceIndex(0)].time;
+  for (i=0; i<tracecount; i++) {
+    idx = TraceIndex(i);
+    if (i+1 < tracecount) bytes = trace[TraceIndex(i+1)].i2cbytes;
+    else bytes = i2cbytes;
+    bytes -= trace[idx].i2cbytes;
+
+    Serial.print (i);
+    Serial.print (' ');
+    Serial.print ((trace[idx].time - t0) * TIMER_TICK_US);
+    Serial.print (' ');
+    Serial.print (trace[idx].event);
+    Serial.print (' ');
+    Serial.print (trace[idx].count);
+    Serial.print (' ');
+    Serial.print (bytes);
+    Serial.print (' ');
+    Serial.println (trace[idx].i2csum, HEX);
+  }
+  if (tracestate == TRACE_REPLAY) Serial.println (F("Replaying"));
+}
+
+void TraceReplay (void)
+{
+  if (!tracecount) {
+    Serial.println (F("No Trace"));
+    return;
+  }
+
+  // Start from the same state as the recording. Reset() leaves the trace alone while replaying
+  tracestate = TRACE_REPLAY;
+  Reset();
+
+  i2cbytes = 0;
+  i2csum = 0;
+  replayindex = 0;
+  replaystart = TimerTimestamp();
+}
+
+void TraceReplayPoll (void)
+// Called from loop(). Inject the next event once its time is reached and the previous one was processed.
+{
+  unsigned char idx, i;
+
+  if (tracestate != TRACE_REPLAY) return;
+  if (flags & TRACE_INPUT_FLAGS) return;
+
+  if (replayindex >= tracecount) {
+    tracestate = TRACE_IDLE;
+    return;
+  }
+
+  idx = TraceIndex(replayindex);
+  if ((TimerTimestamp() - replaystart) < (trace[idx].time - trace[TraceIndex(0)].time)) return;
+
+  // Overwrite the byte count and checksum with the replay values so they can be dumped and compared
+  trace[idx].i2cbytes = i2cbytes;
+  trace[idx].i2csum = i2csum;
+
+  switch (trace[idx].event) {
+    case TRACE_ROTARY_CW:
+      for (i=0; i<trace[idx].count; i++) RotaryDetent (1);
+      break;
+
+    case TRACE_ROTARY_CCW:
+      for (i=0; i<trace[idx].count; i++) RotaryDetent (-1);
+      break;
+
+    case TRACE_ROTARY_PUSH:
+      flags |= ROTARY_PUSH;
+      break;
+
+    case TRACE_PBUTTON1:
+      flags |= PBUTTON1_PUSHED;
+      break;
+
+    case TRACE_PBUTTON2:
+      flags |= PBUTTON2_PUSHED;
+      break;
+
+    case TRACE_MASTER_RESET:
+      flags |= MASTER_RESET;
+      break;
+  }
+  replayindex++;
+}
+
+#endif // ENABLE_INPUT_TRACE
@@ -0,0 +1,44 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#define TRACE_ENTRIES 32        // Size of the input event ring
+
+// Input events recorded in the trace
+#define TRACE_ROTARY_CW       1         // Detents applied together by the menu code
+#define TRACE_ROTARY_CCW      2
+#define TRACE_ROTARY_PUSH     3
+#define TRACE_PBUTTON1        4
+#define TRACE_PBUTTON2        5
+#define TRACE_MASTER_RESET    6
+
+// Trace states
+#define TRACE_RECORD  0
+#define TRACE_REPLAY  1
+
+typedef struct {
+  unsigned long time;           // Timer1 time stamp in TIMER_TICK_US units
+  unsigned long i2cbytes;       // Si5351 bytes sent when event was recorded
+  unsigned int i2csum;          // Si5351 byte checksum when event was recorded
+  unsigned char event;
+  unsigned char count;          // Detents of a rotary event
+} Trace_Struct;
+
+#ifdef ENABLE_INPUT_TRACE
+extern volatile unsigned char tracestate;
+#define TRACE_EVENT(e)    TraceEvent(e)
+#define TRACE_ROTARY(n)   TraceRotary(n)
+#define TRACE_REPLAYING   (tracestate == TRACE_REPLAY)
+#else
+#define TRACE_EVENT(e)    do {} while (0)
+#define TRACE_ROTARY(n)   do {} while (0)
+#define TRACE_REPLAYING   0
+#endif // ENABLE_INPUT_TRACE
+
+void TraceReset (void);
+void TraceEvent (unsigned char event);
+void TraceRotary (int count);
+void TraceDump (void);
+void TraceReplay (void);
+void TraceReplayPoll (void);
+
+#endif // _TRACE_H_
@@ -0,0 +1,113 @@
+/*
+
+  Program Written by Dave Rajnauth, VE3OOI to make Si5351 clocks follow each other.
+
+  Software is licensed (Non-Exclusive Licence) for use by the Peel Amateur Radion Club.
+
+  All other uses licensed under a Creative Commons Attribution 4.0 International License.
+
+*/
+
+#include "Arduino.h"
+
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
+#include "VE3OOI_Si5351_v2.1.h"
+#include "Track.h"
+
+#ifdef ENABLE_TRACKING
+
+extern Sig_Gen_Struct sg;
+
+// Only one level is allowed.  A master does not follow another clock so a retune never has to be chained
+Track_Config trackcfg[MAXCLK] = {{TRACK_NONE, 1, 1, 0}, {TRACK_NONE, 1, 1, 0}, {TRACK_NONE, 1, 1, 0}};
+unsigned char trackchanged;               // Dependents whose frequency changed. Cleared by the display
+
+
+static unsigned char TrackPLL (unsigned char clk)
+// Same PLLs as UpdateFrequency()
+{
+  return (clk == SI_CLK1) ? SI_PLL_B : SI_PLL_A;
+}
+
+unsigned char TrackSet (unsigned char clk, unsigned char master, unsigned int mul, unsigned int div, long offset)
+// Make clk follow master.  A master of TRACK_NONE stops clk following.  Returns 0 if not valid
+{
+  unsigned char i;
+
+  if (clk >= MAXCLK) return 0;
+  if (master == TRACK_NONE) {
+    trackcfg[clk].master = TRACK_NONE;
+    return 1;
+  }
+
+  if (master >= MAXCLK || master == clk || trackcfg[master].master != TRACK_NONE) return 0;
+  if (!mul || !div || mul > TRACK_MAX_RATIO || div > TRACK_MAX_RATIO) return 0;
+  if (offset > MAXIMUM_OFFSET_FREQUENCY || offset < -MAXIMUM_OFFSET_FREQUENCY) return 0;
+  for (i=0; i<MAXCLK; i++) {
+    if (trackcfg[i].master == clk) return 0;
+  }
+
+  trackcfg[clk].master = master;
+  trackcfg[clk].mul = mul;
+  trackcfg[clk].div = div;
+  trackcfg[clk].offset = offset;
+  return 1;
+}
+
+unsigned char TrackStage (unsigned char master, unsigned long freq)
+// Stage the running clocks that follow master at its output frequency freq.  Clocks that are off only have their
+// frequency updated.  Returns 0 if no clock follows master
+{
+  unsigned char clk, found = 0;
+  long long f;
+
+  for (clk=0; clk<MAXCLK; clk++) {
+    if (trackcfg[clk].master != master) continue;
+    found = 1;
+    f = (long long)freq * trackcfg[clk].mul / trackcfg[clk].div + trackcfg[clk].offset;
+    if (f < (long long)LowFrequencyLimit (clk)) f = LowFrequencyLimit (clk);
+    if (f > (long long)HighFrequencyLimit (clk)) f = HighFrequencyLimit (clk);
+
+    // The LO display adds the offset so it is taken off here
+    sg.ClkFreq[clk] = (unsigned long)f - ((sg.ClkMode[clk] == LO_CLK_MODE) ? sg.ClkOffset[clk] : 0);
+    trackchanged |= 1 << clk;
+
+    // Like SetFrequency(), a clock whose dividers are out of range is left as it is
+    if (sg.ClkStatus[clk]) Si5351StageFrequency (clk, TrackPLL (clk), (unsigned long)f);
+  }
+  return found;
+}
+
+unsigned char TrackUpdate (unsigned char master, unsigned long freq)
+// Called by UpdateFrequency() with the output frequency of master.  Returns 0 if no clock follows master.
+// Otherwise master and the clocks following it are sent in one burst without stopping the outputs
+{
+  if (!TrackStage (master, freq)) return 0;
+  Si5351StageFrequency (master, TrackPLL (master), freq);
+  Si5351Commit ();
+  return 1;
+}
+
+void TrackReport (void)
+{
+  unsigned char clk;
+
+  for (clk=0; clk<MAXCLK; clk++) {
+    Serial.print (F("Clk: "));
+    Serial.print (clk);
+    if (trackcfg[clk].master == TRACK_NONE) {
+      Serial.println (F(" Master: none"));
+      continue;
+    }
+    Serial.print (F(" Master: "));
+    Serial.print (trackcfg[clk].master);
+    Serial.print (F(" Mul: "));
+    Serial.print (trackcfg[clk].mul);
+    Serial.print (F(" Div: "));
+    Serial.print (trackcfg[clk].div);
+    Serial.print (F(" Offset: "));
+    Serial.println (trackcfg[clk].offset);
+  }
+}
+
+#endif // ENABLE_TRACKING
@@ -0,0 +1,27 @@
+#ifndef _TRACK_H_
+#define _TRACK_H_
+
+// Clock tracking.  A clock can follow a master clock at master * mul / div + offset, for example the LO of a
+// superhet (offset by the IF) or a BFO.  When UpdateFrequency() retunes a master its dependents are computed
+// and the PLL and multisynth registers of all of them are staged and sent in one I2C burst so they change
+// together.  UpdateFrequencies() stages the dependents of its clocks too so they start with them.  Dependents
+// that are off only have their frequency updated.  Tracking is not kept in memories
+
+#define TRACK_NONE          0xFF        // Clock is not following another
+#define TRACK_MAX_RATIO     1000        // Largest mul and div
+
+typedef struct {
+  unsigned char master;
+  unsigned int mul, div;
+  long offset;                          // Hz
+} Track_Config;
+
+extern Track_Config trackcfg[MAXCLK];
+extern unsigned char trackchanged;
+
+unsigned char TrackSet (unsigned char clk, unsigned char master, unsigned int mul, unsigned int div, long offset);
+unsigned char TrackStage (unsigned char master, unsigned long freq);
+unsigned char TrackUpdate (unsigned char master, unsigned long freq);
+void TrackReport (void);
+
+#endif // _TRACK_H_
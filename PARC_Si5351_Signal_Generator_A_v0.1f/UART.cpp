@@ -13,17 +13,12 @@
 
 #include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
 #include "UART.h"                             // VE3OOI Serial Interface Routines (TTY Commands)
+#include "Protocol.h"
 
-// These variables are defined in UART.cpp and used for Serial interface
-// rbuff is used to store all keystrokes which is parsed by Execute() 
-// commands[] and numbers[] store all characters or numbers entered provided they
-// are separated by spaces.  
+// rbuff is defined in the main program and used for Serial interface
+// rbuff is used to store all keystrokes which are parsed in place by DispatchSerial() 
 // ctr is counter used to process entries
-// command_entries contains the total number of charaters/numbers entered
 extern char rbuff[RBUFF]; 
-extern char commands[MAX_COMMAND_ENTRIES];
-extern unsigned char command_entries;
-extern unsigned long numbers[MAX_COMMAND_ENTRIES];
 extern unsigned char ctr;
 
 extern char prompt[6];
@@ -37,12 +32,13 @@ void FlushSerialInput (void)
 
 void ResetSerial (void) 
 // This routine is used to flush all serial input output and zero out all serial buffers
+// Binary frames may be queued behind a text command so input is kept when the protocol is enabled
 {
+#ifndef ENABLE_BINARY_PROTOCOL
   Serial.flush();
   FlushSerialInput();
+#endif // ENABLE_BINARY_PROTOCOL
   memset(rbuff,0,sizeof(rbuff));
-  memset(numbers,0,sizeof(numbers));
-  memset(commands,0,sizeof(commands));
   ctr = 0;
 }
 
@@ -56,56 +52,179 @@ void ProcessSerial ( void )
     // The idea here is that you keep processing characters until none are left.
     // This routine is faster that a user's typing and it needs to check for CR/LF 
     while (Serial.available() > 0) {
-      
-        if (ctr < sizeof(rbuff)) {
-            temp = Serial.read();       // Read a character
-            Serial.write(temp);         // Echo the character back to the user
-            if (isPrintable (temp)) {   // If the character is alphabetic than store it in the buffer
-              rbuff[ctr++] = temp;
-            } else if (temp == 0xD || temp == 0xA) {    // If the character is not printable and its a CR/LF then process the buffer
-              if (ctr) {
-                 Serial.println ("");
-                 ExecuteSerial (rbuff);
-                 ResetSerial ();
-                 Serial.write (prompt);
-              }
-            }
-        }
-        // This checks to see if the users has entered too much data which would overflew the serial buffer
-        // the UART.h file details the MAX number of characters
-        if (ctr > sizeof(rbuff)) {
-            Serial.println ("Overflow");
+        temp = Serial.read();       // Read a character
+#ifdef ENABLE_BINARY_PROTOCOL
+        // Binary frames can start between text commands. They are not echoed
+        if (ProtocolReceive ((unsigned char)temp, !ctr)) continue;
+#endif // ENABLE_BINARY_PROTOCOL
+        Serial.write(temp);         // Echo the character back to the user
+        if (isPrintable (temp)) {   // If the character is alphabetic than store it in the buffer
+          // This checks to see if the users has entered too much data which would overflew the serial buffer
+          // One byte is kept for the terminator. the UART.h file details the MAX number of characters
+          if (ctr >= sizeof(rbuff) - 1) {
+            Serial.println (ovflmsg);
             ResetSerial ();
             Serial.write (prompt); 
             break;
-        } 
+          }
+          rbuff[ctr++] = temp;
+        } else if (temp == 0xD || temp == 0xA) {    // If the character is not printable and its a CR/LF then process the buffer
+          if (ctr) {
+             rbuff[ctr] = 0;
+             Serial.println ("");
+             ExecuteSerial (rbuff);
+             ResetSerial ();
+             Serial.write (prompt);
+          }
+        }
     }
 
 }
 
-unsigned char ParseSerial ( char *str )
-// This routine is used to parse all character and numbers in the serial buffer (str pointer)
-//  Characters are entered into the ccmmands[] array and numbers are entered into the numbers[] array.
+static unsigned char IsSeparator (char c)
+{
+  return (c == ' ' || c == ',');
+}
+
+static char *ParseUnsigned (char *str, unsigned long *v)
+// Returns a pointer after the digits or 0 if there are no digits or the number is too big
+{
+  unsigned long num = 0;
+  unsigned char d;
+  char *start = str;
+
+  while (isdigit (*str)) {
+    d = *str++ - '0';
+    if (num > 429496729UL || (num == 429496729UL && d > 5)) return 0;
+    num = num * 10 + d;
+  }
+  *v = num;
+  return (str == start) ? 0 : str;
+}
+
+static char *ParseSigned (char *str, long *v)
+{
+  unsigned long num;
+  unsigned char neg = (*str == '-');
+
+  if (*str == '-' || *str == '+') str++;
+  str = ParseUnsigned (str, &num);
+  if (!str || num > 0x7FFFFFFFUL + neg) return 0;
+  *v = neg ? (long)(0UL - num) : (long)num;
+  return str;
+}
+
+static char *ParseMilliHz (char *str, uint64_t *v)
+// Frequency in Hz with up to 3 decimals.  The Hz are parsed with 32 bit arithmetic
+{
+  unsigned long hz;
+  unsigned int frac = 0;
+  unsigned char places = 0;
+
+  str = ParseUnsigned (str, &hz);
+  if (!str) return 0;
+  if (*str == '.') {
+    str++;
+    while (isdigit (*str)) {
+      if (++places > 3) return 0;
+      frac = frac * 10 + (*str++ - '0');
+    }
+    if (!places) return 0;
+  }
+  for (; places<3; places++) frac *= 10;
+  *v = (uint64_t)hz * 1000 + frac;
+  return str;
+}
+
+unsigned char ParseSerial ( char *str, const char *spec, CLIArg *arg )
+// This routine parses the arguments after the command letter in one pass over the serial buffer (str pointer)
+// without copying it.  spec has one CLI_ARG_ type per argument.  Arguments are separated by spaces or commas.
+// Returns the number of arguments or CLI_ARG_ERROR plus the index of a bad or extra argument
 {
-	static unsigned char i, j, k;        // Misc counters used, i is for serial buffer, j is for commands[], k is for numbers[]
-        memset(numbers,0,sizeof(numbers));   // Flush out the arrays
-        memset(commands,0,sizeof(commands));
-        
-	for (i=0, j=0, k=0; i<strlen(str); i++) {        // Step through the serial buffer - str is a pointer to the serial buffer
-		if ( isalpha( str[i] ) ) {               // Its alphabetic so store it in commands[]
-			commands[j++] = toupper(str[i]);
-		} else if ( isdigit( str[i] ) ) {
-			numbers[k++] = strtol ( (char *)&str[i], NULL, 10 );
-			while ( isdigit( str[i+1] ) ) {
-				if (i >= strlen(str)) break;
-				i++;
-			}
-		} else if ( isgraph( str[i] ) ) {
-			commands[j++] = str[i];
-		}
-	}
-	return j;
+  unsigned char n;
+
+  memset (arg, 0, CLI_MAX_ARGS * sizeof(CLIArg));
 
+  for (n=0; ; n++) {
+    while (IsSeparator (*str)) str++;
+    if (!*str) return n;
+
+    switch (spec[n]) {
+      case CLI_ARG_UNSIGNED:
+        str = ParseUnsigned (str, &arg[n].u);
+        break;
+
+      case CLI_ARG_SIGNED:
+        str = ParseSigned (str, &arg[n].s);
+        break;
+
+      case CLI_ARG_MHZ:
+        str = ParseMilliHz (str, &arg[n].mhz);
+        break;
+
+      case CLI_ARG_CHAR:
+        arg[n].c = toupper (*str++);
+        break;
+
+      case CLI_ARG_TEXT:
+        arg[n].str = str;
+        while (*str && !IsSeparator (*str)) str++;
+        if (*str) *str++ = 0;
+        continue;
+
+      case CLI_ARG_REST:
+        arg[n].str = str;
+        str += strlen (str);
+        continue;
+
+      default:              // More arguments than the spec
+        return CLI_ARG_ERROR + n;
+    }
+
+    // Each argument must end at a separator or the end of the buffer
+    if (!str || (*str && !IsSeparator (*str))) return CLI_ARG_ERROR + n;
+  }
+}
+
+void DispatchSerial ( char *str, const CLICommand *table, unsigned char entries )
+// Look up the command letter in the PROGMEM command table, parse its arguments and call its handler
+{
+  CLICommand cmd;
+  CLIArg arg[CLI_MAX_ARGS];
+  unsigned char i, n;
+  char name;
+
+  while (IsSeparator (*str)) str++;
+  if (!*str) return;
+  name = toupper (*str++);
+
+  for (i=0; i<entries; i++) {
+    if (pgm_read_byte (&table[i].name) == name) break;
+  }
+  if (i == entries) {
+    ErrorOut ();
+    return;
+  }
+  memcpy_P (&cmd, &table[i], sizeof(cmd));
+
+  n = ParseSerial (str, cmd.spec, arg);
+  if (n & CLI_ARG_ERROR) {
+    Serial.print (F("Bad Arg "));
+    Serial.println ((n & ~CLI_ARG_ERROR) + 1);
+    return;
+  }
+  if (n < cmd.minargs) {
+    Serial.println (F("Missing Arg"));
+    return;
+  }
+
+  cmd.handler (arg, n);
+}
+
+unsigned long CLIHz ( CLIArg *arg )
+// CLI_ARG_MHZ argument rounded to Hz
+{
+  return (unsigned long)((arg->mhz + 500) / 1000);
 }
 
 void ErrorOut ( void )
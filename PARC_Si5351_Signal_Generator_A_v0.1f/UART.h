@@ -3,12 +3,42 @@
 
 
 #define RBUFF 40		// Max RS232 Buffer Size
-#define MAXIMUM_DIGITS 6	// Max numerical digits to process
-#define MAX_COMMAND_ENTRIES 6 
+#define CLI_MAX_ARGS 6		// Max arguments after the command letter
+
+// Argument types used in the command table argument specs
+#define CLI_ARG_UNSIGNED 'u'	// unsigned long
+#define CLI_ARG_SIGNED 's'	// long, optional + or -
+#define CLI_ARG_MHZ 'm'		// Frequency in Hz with up to 3 decimals stored in milliHz, e.g. 7100000.125
+#define CLI_ARG_CHAR 'c'	// Single character, converted to upper case
+#define CLI_ARG_TEXT 'a'	// Word, terminated in place in the serial buffer
+#define CLI_ARG_REST 'r'	// Rest of the line including separators. Must be the last argument
+
+#define CLI_ARG_ERROR 0x80	// ParseSerial() returns this plus the index of the bad or extra argument
+
+// Arguments are parsed in place from rbuff into one of these according to the argument spec
+typedef union {
+  unsigned long u;
+  long s;
+  uint64_t mhz;
+  char c;
+  char *str;
+} CLIArg;
+
+// Command table entry. The table is kept in PROGMEM.  spec has one CLI_ARG_ type per argument and
+// minargs are required.  Arguments not entered are zero.  handler is passed the parsed arguments and
+// the number entered
+typedef struct {
+  char name;
+  unsigned char minargs;
+  char spec[CLI_MAX_ARGS+1];
+  void (*handler)(CLIArg *arg, unsigned char n);
+} CLICommand;
 
 
 void ProcessSerial ( void );
-unsigned char ParseSerial ( char *str );
+unsigned char ParseSerial ( char *str, const char *spec, CLIArg *arg );
+void DispatchSerial ( char *str, const CLICommand *table, unsigned char entries );
+unsigned long CLIHz ( CLIArg *arg );
 void ResetSerial (void);
 void ErrorOut ( void );
 void FlushSerialInput (void);
@@ -3,9 +3,33 @@
 
 #define REMOVE_CLI
 #define ENABLE_SWAP_VFO
+//#define ENABLE_INPUT_TRACE      // Record rotary/button events for dump & replay over CLI. Needs CLI
+//#define ENABLE_LATENCY_STATS    // Histogram of rotary detent to Si5351 update latency. Needs CLI
+//#define ENABLE_PROFILER         // Time spent in ISR, loop, Si5351 and LCD routines. Needs CLI
+//#define ENABLE_FAST_BOOT        // Restore the last outputs at power up before the LCD is set up. No splash
+//#define ENABLE_LCD_BENCHMARK    // Same display session timed on each LCD backend. Needs CLI
+//#define ENABLE_BINARY_PROTOCOL  // Binary framed protocol for test equipment at PROTO_BAUD. Needs CLI
+//#define ENABLE_SWEEP            // Timer2 paced frequency sweep from the menu or CLI
+//#define ENABLE_HOP              // Timer2 paced hop table playback with an external trigger on D2. Needs CLI
+//#define ENABLE_BEACON           // WSPR encoder and WSPR/FT8/JT65 symbol player timed by Timer2. Needs CLI
+//#define ENABLE_FT8              // Standard FT8 message encoder for the beacon. About 1KB of LDPC generator in flash
+//#define ENABLE_JT65             // Standard JT65 message encoder for the beacon
+//#define ENABLE_KEYER            // CW keyer on D3/D4 keying a clock through the output enable register. Needs CLI
+//#define ENABLE_ANALYZER         // Scalar network analyzer with a log detector on A0. Uses the sweep. Needs CLI
+//#define ENABLE_COUNTER          // Frequency counter on T1 (D5, PBUTTON1 is not used) from the menu or CLI
+//#define ENABLE_AUTO_CALIBRATION // Least squares crystal correction from measured outputs. Needs CLI
+//#define ENABLE_TRACKING         // Clocks follow a master clock and are retuned together in one I2C burst. Needs CLI
+
+#if defined(ENABLE_ANALYZER) && !defined(ENABLE_SWEEP)
+#define ENABLE_SWEEP                    // The analyzer measures the points of the configured sweep
+#endif
+
+#if (defined(ENABLE_FT8) || defined(ENABLE_JT65)) && !defined(ENABLE_BEACON)
+#define ENABLE_BEACON                   // The encoders fill the beacon symbol table
+#endif
 
 #define MEM_ID 0xFEEFFACE
-#define VERSION 0xA1E
+#define VERSION 0xA1F
 
 typedef struct {
   unsigned long flags;
@@ -14,7 +38,7 @@ typedef struct {
   long ClkOffset[3];
   unsigned char ClkMode[3];
   unsigned char ClkStatus[3];
-  int correction;   // can be + or -
+  long correction;  // Crystal correction in ppb, can be + or -
 } Sig_Gen_Struct;
 
 // Mode Specific Flags
@@ -33,6 +57,8 @@ typedef struct {
 #define MEMORY_SAVE_MODE      0x80
 #define MEMORY_RECALL_MODE    0x100
 #define CLI_MODE              0x200
+#define SWEEP_MODE            0x400
+#define COUNTER_MODE          0x800
 
 #define ROTARY_CW             0x1000
 #define ROTARY_CCW            0x2000
@@ -45,10 +71,36 @@ typedef struct {
 
 #define MAX_MESSAGES 2
 #define MAX_MEMORIES 4
+#define MEM_ADDRESS(i) ((i) * sizeof(Sig_Gen_Struct))   // Memories are kept in EEPROM only
 #define AUTOSAVE_MEMORY_MS 2000
+#define AUTOSAVE_POLL_MS 100
+
+// Boot record used by the fast boot. It is sg (with the output status) followed by the menu option
+// of the clock window the outputs were turned on from. It is stored in EEPROM after the memories
+#define BOOT_RECORD_ADDRESS MEM_ADDRESS(MAX_MEMORIES)
+#define BOOT_MENU_ADDRESS   (BOOT_RECORD_ADDRESS + sizeof(Sig_Gen_Struct))
+#define BOOT_NO_OUTPUTS     0xFE        // sg from the boot record, outputs off
+#define BOOT_NO_RECORD      0xFF        // sg from memory 0
+
+// Frequency display is refreshed at most every LCD_REFRESH_MS (25Hz) while tuning
+#define LCD_REFRESH_MS 40
+#define LCD_PENDING_CLK   0x1
+#define LCD_PENDING_IQ    0x2
+
+// Maximum time loop() spends sending characters to the LCD on each pass
+#define LCD_FLUSH_BUDGET_US 1000
 
 #define MAXCLK 3
 
+// Serial port. The binary protocol runs the text CLI at its baud rate too
+#ifdef ENABLE_BINARY_PROTOCOL
+#define SERIAL_BAUD PROTO_BAUD
+#elif defined(ENABLE_ANALYZER)
+#define SERIAL_BAUD 115200              // Analyzer points are sent as fast as they are measured
+#else
+#define SERIAL_BAUD 9600
+#endif // ENABLE_BINARY_PROTOCOL
+
 // Mesages
 #define NESSAGE1 20
 #define HEADER1 20
@@ -75,7 +127,7 @@ typedef struct {
 #define DEFAULT_HIGH_FREQUENCY_LIMIT        110000000UL     // was 114000000UL
 
 #define SI_MAX_IQ_OUT_FREQ     80000000UL
-#define SI_MIN_IQ_OUT_FREQ     3000000UL
+#define SI_MIN_IQ_OUT_FREQ     3016000UL       // SI_VERY_MIN_PLL_FREQ / 126, the largest I/Q multiplier
 
 #define DEFAULT_OFFSET_INCREMENT 1000000
 #define DEFAULT_CALIBRATION_INCREMENT 10
@@ -83,12 +135,24 @@ typedef struct {
 #define MINIMUM_OFFSET_MULTIPLIER 1
 #define MAXIMUM_CALIBRATION_MULTIPLIER 100
 #define MINIMUM_CALIBRATION_MULTIPLIER 1
+#define MAXIMUM_CORRECTION 100000              // ppb
+#define CORRECTION_ROTARY_PPB 100              // ppb per calibration menu step
 
 #define MAXIMUM_OFFSET_FREQUENCY 50000000
 #define MINIMUM_OFFSET_FREQUENCY 100000
 
-// Menu Options
-#define MAXMENU_ITEMS 9
+// Menu Options. The optional items follow RESET
+#ifdef ENABLE_SWEEP
+#define MENU_SWEEP_ITEMS 1
+#else
+#define MENU_SWEEP_ITEMS 0
+#endif // ENABLE_SWEEP
+#ifdef ENABLE_COUNTER
+#define MENU_COUNTER_ITEMS 1
+#else
+#define MENU_COUNTER_ITEMS 0
+#endif // ENABLE_COUNTER
+#define MAXMENU_ITEMS (9 + MENU_SWEEP_ITEMS + MENU_COUNTER_ITEMS)
 #define MAXMENU_LEN 12
 
 #define VFO_ENABLE 0
@@ -100,6 +164,8 @@ typedef struct {
 #define RECALL 6
 #define CLI_ENABLE 7
 #define RESET 8
+#define SWEEP 9
+#define COUNTER (9 + MENU_SWEEP_ITEMS)
 
 void ExecuteSerial (char *str);
 void Reset (void);
@@ -111,13 +177,18 @@ void MenuDisplayMode(void);
 void MenuClockWindowMode(void);
 void MenuClockFrequencyMode(void);
 void RefreshLCD (void);
+void RefreshFrequencyDisplay (unsigned char force);
 void GetRotaryNumber (int lnum, int hnum, int maxinc, unsigned char row, unsigned char pos);
 
 unsigned long LowFrequencyLimit (unsigned char line);
 unsigned long HighFrequencyLimit (unsigned char line);
 
 void EnableFrequency (unsigned char line);
+unsigned long OutputFrequency (unsigned char line);
 void UpdateFrequency (unsigned char line);
+void StageFrequencies (unsigned char mask);
+void UpdateFrequencies (unsigned char mask);
+void TuneFrequencies (unsigned char mask);
 void UpdateIQFrequency (unsigned char line);
 
 void DisableFrequency (unsigned char line);
@@ -125,11 +196,20 @@ unsigned int GetPLLFreq(unsigned long freq);
 
 unsigned char FrequencyDigitUpdate (long inc);
 void MenuClockFrequencyOffsetMode (void);
+void MenuSweepMode (void);
+void MenuCounterMode (void);
 
-void SetMemClkStatus (unsigned char stat, unsigned char index);
+void MemSave (unsigned char index);
+unsigned char MemRecall (unsigned char index, Sig_Gen_Struct *m);
 
 long absl (long v);
 
+void FastBoot (void);
+void BootDisplay (unsigned char menu);
+void AutosaveBoot (void);
+unsigned int BootChecksum (void);
+
 void printMem (unsigned char i);
+void printMemValues (const __FlashStringHelper *name, long *v);
 
 #endif // _MAIN_H_
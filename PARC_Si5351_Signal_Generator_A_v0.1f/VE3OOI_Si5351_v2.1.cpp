@@ -13,8 +13,12 @@
 #include <avr/eeprom.h>
 #include "Arduino.h"
 
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
 #include "VE3OOI_Si5351_v2.1.h"         // VE3OOI Si5351 Routines
 #include "i2c.h"
+#include "Timer.h"
+#include "Profile.h"
+#include "Log.h"
 
 
 //#define DEBUG_PRINT               
@@ -27,7 +31,8 @@ volatile unsigned char clkenable;
 volatile unsigned int oldmult;
 volatile unsigned long MS_P1, MS_P2, MS_P3;
 volatile unsigned long MS_a, MS_b, MS_c;
-volatile unsigned long Fxtal, Fxtalcorr;
+volatile unsigned long Fxtal;
+unsigned long long Fxtalcorr;               // Corrected crystal frequency in mHz so a ppb correction is not rounded off
 
 volatile unsigned int mult;
 volatile unsigned long long accum;
@@ -35,11 +40,32 @@ volatile unsigned long long accum;
 unsigned int R_DIV;
 unsigned char MS_DIVBY4;
 unsigned char Si5351RegBuffer[10];
+
+// Shadow of registers 26 to 65.  Si5351RepeatedWriteRegister() keeps it up to date.  Si5351Stage() puts
+// changes in it and a commit sends them from the first to the last changed register in one burst
+unsigned char si5351shadow[SI_SHADOW_LEN];
+unsigned char si5351shadowvalid;            // Bit per block of SI_MSREGS that matches the chip
+unsigned char si5351staged;                 // Blocks with changes not sent yet
+unsigned char si5351stagefirst = SI_SHADOW_LEN, si5351stagelast;
+unsigned char si5351live;                   // Clocks set up and not turned off since
+unsigned char si5351stageclks;              // Clocks staged since the last commit
+unsigned char si5351stagectl[MAXCLK];       // and their clock control registers
+unsigned char si5351stagephase[MAXCLK];     // and their phase registers
+
+// Phase of each clock in degrees and the phase registers on the chip.  The frequency and PLL frequency each
+// clock was last set to are kept so a phase can be changed on its own
+unsigned int si5351phase[MAXCLK];
+unsigned char si5351phasereg[MAXCLK];
+unsigned long si5351clkfreq[MAXCLK], si5351clkpllfreq[MAXCLK];
+
+// I/Q clocks set up by SetIQFrequency(). They divide iqpll by the even integer iqmult. 0 if not set up
+unsigned char iqmult, iqclk, iqclk2, iqpll;
 double fraction; 
 
 
-void setupSi5351 (int correction)
+void setupSi5351 (long correction)
 {
+  unsigned char i;
 
   i2cInit();
 
@@ -56,16 +82,30 @@ void setupSi5351 (int correction)
 
   // Define XTAL frequency. For Aadfruit it 25 Mhz.
   Fxtal =  SI_CRY_FREQ_25MHZ;
-  Fxtalcorr = Fxtal + (long) ((double)(correction / 10000000.0) * (double) Fxtal);
+  SetSi5351Correction (correction);
 
   ResetSi5351();  
 
   while (CheckSi5351Status() & SI_NOT_INITIALIZED);
 
+  // Start the shadow from the chip so staged changes are always sent in one burst
+  for (i=0; i<SI_SHADOW_LEN; i++) si5351shadow[i] = Si5351ReadRegister (SI_SHADOW_FIRST + i);
+  si5351shadowvalid = (1 << (SI_SHADOW_LEN / SI_MSREGS)) - 1;
+  si5351staged = 0;
+  si5351stagefirst = SI_SHADOW_LEN;
+  si5351stagelast = 0;
+}
+
+void SetSi5351Correction (long correction)
+// Crystal correction in ppb.  Takes effect when the PLLs are next programmed
+{
+  Fxtalcorr = (unsigned long long)Fxtal * 1000 + ((long long)Fxtal * correction) / 1000000;
 }
 
 void ResetSi5351 (void) 
 {
+  unsigned char i;
+
   // Disable clock outputs
   Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, 0xFF);  // Each bit corresponds to a clock outpout.  1 to disable, 0 to enable
 
@@ -74,15 +114,19 @@ void ResetSi5351 (void)
   Si5351WriteRegister (SIREG_17_CLK1_CTL, 0x80);          // PLLB, CLK Powered off, MS Fractional Mode, Clk not inverted, Multisynthx, 8mA Drive
   Si5351WriteRegister (SIREG_18_CLK2_CTL, 0x80);          // PLLA, CLK Powered off, MS Fractional Mode, Clk not inverted, Multisynthx, 8mA Drive
 
-  // Reset phase registers
-  UpdatePhaseRegister(SI_CLK0, 0);
-  UpdatePhaseRegister(SI_CLK1, 0);
-  UpdatePhaseRegister(SI_CLK2, 0);
+  // Reset phase registers. The PLL reset below applies them
+  for (i=0; i<MAXCLK; i++) {
+    si5351phase[i] = si5351phasereg[i] = 0;
+    si5351clkfreq[i] = si5351clkpllfreq[i] = 0;
+  }
+  Si5351RepeatedWriteRegister (SIREG_165_CLK0_PHASE_OFFSET, MAXCLK, si5351phasereg);
 
   ResetSi5351PLL (SI_PLL_AB);
 
   clkenable = clkreg = base = base2 = MS_DIVBY4 = 0;
   clkreg0 = clkreg1 = clkreg2 = 0;
+  si5351live = si5351stageclks = 0;
+  iqmult = 0;
   MS_P1 = MS_P2 = MS_P3 = 0;
   MS_a =  MS_b = MS_c = 0;
   R_DIV = 0;
@@ -155,6 +199,7 @@ void PowerDownSi5351Clock (unsigned char clk)
 // This routine turns off CLKs by setting the corresponding bit in the CLK control register
 {
   unsigned char reg;
+  si5351live &= ~(1 << clk);
   switch (clk) {
     case SI_CLK0:
       reg = Si5351ReadRegister (SIREG_16_CLK0_CTL);
@@ -182,6 +227,7 @@ void PowerDownSi5351Clock (unsigned char clk)
 void DisableSi5351Clock (unsigned char clk)
 {
   unsigned char reg;
+  si5351live &= ~(1 << clk);
   reg = Si5351ReadRegister (SIREG_3_OUTPUT_ENABLE_CTL);
   
   switch (clk) {
@@ -229,9 +275,18 @@ void EnableUpSi5351Clock (unsigned char clk)
 }
 
 
+static void Si5351WritePhase (unsigned char clk, unsigned char reg)
+// Phase register of clk.  Not sent if the chip has it already
+{
+  if (reg == si5351phasereg[clk]) return;
+  Si5351WriteRegister (SIREG_165_CLK0_PHASE_OFFSET + clk, reg);
+  si5351phasereg[clk] = reg;
+}
+
 void ProgramSi5351MSN (unsigned char clk, unsigned char pll, unsigned long pllfreq, unsigned long freq)
 {
   unsigned long freq_temp;
+  PROFILE_START(t);
 
   // The ValidateFrequency() call checks if frequency is below 1 Mhz or above 100 Mhz or above 150 Mhz.  See note above for frequencies below 1 Mhz or above 150 Mhz.  Frequencies
   // between 100 Mhz and 150 Mhz can be easily done using an integer multipler (i.e. use a fixed multipler of 6 - 6x100 Mhx is 600 Mhz which is inside PLL frequency requirement
@@ -241,8 +296,8 @@ void ProgramSi5351MSN (unsigned char clk, unsigned char pll, unsigned long pllfr
   MS_a = (unsigned long)accum;
  
   if (MS_a < SI5351_MULTISYNTH_A_MIN || MS_a > SI5351_MULTISYNTH_A_MAX) {
-    Serial.print ("MS DIV ERR: ");
-    Serial.println (MS_a);
+    LogEvent (LOG_MS_DIV, MS_a);
+    PROFILE_END(PROFILE_MSN, t);
     return;
   }
 
@@ -336,7 +391,9 @@ void ProgramSi5351MSN (unsigned char clk, unsigned char pll, unsigned long pllfr
   // Write the values to the corresponding register
   Si5351RepeatedWriteRegister(base, 8, Si5351RegBuffer);
 
-  ResetSi5351PLL (SI_PLL_AB);  
+  // Phase register for the new divider. The reset applies it
+  if (clk < MAXCLK) Si5351WritePhase (clk, Si5351PhaseOffset (pllfreq, freq, si5351phase[clk]));
+  ResetSi5351PLL (SI_PLL_AB);
 
   // clkreg is the actual data that will be written to the clock control register and we need to build it up based on parameters 
   clkreg = 0;    
@@ -374,7 +431,8 @@ void ProgramSi5351MSN (unsigned char clk, unsigned char pll, unsigned long pllfr
   // "SI_CLK_2MA" is the actual value that is used to set appropriate bits in the clock control register
   // clkreg is the variable that has the actual data that will be written to the clock control register
   clkreg |= SI_CLK_8MA;
- 
+  if (clk < MAXCLK && si5351phase[clk] >= SI_MAX_PHASE / 2) clkreg |= SI_CLK_INVERT;
+
   // Update clk control based on above settings
   if (clk == SI_CLK0) {
     UpdateClkControlRegister (SI_CLK0);
@@ -393,7 +451,12 @@ void ProgramSi5351MSN (unsigned char clk, unsigned char pll, unsigned long pllfr
   }
 
   Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, clkenable);
- 
+  si5351live |= 1 << clk;
+  if (clk < MAXCLK) {
+    si5351clkfreq[clk] = freq;
+    si5351clkpllfreq[clk] = pllfreq;
+  }
+
 #ifdef DEBUG_PRINT
   clkreg = ReadClkControlRegister (clk);    
   clkenable = Si5351ReadRegister (SIREG_3_OUTPUT_ENABLE_CTL);    
@@ -406,44 +469,289 @@ void ProgramSi5351MSN (unsigned char clk, unsigned char pll, unsigned long pllfr
   Serial.println (" ");
 #endif   
 
+  PROFILE_END(PROFILE_MSN, t);
+}
+
+
+void Si5351MSPayload (unsigned long pllfreq, unsigned long freq, unsigned char *regs)
+// Multisynth registers for a fractional divider of pllfreq/freq with R_DIV and divide by 4 off. Same encoding
+// as ProgramSi5351MSN() but no globals are used so payloads can be computed ahead of time in loop()
+{
+  Si5351MSEncode (pllfreq / freq, (unsigned long)(((unsigned long long)(pllfreq % freq) * SI_MAX_DIVIDER) / freq), SI_MAX_DIVIDER, regs);
+}
 
+void Si5351MSEncode (unsigned long a, unsigned long b, unsigned long c, unsigned char *regs)
+// Multisynth registers for a divider of a + b/c with R_DIV and divide by 4 off.  c is 1 to SI_MAX_DIVIDER
+{
+  unsigned long t, p1, p2, p3;
+
+  t = (128 * b) / c;
+  p1 = 128 * a + t - 512;
+  p2 = 128 * b - c * t;
+  p3 = c;
+
+  regs[0] = (p3 & 0x0000FF00) >> 8;
+  regs[1] = (p3 & 0x000000FF);
+  regs[2] = (p1 & 0x00030000) >> 16;
+  regs[3] = (p1 & 0x0000FF00) >> 8;
+  regs[4] = (p1 & 0x000000FF);
+  regs[5] = ((p3 & 0x000F0000) >> 12) | ((p2 & 0x000F0000) >> 16);
+  regs[6] = (p2 & 0x0000FF00) >> 8;
+  regs[7] = (p2 & 0x000000FF);
+}
+
+unsigned char Si5351PLLPayload (unsigned long pllfreq, unsigned char *regs)
+// Feedback multisynth registers for pllfreq from the corrected crystal. Same encoding as ProgramSi5351PLL()
+// but no globals are used.  Returns 0 if the divider is out of range
+{
+  unsigned long long x;
+  unsigned long a;
+
+  if (!Fxtalcorr) return 0;
+  x = (unsigned long long)pllfreq * 1000;
+  a = (unsigned long)(x / Fxtalcorr);
+  if (a < SI5351_PLL_MULTISYNTH_A_MIN || a > SI5351_PLL_MULTISYNTH_A_MAX) return 0;
+  Si5351MSEncode (a, (unsigned long)(((x % Fxtalcorr) * SI_MAX_DIVIDER) / Fxtalcorr), SI_MAX_DIVIDER, regs);
+  return 1;
+}
+
+static void Si5351StageClock (unsigned char clk, unsigned char pll, unsigned long pllfreq, unsigned long freq, unsigned char *pllregs, unsigned char *regs, unsigned char ctl)
+// Stage the PLL and multisynth registers of clk at freq from a PLL at pllfreq with its phase
+{
+  if (si5351phase[clk] >= SI_MAX_PHASE / 2) ctl |= SI_CLK_INVERT;
+
+  Si5351Stage ((pll == SI_PLL_B) ? SIREG_34_MSNB_1 : SIREG_26_MSNA_1, pllregs);
+  Si5351Stage (SIREG_42_MSYN0_1 + clk * SI_MSREGS, regs);
+  si5351stageclks |= 1 << clk;
+  si5351stagectl[clk] = ctl;
+  si5351stagephase[clk] = Si5351PhaseOffset (pllfreq, freq, si5351phase[clk]);
+  si5351clkfreq[clk] = freq;
+  si5351clkpllfreq[clk] = pllfreq;
+  iqmult = 0;
+}
+
+unsigned char Si5351StageFrequency (unsigned char clk, unsigned char pll, unsigned long freq)
+// Stage clk at freq from pll with the same PLL frequency, R_DIV, divide by 4 and clock control as SetFrequency().
+// Nothing is staged and 0 is returned if a divider is out of range
+{
+  unsigned long pllfreq, msfreq;
+  unsigned char rdiv, ctl, pllregs[SI_MSREGS], regs[SI_MSREGS];
+
+  if (freq > SI_MAX_OUT_FREQ) {
+    freq = SI_MAX_OUT_FREQ;
+  } else if (freq < SI_MIN_OUT_FREQ) {
+    freq = SI_MIN_OUT_FREQ;
+  }
+  ctl = SI_CLK_SRC_MS1 | SI_CLK_8MA | ((pll == SI_PLL_B) ? SI_CLK_SRC_PLLB : 0);
+
+  if (freq > SI_MIN_MSRATIO6_FREQ && freq < SI_MAX_MSRATIO6_FREQ) {
+    pllfreq = freq * 6;
+  } else if (freq >= SI_MIN_MSRATIO4_FREQ) {
+    pllfreq = freq * 4;
+  } else if (freq < 8000 && freq > 2800) {
+    pllfreq = SI_MIN_PLL_FREQ;
+  } else if (freq <= 2800) {
+    pllfreq = SI_VERY_MIN_PLL_FREQ;
+  } else {
+    pllfreq = SI_MAX_PLL_FREQ;
+  }
+  if (!Si5351PLLPayload (pllfreq, pllregs)) return 0;
+
+  if (freq >= SI_MIN_MSRATIO4_FREQ) {
+    // Integer divide by 4
+    Si5351MSEncode (4, 0, 1, regs);
+    regs[2] |= 0x3 << 2;
+    ctl |= SI_CLK_MS_INT;
+
+  } else {
+    // Same ranges as validateLowFrequency()
+    if (freq < 50000) {
+      rdiv = SI_R_DIV_128;
+      msfreq = freq * 128;
+    } else if (freq < 200000) {
+      rdiv = SI_R_DIV_16;
+      msfreq = freq * 16;
+    } else if (freq < 1000000) {
+      rdiv = SI_R_DIV_4;
+      msfreq = freq * 4;
+    } else {
+      rdiv = SI_R_DIV_1;
+      msfreq = freq;
+    }
+    if (pllfreq / msfreq < SI5351_MULTISYNTH_A_MIN || pllfreq / msfreq > SI5351_MULTISYNTH_A_MAX) return 0;
+    Si5351MSPayload (pllfreq, msfreq, regs);
+    regs[2] |= rdiv << 4;
+  }
+
+  Si5351StageClock (clk, pll, pllfreq, freq, pllregs, regs, ctl);
+  return 1;
+}
+
+void Si5351Stage (unsigned char reg, unsigned char *regs)
+// Stage the SI_MSREGS registers of the PLL or multisynth at reg.  Registers already on the chip are not sent
+{
+  unsigned char i, pos, block;
+
+  pos = reg - SI_SHADOW_FIRST;
+  block = 1 << (pos / SI_MSREGS);
+  for (i=0; i<SI_MSREGS; i++, pos++) {
+    if ((si5351shadowvalid & block) && si5351shadow[pos] == regs[i]) continue;
+    si5351shadow[pos] = regs[i];
+    if (pos < si5351stagefirst) si5351stagefirst = pos;
+    if (pos > si5351stagelast) si5351stagelast = pos;
+    si5351staged |= block;
+  }
+  si5351shadowvalid |= block;
+}
+
+static volatile unsigned char *Si5351ClkCtl (unsigned char clk)
+// Last value written to the clock control register of clk
+{
+  return (clk == SI_CLK0) ? &clkreg0 : ((clk == SI_CLK1) ? &clkreg1 : &clkreg2);
+}
+
+static unsigned char Si5351SendStaged (void)
+// Send the staged registers in one burst.  Unchanged registers between them are sent again from the shadow
+// unless they are not known.  Returns the blocks that changed
+{
+  unsigned char i, start, err, staged, failed = 0;
+
+  staged = si5351staged;
+  if (!staged) return 0;
+
+  start = si5351stagefirst;
+  for (i=si5351stagefirst; i<=si5351stagelast + 1; i++) {
+    if (i <= si5351stagelast && (si5351shadowvalid & (1 << (i / SI_MSREGS)))) continue;
+    if (i > start) {
+      err = i2cSendRepeatedRegister (SI_SHADOW_FIRST + start, i - start, &si5351shadow[start]);
+      if (err) {
+        LogEvent (LOG_I2C_WRITE, ((unsigned int)(SI_SHADOW_FIRST + start) << 8) | err);
+        failed = 1;
+      }
+    }
+    start = i + 1;
+  }
+  if (failed) si5351shadowvalid &= ~staged;              // Sent again next time
+
+  si5351staged = 0;
+  si5351stagefirst = SI_SHADOW_LEN;
+  si5351stagelast = 0;
+  return staged;
+}
+
+void Si5351Commit (void)
+// Send the staged clocks without stopping the outputs, for example while tuning.  A PLL whose registers
+// changed is reset once.  Clocks that were not running or need a new clock control are set up and turned on.
+// Phase registers for new dividers are sent before the reset
+{
+  unsigned char clk, staged, setup = 0;
+
+  staged = Si5351SendStaged ();
+  for (clk=0; clk<MAXCLK; clk++) {
+    if (si5351stageclks & (1 << clk)) Si5351WritePhase (clk, si5351stagephase[clk]);
+  }
+  if ((staged & SI_SHADOW_PLLA) && (staged & SI_SHADOW_PLLB)) {
+    ResetSi5351PLL (SI_PLL_AB);
+  } else if (staged & SI_SHADOW_PLLA) {
+    ResetSi5351PLL (SI_PLL_A);
+  } else if (staged & SI_SHADOW_PLLB) {
+    ResetSi5351PLL (SI_PLL_B);
+  }
+
+  for (clk=0; clk<MAXCLK; clk++) {
+    if (!(si5351stageclks & (1 << clk))) continue;
+    if ((si5351live & (1 << clk)) && *Si5351ClkCtl (clk) == si5351stagectl[clk]) continue;
+    *Si5351ClkCtl (clk) = si5351stagectl[clk];
+    Si5351WriteRegister (SIREG_16_CLK0_CTL + clk, si5351stagectl[clk]);
+    setup |= 1 << clk;
+  }
+
+  // SI_ENABLE_CLKx is 1 << clk
+  if (setup) Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, Si5351ReadRegister (SIREG_3_OUTPUT_ENABLE_CTL) & ~setup);
+  si5351live |= si5351stageclks;
+  si5351stageclks = 0;
+}
+
+void Si5351CommitSync (void)
+// Send the staged clocks so they start together.  Their outputs are turned off, the registers are sent, the
+// PLLs they use are reset once and the outputs are turned back on.  The reset restarts the multisynths so
+// clocks on the same PLL start in phase, or at the offset in their phase registers.  This takes the output
+// enable read, four writes, a fifth if a phase register changed and a read of CLK1 control only if CLK1 is
+// between two staged clocks
+{
+  unsigned char clk, first = MAXCLK, last = 0, pfirst = MAXCLK, plast = 0, oe, reset = 0, ctl[MAXCLK];
+
+  if (!si5351stageclks) return;
+
+  // SI_ENABLE_CLKx is 1 << clk
+  oe = Si5351ReadRegister (SIREG_3_OUTPUT_ENABLE_CTL);
+  Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, oe | si5351stageclks);
+  Si5351SendStaged ();
+
+  for (clk=0; clk<MAXCLK; clk++) {
+    if (!(si5351stageclks & (1 << clk))) continue;
+    ctl[clk] = *Si5351ClkCtl (clk) = si5351stagectl[clk];
+    reset |= (ctl[clk] & SI_CLK_SRC_PLLB) ? SI_PLLB_RESET : SI_PLLA_RESET;
+    if (first == MAXCLK) first = clk;
+    last = clk;
+    if (si5351stagephase[clk] != si5351phasereg[clk]) {
+      si5351phasereg[clk] = si5351stagephase[clk];
+      if (pfirst == MAXCLK) pfirst = clk;
+      plast = clk;
+    }
+  }
+  for (clk=first; clk<last; clk++) {
+    if (!(si5351stageclks & (1 << clk))) ctl[clk] = ReadClkControlRegister (clk);
+  }
+  Si5351RepeatedWriteRegister (SIREG_16_CLK0_CTL + first, last - first + 1, &ctl[first]);
+  if (pfirst < MAXCLK) Si5351RepeatedWriteRegister (SIREG_165_CLK0_PHASE_OFFSET + pfirst, plast - pfirst + 1, &si5351phasereg[pfirst]);
+
+  // The reset bits clear themselves
+  Si5351WriteRegister (SIREG_177_PLL_RESET, reset);
+  Si5351WriteRegister (SIREG_3_OUTPUT_ENABLE_CTL, oe & ~si5351stageclks);
+
+  si5351live |= si5351stageclks;
+  si5351stageclks = 0;
 }
 
 
 void ProgramSi5351PLL (unsigned char pll, unsigned long pllfreq)
 {
+  unsigned char status;
+
   if (!Fxtalcorr) {
     return;
   }
+  PROFILE_START(t);
 
-  accum = (unsigned long long)pllfreq/(unsigned long long)Fxtalcorr;
+  accum = (unsigned long long)pllfreq * 1000 / Fxtalcorr;
   MS_a = (unsigned long)accum;
 
   if (MS_a < SI5351_PLL_MULTISYNTH_A_MIN || MS_a > SI5351_PLL_MULTISYNTH_A_MAX) {
-    Serial.print ("PLL DIV ERR: ");
-    Serial.println (MS_a);
+    LogEvent (LOG_PLL_DIV, MS_a);
+    PROFILE_END(PROFILE_PLL, t);
     return;
   }
   
-  accum = (unsigned long long)pllfreq % (unsigned long long)Fxtalcorr;
+  accum = (unsigned long long)pllfreq * 1000 % Fxtalcorr;
   accum *= (unsigned long long)SI_MAX_DIVIDER;
-  accum /= (unsigned long long)Fxtalcorr;
+  accum /= Fxtalcorr;
   MS_b = (unsigned long)accum;
   MS_c = SI_MAX_DIVIDER;  
   
 #ifdef DEBUG_PRINT
   unsigned long Fvco;
-  accum = (unsigned long long)Fxtalcorr*(unsigned long long)MS_a+((unsigned long long)Fxtalcorr*(unsigned long long)MS_b)/(unsigned long long)MS_c;
-  Fvco = (unsigned long) accum;
+  accum = Fxtalcorr*(unsigned long long)MS_a+(Fxtalcorr*(unsigned long long)MS_b)/(unsigned long long)MS_c;
+  Fvco = (unsigned long) (accum / 1000);
   Serial.println ("\r\nProgramSi5351PLL ====================================");
   Serial.print (" Pll: ");
   Serial.print ((char)pll);
   Serial.print (" PLL Freq: ");
   Serial.print (pllfreq);
   Serial.print (" Fxtalcorr: ");
-  Serial.println (Fxtalcorr);
+  Serial.println ((unsigned long)(Fxtalcorr / 1000));
   Serial.print ("Actual Divider: ");
-  fraction = (double)pllfreq / (double)Fxtalcorr;
+  fraction = (double)pllfreq * 1000.0 / (double)Fxtalcorr;
   Serial.print ( fraction, 15 );
   Serial.print (" Calculated Divider: ");
   Serial.println ( ((double)MS_a+(double)MS_b/(double)MS_c), 15);
@@ -491,48 +799,69 @@ void ProgramSi5351PLL (unsigned char pll, unsigned long pllfreq)
   // Write the data to the Si5351
   Si5351RepeatedWriteRegister(base, 8, Si5351RegBuffer);
 
-  if (CheckSi5351Status() & SI_PLLA_LOCK_LOSS) {
-    Serial.println ("PLL LOCK ERROR");
+  status = CheckSi5351Status();
+  if (status & SI_PLLA_LOCK_LOSS) {
+    LogEvent (LOG_PLL_LOCK, status);
   }
 
-
+  PROFILE_END(PROFILE_PLL, t);
 }
 
 
 
 void SetIQFrequency (unsigned char clk, unsigned char clk2, unsigned char pll, unsigned long freq)
+// clk2 lags clk by 90 degrees.  Both divide the PLL by the same even integer mult and the phase register
+// delays clk2 by mult quarter PLL periods.  With integer dividers a new PLL fraction moves both clocks
+// together and keeps them in quadrature, so while freq * mult is in the PLL range only the PLL registers are
+// sent and nothing is reset.  The multisynths, phases and one PLL reset are sent only when mult changes
 {
+  unsigned char pllregs[SI_MSREGS], regs[SI_MSREGS], ctl;
   unsigned long pllfreq;
-  
+
+  if (iqmult && clk == iqclk && clk2 == iqclk2 && pll == iqpll && (si5351live & (1 << clk)) && (si5351live & (1 << clk2)) &&
+      freq <= SI_MAX_PLL_FREQ / iqmult && freq * iqmult >= SI_VERY_MIN_PLL_FREQ) {
+    pllfreq = freq * iqmult;
+    if (Si5351PLLPayload (pllfreq, pllregs)) {
+      Si5351Stage ((pll == SI_PLL_B) ? SIREG_34_MSNB_1 : SIREG_26_MSNA_1, pllregs);
+      Si5351SendStaged ();
+      si5351clkfreq[clk] = si5351clkfreq[clk2] = freq;
+      si5351clkpllfreq[clk] = si5351clkpllfreq[clk2] = pllfreq;
+      return;
+    }
+  }
+
   mult = GetPLLFreq(freq);
   if (!mult) {
-    Serial.print ("Phase Err: ");
-    Serial.println (mult);
+    LogEvent (LOG_PHASE, freq);
     return;
   }
   pllfreq = freq * mult;
-
-  R_DIV = 0;
-  MS_DIVBY4 = 0;
+  if (!Si5351PLLPayload (pllfreq, pllregs)) return;
 
 #ifdef DEBUG_PRINT
   Serial.print ("Clk1: ");
   Serial.print (clk);
   Serial.print (" Clk2: ");
-  Serial.print (clk);
+  Serial.print (clk2);
   Serial.print (" PLL Freq: ");
   Serial.print (pllfreq);
   Serial.print (" Mult: ");
   Serial.println (mult);
 #endif
-  
-  ProgramSi5351PLL(pll, pllfreq);
-  
-  ProgramSi5351MSN (clk, pll, pllfreq, freq);  
-  ProgramSi5351MSN (clk2, pll, pllfreq, freq);  
-  
-  UpdatePhaseRegister (SI_CLK2, mult);
-  
+
+  // Integer mode. mult is even and at least 6 for I/Q frequencies
+  Si5351MSEncode (mult, 0, 1, regs);
+  ctl = SI_CLK_SRC_MS1 | SI_CLK_8MA | SI_CLK_MS_INT | ((pll == SI_PLL_B) ? SI_CLK_SRC_PLLB : 0);
+  si5351phase[clk] = 0;
+  si5351phase[clk2] = SI_MAX_PHASE / 4;
+  Si5351StageClock (clk, pll, pllfreq, freq, pllregs, regs, ctl);
+  Si5351StageClock (clk2, pll, pllfreq, freq, pllregs, regs, ctl);
+  Si5351CommitSync ();
+
+  iqmult = mult;
+  iqclk = clk;
+  iqclk2 = clk2;
+  iqpll = pll;
 }
 
 
@@ -681,18 +1010,18 @@ unsigned long validateLowFrequency (unsigned long freq)
 }
 
 unsigned int GetPLLFreq(unsigned long freq) {
- 
-    unsigned long pfreq;
-    unsigned int i;
 
-    // Min divider for MS is 4 and max phase value is 128
-    for (i = 4; i <= 128; i+=2) {
-        pfreq = freq * (unsigned long)i;
-        if (pfreq >= SI_VERY_MIN_PLL_FREQ && pfreq <= SI_MAX_PLL_FREQ) {
-          return i;
-        }
-    } 
-    return 0;
+    unsigned long i;
+
+    // Smallest even multiplier from 4 that puts the PLL in range. Min divider for MS is 4. The 90 degree
+    // offset is the multiplier in 1/4 PLL periods and the phase register holds up to 127, so the largest
+    // even multiplier is 126
+    if (!freq || freq > SI_MAX_PLL_FREQ / 4) return 0;
+    i = (SI_VERY_MIN_PLL_FREQ + freq - 1) / freq;
+    i += i & 1;
+    if (i < 4) i = 4;
+    if (i > (SI_MAX_PHASE_OFFSET & ~1UL) || freq * i > SI_MAX_PLL_FREQ) return 0;
+    return i;
 }
 
 
@@ -767,15 +1096,80 @@ void UpdatePhaseRegister (unsigned char clk, unsigned char phase)
   } 
 
   Si5351WriteRegister (reg, phase);
+  if (clk < MAXCLK) si5351phasereg[clk] = phase;
   ResetSi5351PLL (SI_PLL_AB);              // Need to reset both PLLs for Phase to work!!
-  
+
+}
+
+unsigned long Si5351PhaseSteps (unsigned long pllfreq, unsigned long freq, unsigned int phase)
+// Quarter PLL periods for phase degrees of an output at freq from a PLL at pllfreq.  One step is
+// 90 * freq / pllfreq degrees.  Phases from 180 are the invert bit and the rest
+{
+  if (!freq) return 0;
+  return (unsigned long)(((unsigned long long)(phase % (SI_MAX_PHASE / 2)) * pllfreq + 45ULL * freq) / (90ULL * freq));
+}
+
+unsigned char Si5351PhaseOffset (unsigned long pllfreq, unsigned long freq, unsigned int phase)
+// Phase register for phase degrees.  Limited to SI_MAX_PHASE_OFFSET when the frequency changes after the
+// phase was set
+{
+  unsigned long x;
+
+  x = Si5351PhaseSteps (pllfreq, freq, phase);
+  return (x > SI_MAX_PHASE_OFFSET) ? SI_MAX_PHASE_OFFSET : (unsigned char)x;
+}
+
+void UpdatePhase (unsigned char clk, unsigned long pllfreq, unsigned long freq, unsigned int phase)
+// Set clk to phase degrees for an output at freq from a PLL at pllfreq and reset its PLL once to apply it.
+// The other clocks on the PLL restart at their own phases.  The invert bit is only set on running clocks
+{
+  volatile unsigned char *ctl;
+  unsigned char reg;
+
+  if (clk >= MAXCLK) return;
+  phase %= SI_MAX_PHASE;
+  si5351phase[clk] = phase;
+  Si5351WritePhase (clk, Si5351PhaseOffset (pllfreq, freq, phase));
+
+  ctl = Si5351ClkCtl (clk);
+  if (si5351live & (1 << clk)) {
+    reg = (phase >= SI_MAX_PHASE / 2) ? (*ctl | SI_CLK_INVERT) : (*ctl & ~SI_CLK_INVERT);
+    if (reg != *ctl) {
+      *ctl = reg;
+      Si5351WriteRegister (SIREG_16_CLK0_CTL + clk, reg);
+    }
+  }
+  ResetSi5351PLL ((*ctl & SI_CLK_SRC_PLLB) ? SI_PLL_B : SI_PLL_A);
+}
+
+unsigned char SetPhase (unsigned char clk, unsigned int phase)
+// Set clk to phase degrees at the frequency it was last set to.  Returns 0 if phase is not valid, clk is off
+// or the phase is more than the phase register can delay clk by (127 quarter PLL periods)
+{
+  if (clk >= MAXCLK || phase >= SI_MAX_PHASE || !(si5351live & (1 << clk)) || !si5351clkfreq[clk]) return 0;
+  if (Si5351PhaseSteps (si5351clkpllfreq[clk], si5351clkfreq[clk], phase) > SI_MAX_PHASE_OFFSET) return 0;
+  UpdatePhase (clk, si5351clkpllfreq[clk], si5351clkfreq[clk], phase);
+  return 1;
 }
 
 
 
 void Si5351RepeatedWriteRegister(unsigned char  addr, unsigned char  bytes, unsigned char *data)
 {
+  unsigned char i, pos;
+
   i2cSendRepeatedRegister(addr, bytes, data);
+
+  // Keep the shadow of the PLL and multisynth registers up to date
+  pos = addr - SI_SHADOW_FIRST;
+  for (i=0; i<bytes; i++, pos++) {
+    if (pos < SI_SHADOW_LEN) si5351shadow[pos] = data[i];
+  }
+  pos = addr - SI_SHADOW_FIRST;
+  if (pos < SI_SHADOW_LEN && !(pos % SI_MSREGS) && bytes >= SI_MSREGS) si5351shadowvalid |= 1 << (pos / SI_MSREGS);
+
+  // The I/Q clocks may no longer divide the PLL by iqmult
+  if (pos < SI_SHADOW_LEN) iqmult = 0;
 }
 
 
@@ -786,8 +1180,7 @@ void Si5351WriteRegister (unsigned char reg, unsigned char value)
  
   err = i2cSendRegister(reg, value);
   if (err) {
-    Serial.print ("I2C W Err ");
-    Serial.println (err);
+    LogEvent (LOG_I2C_WRITE, ((unsigned int)reg << 8) | err);
   }
 }
 
@@ -798,8 +1191,7 @@ unsigned char Si5351ReadRegister (unsigned char reg)
 
   err=i2cReadRegister(reg, &value);  
   if (err) {
-    Serial.print ("I2C R Err ");
-    Serial.println (err);
+    LogEvent (LOG_I2C_READ, ((unsigned int)reg << 8) | err);
     value = 0;
   }
 
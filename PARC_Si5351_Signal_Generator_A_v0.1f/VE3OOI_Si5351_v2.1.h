@@ -8,7 +8,8 @@
 #define SI5351_ADDRESS (0x60) 
 #define I2C_READBIT (0x01)
 
-void setupSi5351 (int correction);
+void setupSi5351 (long correction);
+void SetSi5351Correction (long correction);
 void ResetSi5351(void); 
 void ResetSi5351PLL (unsigned char pll);
 void DisableSi5351Clock (unsigned char clk);
@@ -18,6 +19,15 @@ void EnableSi5351Clock (unsigned char clk);
 void SetFrequency (unsigned char clk, unsigned char pll, unsigned long freq);
 void ProgramSi5351PLL (unsigned char pll, unsigned long pllfreq);
 void ProgramSi5351MSN (unsigned char clk, unsigned char pll, unsigned long pllfreq, unsigned long freq);
+void Si5351MSPayload (unsigned long pllfreq, unsigned long freq, unsigned char *regs);
+void Si5351MSEncode (unsigned long a, unsigned long b, unsigned long c, unsigned char *regs);
+unsigned char Si5351PLLPayload (unsigned long pllfreq, unsigned char *regs);
+
+// Register shadow.  Several clocks are staged and then sent together
+unsigned char Si5351StageFrequency (unsigned char clk, unsigned char pll, unsigned long freq);
+void Si5351Stage (unsigned char reg, unsigned char *regs);
+void Si5351Commit (void);
+void Si5351CommitSync (void);
 
 void SetManualFrequency (unsigned char clk, unsigned char pll, unsigned long pllfreq, unsigned long freq);
 void SetIQFrequency (unsigned char clk, unsigned char clk2, unsigned char pll, unsigned long freq);
@@ -28,8 +38,11 @@ void InvertClk (unsigned char clk, unsigned char invert);
 void UpdateClkControlRegister (unsigned char clk);
 unsigned char ReadClkControlRegister (unsigned char clk);
 
-//Phase control
+//Phase control. Phases are in degrees, 180 and over use the clock invert bit
+unsigned long Si5351PhaseSteps (unsigned long pllfreq, unsigned long freq, unsigned int phase);
+unsigned char Si5351PhaseOffset (unsigned long pllfreq, unsigned long freq, unsigned int phase);
 void UpdatePhase (unsigned char clk, unsigned long pllfreq, unsigned long freq, unsigned int phase);
+unsigned char SetPhase (unsigned char clk, unsigned int phase);
 void UpdatePhaseRegister (unsigned char clk, unsigned char phase);
 
 void Si5351WriteRegister (unsigned char reg, unsigned char value);
@@ -50,6 +63,10 @@ unsigned char CheckSi5351Status (void);
 #define SIREG_18_CLK2_CTL          18
 
 #define SI_MSREGS                  8
+#define SI_SHADOW_FIRST            SIREG_26_MSNA_1  // PLL and multisynth registers kept in RAM
+#define SI_SHADOW_LEN              (5 * SI_MSREGS)  // Registers 26 to 65
+#define SI_SHADOW_PLLA             0x1              // Blocks of SI_MSREGS in the shadow
+#define SI_SHADOW_PLLB             0x2
 #define SIREG_26_MSNA_1            26             // Base register address for PLL A
 #define SIREG_27_MSNA_2            27
 #define SIREG_28_MSNA_3            28
@@ -179,6 +196,9 @@ unsigned char CheckSi5351Status (void);
 
 #define SI_CLK_INVERT   B00010000
 
+#define SI_MAX_PHASE_OFFSET     127       // 7 bit phase register in 1/4 PLL periods
+#define SI_MAX_PHASE            360       // Degrees
+
 #define SI_CLK_CLR_DRIVE        B11111100
   
 #define SI_PLLA_RESET   B10000000
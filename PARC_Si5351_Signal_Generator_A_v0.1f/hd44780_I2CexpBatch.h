@@ -0,0 +1,127 @@
+#ifndef _HD44780_I2CEXPBATCH_H_
+#define _HD44780_I2CEXPBATCH_H_
+
+// hd44780_I2CexpBatch - hd44780_I2Cexp with batched character writes
+//
+// The stock hd44780_I2Cexp class sends every character as its own I2C transaction (START, address,
+// 4 expander bytes for the two nibbles with E high/low, STOP).  writeRun() packs the nibble and
+// strobe bytes of a whole run of characters into one transaction, as many as fit in the Wire buffer
+// (8 characters with a PCF8574, 7 with a MCP23008 which needs the GPIO register byte first).
+//
+// The LCD needs 37us to execute a character.  Even at 400kHz the expander byte that lowers E for the
+// next character comes 2 bytes (45us) after the previous strobe so no extra delay is needed.
+//
+// The pin masks are private in hd44780_I2Cexp so they are read with getProp() after begin().
+// The backlight state is also private so it is tracked here by the backlight functions.
+
+#include <Wire.h>
+#include <hd44780.h>
+#include <hd44780ioClass/hd44780_I2Cexp.h>
+
+#define I2CEXP_BATCH_BYTES_PER_CHAR 4       // d4-d7 with E high, E low for each nibble
+
+class hd44780_I2CexpBatch : public hd44780_I2Cexp
+{
+public:
+
+hd44780_I2CexpBatch() : hd44780_I2Cexp() { _baddr = 0; _blOn = 1; }
+hd44780_I2CexpBatch(uint8_t addr) : hd44780_I2Cexp(addr) { _baddr = 0; _blOn = 1; }
+
+// backlight functions - same as hd44780 but remember the state for writeRun()
+int backlight(void) { _blOn = 1; return(hd44780::backlight()); }
+int noBacklight(void) { _blOn = 0; return(hd44780::noBacklight()); }
+int setBacklight(uint8_t dimvalue) { _blOn = dimvalue ? 1 : 0; return(hd44780::setBacklight(dimvalue)); }
+int on(void) { _blOn = 1; return(hd44780::on()); }
+int off(void) { _blOn = 0; return(hd44780::off()); }
+
+// writeRun() - write len data characters starting at the current LCD address.
+// Returns the number of characters written
+size_t writeRun(const uint8_t *buf, uint8_t len)
+{
+uint8_t i, n, max, gpioValue;
+size_t sent = 0;
+
+	if(!_baddr && !loadProps())
+		return(0);
+
+	// MCP23008 needs room for the GPIO register byte
+	max = (BUFFER_LENGTH - _bmcp) / I2CEXP_BATCH_BYTES_PER_CHAR;
+	gpioValue = _brs;
+	if((_blOn && _bblLevel == HIGH) || (!_blOn && _bblLevel == LOW))
+		gpioValue |= _bbl;
+
+	// previous command (e.g. setCursor or clear) must be finished before the first strobe
+	waitReady(-45);
+
+	while(len)
+	{
+		n = (len > max) ? max : len;
+
+		Wire.beginTransmission(_baddr);
+		if(_bmcp)
+			Wire.write(9); // point to GPIO
+		for(i = 0; i < n; i++)
+		{
+			writeNibble(gpioValue, buf[i] >> 4);
+			writeNibble(gpioValue, buf[i] & 0x0F);
+		}
+		if(Wire.endTransmission())
+			return(sent);
+
+		buf += n;
+		len -= n;
+		sent += n;
+	}
+	return(sent);
+}
+
+private:
+
+uint8_t _baddr;			// I2C address, 0 until loadProps()
+uint8_t _bmcp;			// MCP23008 expander
+uint8_t _brs, _ben, _bd4, _bd5, _bd6, _bd7, _bbl, _bblLevel;
+uint8_t _blOn;			// backlight on (the hd44780_I2Cexp default)
+
+// loadProps() - read the expander address and pin masks. Only valid after begin()
+uint8_t loadProps()
+{
+int bl;
+
+	if(getProp(Prop_addr) <= 0 || getProp(Prop_expType) == I2Cexp_UNKNOWN)
+		return(0);
+
+	_bmcp = (getProp(Prop_expType) == I2Cexp_MCP23008);
+	_brs = 1 << getProp(Prop_rs);
+	_ben = 1 << getProp(Prop_en);
+	_bd4 = 1 << getProp(Prop_d4);
+	_bd5 = 1 << getProp(Prop_d5);
+	_bd6 = 1 << getProp(Prop_d6);
+	_bd7 = 1 << getProp(Prop_d7);
+
+	bl = getProp(Prop_bl);
+	_bbl = (bl >= 0) ? (1 << bl) : 0;
+	_bblLevel = getProp(Prop_blLevel);
+
+	_baddr = getProp(Prop_addr);
+	return(1);
+}
+
+// writeNibble() - queue one data nibble with E high then E low. gpioValue has RS and backlight set
+void writeNibble(uint8_t gpioValue, uint8_t value)
+{
+	if(value & (1 << 0))
+		gpioValue |= _bd4;
+	if(value & (1 << 1))
+		gpioValue |= _bd5;
+	if(value & (1 << 2))
+		gpioValue |= _bd6;
+	if(value & (1 << 3))
+		gpioValue |= _bd7;
+
+	Wire.write(gpioValue | _ben);	// with E HIGH
+	Wire.write(gpioValue);		// with E LOW
+}
+
+};
+
+#endif // _HD44780_I2CEXPBATCH_H_
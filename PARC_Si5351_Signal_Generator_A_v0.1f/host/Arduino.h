@@ -0,0 +1,149 @@
+/*
+
+  Host build of the sketch. Just enough of the Arduino core for the modules that do not program the
+  AVR peripherals.  ARDUINO is not defined so modules use their host paths.
+
+ */
+
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "binary.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define LED_BUILTIN 13
+#define A0 14
+
+#define DEC 10
+#define HEX 16
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+
+#define F_CPU 16000000UL
+
+// Flash is ordinary memory
+#define PROGMEM
+#define PSTR(s) (s)
+static inline uint8_t pgm_read_byte (const void *a) { return *(const uint8_t *)a; }
+static inline uint16_t pgm_read_word (const void *a) { uint16_t v; memcpy (&v, a, 2); return v; }
+static inline uint32_t pgm_read_dword (const void *a) { uint32_t v; memcpy (&v, a, 4); return v; }
+#define memcpy_P memcpy
+#define strlen_P strlen
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper *)(s))
+
+// Interrupts are never taken on the host
+#define ISR(v) extern "C" void v (void)
+static inline void cli (void) {}
+static inline void sei (void) {}
+
+// Peripheral registers are plain memory
+#define HOST_REG8(n)  extern volatile uint8_t n;
+#define HOST_REG16(n) extern volatile uint16_t n;
+HOST_REG8(SREG)
+HOST_REG8(TCCR1A) HOST_REG8(TCCR1B) HOST_REG16(TCNT1) HOST_REG16(OCR1A) HOST_REG16(OCR1B) HOST_REG8(TIFR1) HOST_REG8(TIMSK1)
+HOST_REG8(TCCR2A) HOST_REG8(TCCR2B) HOST_REG8(TCNT2) HOST_REG8(OCR2A) HOST_REG8(TIFR2) HOST_REG8(TIMSK2)
+HOST_REG8(ADMUX) HOST_REG8(ADCSRA) HOST_REG16(ADC) HOST_REG8(DIDR0)
+HOST_REG8(PIND) HOST_REG8(PINB)
+
+#define _BV(b) (1 << (b))
+#define TOV1 0
+#define OCF1A 1
+#define OCF1B 2
+#define OCIE1A 1
+#define OCIE1B 2
+#define TOIE1 0
+#define ICF1 5
+#define WGM12 3
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define OCF2A 1
+#define OCF2B 2
+#define OCIE2A 1
+#define WGM21 1
+#define CS22 2
+#define REFS0 6
+#define ADEN 7
+#define ADSC 6
+#define ADPS1 1
+#define ADPS2 2
+
+// The clock is the host monotonic clock
+unsigned long millis (void);
+unsigned long micros (void);
+void delay (unsigned long ms);
+void delayMicroseconds (unsigned int us);
+
+int digitalRead (uint8_t pin);
+void digitalWrite (uint8_t pin, uint8_t val);
+void pinMode (uint8_t pin, uint8_t mode);
+int analogRead (uint8_t pin);
+void attachInterrupt (uint8_t irq, void (*isr)(void), int mode);
+void detachInterrupt (uint8_t irq);
+
+static inline bool isPrintable (int c) { return isprint (c); }
+
+class Print
+{
+public:
+  virtual size_t write (uint8_t c) = 0;
+  size_t write (const uint8_t *buf, size_t len);
+  size_t write (const char *str) { return write ((const uint8_t *)str, strlen (str)); }
+  virtual int availableForWrite (void) { return 64; }
+  virtual void flush (void) {}
+
+  size_t print (const __FlashStringHelper *str) { return print ((const char *)str); }
+  size_t print (const char *str) { return write (str); }
+  size_t print (char c) { return write ((uint8_t)c); }
+  size_t print (unsigned char n, int base = DEC) { return print ((unsigned long)n, base); }
+  size_t print (int n, int base = DEC) { return print ((long)n, base); }
+  size_t print (unsigned int n, int base = DEC) { return print ((unsigned long)n, base); }
+  size_t print (long n, int base = DEC);
+  size_t print (unsigned long n, int base = DEC);
+  size_t print (double n, int digits = 2);
+
+  template <class T> size_t println (T v) { size_t n = print (v); return n + println (); }
+  template <class T> size_t println (T v, int base) { size_t n = print (v, base); return n + println (); }
+  size_t println (void) { return write ("\r\n"); }
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available (void) = 0;
+  virtual int read (void) = 0;
+};
+
+// Serial output goes to stdout.  There is no input
+class HardwareSerial : public Stream
+{
+public:
+  void begin (unsigned long baud) {}
+  int available (void) { return 0; }
+  int read (void) { return -1; }
+  size_t write (uint8_t c) { return fputc (c, stdout) != EOF; }
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif // _HOST_ARDUINO_H_
@@ -0,0 +1,30 @@
+/*
+
+  Host build. EEPROM is kept in memory and starts erased
+
+ */
+
+#ifndef _HOST_EEPROM_H_
+#define _HOST_EEPROM_H_
+
+#include <Arduino.h>
+
+#define HOST_EEPROM_SIZE 1024
+
+class EEPROMClass
+{
+public:
+  EEPROMClass () { memset (mem, 0xFF, sizeof(mem)); }
+  uint8_t read (int addr) { return mem[addr]; }
+  void write (int addr, uint8_t val) { mem[addr] = val; }
+  void update (int addr, uint8_t val) { mem[addr] = val; }
+  template <class T> T &get (int addr, T &t) { memcpy (&t, &mem[addr], sizeof(T)); return t; }
+  template <class T> const T &put (int addr, const T &t) { memcpy (&mem[addr], &t, sizeof(T)); return t; }
+
+private:
+  uint8_t mem[HOST_EEPROM_SIZE];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // _HOST_EEPROM_H_
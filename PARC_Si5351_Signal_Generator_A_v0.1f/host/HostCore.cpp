@@ -0,0 +1,102 @@
+/*
+
+  Host build. Arduino core functions, peripheral registers, Serial, Wire and EEPROM.
+
+ */
+
+#include "Arduino.h"
+
+#include <time.h>
+
+#include "Wire.h"
+#include "EEPROM.h"
+
+volatile uint8_t SREG;
+volatile uint8_t TCCR1A, TCCR1B, TIFR1, TIMSK1;
+volatile uint16_t TCNT1, OCR1A, OCR1B;
+volatile uint8_t TCCR2A, TCCR2B, TCNT2, OCR2A, TIFR2, TIMSK2;
+volatile uint8_t ADMUX, ADCSRA, DIDR0;
+volatile uint16_t ADC;
+volatile uint8_t PIND = 0xFF, PINB = 0xFF;   // Buttons are pulled up
+
+HardwareSerial Serial;
+TwoWire Wire;
+EEPROMClass EEPROM;
+
+
+static unsigned long long HostNow (void)
+// Microseconds of the host monotonic clock
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static unsigned long long hoststart = HostNow ();
+
+unsigned long micros (void)
+{
+  return (unsigned long)(HostNow () - hoststart);
+}
+
+unsigned long millis (void)
+{
+  return (unsigned long)((HostNow () - hoststart) / 1000);
+}
+
+void delayMicroseconds (unsigned int us)
+{
+  unsigned long start = micros ();
+
+  while (micros () - start < us);
+}
+
+void delay (unsigned long ms)
+{
+  unsigned long start = millis ();
+
+  while (millis () - start < ms);
+}
+
+int digitalRead (uint8_t pin) { return HIGH; }
+void digitalWrite (uint8_t pin, uint8_t val) {}
+void pinMode (uint8_t pin, uint8_t mode) {}
+int analogRead (uint8_t pin) { return 0; }
+void attachInterrupt (uint8_t irq, void (*isr)(void), int mode) {}
+void detachInterrupt (uint8_t irq) {}
+
+
+size_t Print::write (const uint8_t *buf, size_t len)
+{
+  size_t n = 0;
+
+  while (len--) n += write (*buf++);
+  return n;
+}
+
+size_t Print::print (unsigned long n, int base)
+{
+  char buf[8 * sizeof(long) + 1], *p = &buf[sizeof(buf) - 1];
+
+  *p = 0;
+  do {
+    *--p = "0123456789ABCDEF"[n % base];
+    n /= base;
+  } while (n);
+  return write (p);
+}
+
+size_t Print::print (long n, int base)
+{
+  if (n < 0 && base == DEC) return print ('-') + print ((unsigned long)-n, base);
+  return print ((unsigned long)n, base);
+}
+
+size_t Print::print (double n, int digits)
+{
+  char buf[32];
+
+  snprintf (buf, sizeof(buf), "%.*f", digits, n);
+  return write (buf);
+}
@@ -0,0 +1,42 @@
+/*
+
+  Host build. Replaces i2c.cpp.  The Si5351 is a register file and the bytes that would be put on the
+  bus are counted.
+
+ */
+
+#include "Arduino.h"
+
+#include "i2c.h"
+
+volatile unsigned char i2cbusy;
+
+unsigned char hostsi5351[256];          // Si5351 registers. Register 0 reads as ready
+unsigned long hosti2cbytes;             // Bytes put on the bus, including the address bytes
+
+
+void i2cInit (void)
+{
+}
+
+uint8_t i2cSendRegister (uint8_t reg, uint8_t data)
+{
+  hostsi5351[reg] = data;
+  if (reg == 177) hostsi5351[reg] = 0;  // PLL reset bits clear themselves
+  hosti2cbytes += 3;
+  return 0;
+}
+
+uint8_t i2cReadRegister (uint8_t reg, uint8_t *data)
+{
+  *data = hostsi5351[reg];
+  hosti2cbytes += 4;
+  return 0;
+}
+
+uint8_t i2cSendRepeatedRegister (uint8_t reg, uint8_t bytes, uint8_t *data)
+{
+  memcpy (&hostsi5351[reg], data, bytes);
+  hosti2cbytes += 2 + bytes;
+  return 0;
+}
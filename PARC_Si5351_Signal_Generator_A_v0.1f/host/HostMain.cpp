@@ -0,0 +1,209 @@
+/*
+
+  Host build. The globals of the sketch that the modules use and a main() that runs one test.
+
+    hostsketch bench      LCD benchmark on every backend. The console backend records on stderr
+    hostsketch oled       OLED page tracking and plot. Each frame sent is written to oledNNNN.pbm
+    hostsketch beacon     Channel symbols of WSPR, FT8 and JT65 messages encoded on the device
+    hostsketch analyzer   Triangle sweep of the simulated tuned circuit as CSV and on the OLED plot
+
+ */
+
+#include "Arduino.h"
+
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
+#include "LCD.h"
+#include "OLED.h"
+#include "VE3OOI_Si5351_v2.1.h"
+#include "Beacon.h"
+#include "Sweep.h"
+#include "Analyzer.h"
+
+#include <Wire.h>
+
+extern unsigned char oleddirty;
+extern unsigned char oledfb[OLED_PAGES][OLED_WIDTH];
+
+volatile unsigned long flags;
+
+volatile unsigned long frequency_clk, PSKCarrierFrequency;
+volatile long offset_frequency;
+volatile unsigned long frequency_inc;
+volatile long offset_inc;
+volatile int calibration_mult;
+
+volatile unsigned char MenuSelection, ClkSelection;
+
+extern const char RootMenuOptions[MAXMENU_ITEMS][MAXMENU_LEN];
+const char RootMenuOptions[MAXMENU_ITEMS][MAXMENU_LEN] PROGMEM = {
+  {"VFO ENABLE"},
+  {"MIX ENABLE"},
+  {"I/Q ENABLE"},
+  {"SET OFFSET"},
+  {"CALIBRATE "},
+  {"SAVE      "},
+  {"RECALL    "},
+  {"CLI ENABLE"},
+  {"RESET     "},
+#ifdef ENABLE_SWEEP
+  {"SWEEP     "},
+#endif // ENABLE_SWEEP
+#ifdef ENABLE_COUNTER
+  {"COUNTER   "},
+#endif // ENABLE_COUNTER
+};
+
+char header1[HEADER1] = {'P', 'A', 'R', 'C', ' ', 'S', 'I', 'G', ' ', 'G', 'E', 'N', ' ', 'A', '0', '.', '1', 'F', ' ', 0x0};
+char header2[HEADER2] = {' ', '(', 'C', ')', 'V', 'E', '3', 'O', 'O', 'I', 0x0};
+
+char clkentry [CLKENTRYLEN];
+
+char clearlcdline[LCD_CLEAR_LINE_LENGTH];
+char clearlcderrmsg[LCD_ERROR_MSG_LENGTH];
+
+char okmsg[LCD_ERROR_MSG_LENGTH];
+
+Sig_Gen_Struct sg;
+
+
+static void HostSetup (void)
+// The parts of setup() the modules depend on
+{
+  memset (clearlcdline, 0x20, sizeof(clearlcdline));
+  clearlcdline[LCD_CLEAR_LINE_LENGTH-1] = 0;
+  memset (clearlcderrmsg, 0x20, sizeof (clearlcderrmsg));
+  clearlcderrmsg[LCD_ERROR_MSG_LENGTH-1] = 0;
+  memset (okmsg, 0x20, sizeof (okmsg));
+  okmsg[LCD_ERROR_MSG_LENGTH-1] = 0;
+  okmsg[0] = 'O';
+  okmsg[1] = 'K';
+
+  frequency_clk = DEFAULT_FREQUENCY;
+  frequency_inc = DEFAULT_FREQUENCY_INCREMENT;
+  offset_inc = DEFAULT_FREQUENCY_INCREMENT;
+  calibration_mult = DEFAULT_CALIBRATION_INCREMENT;
+
+  sg.flags = (MEM_ID | VERSION);
+  sg.ClkFreq[0] = sg.ClkFreq[1] = sg.ClkFreq[2] = 1000000;
+  sg.IQClkFreq[0] = sg.IQClkFreq[2] = SI_MIN_IQ_OUT_FREQ;
+  sg.ClkMode[0] = sg.ClkMode[1] = sg.ClkMode[2] = VFO_CLK_MODE;
+
+  SetupLCD ();
+}
+
+static unsigned char HostCheck (const char *what, unsigned long got, unsigned long want)
+{
+  printf ("%-24s %6lu %s\n", what, got, (got == want) ? "ok" : "FAIL");
+  return got != want;
+}
+
+static int HostOLED (void)
+// Only the pages that changed are sent and the plot is drawn bottom up
+{
+  unsigned char x, fail = 0;
+  unsigned int tx;
+
+  // A page is 5 bytes of addressing and 128 data bytes in transactions of up to BUFFER_LENGTH-1
+  tx = (OLED_WIDTH + BUFFER_LENGTH - 2) / (BUFFER_LENGTH - 1);
+
+  OLEDInit ();
+  fail |= HostCheck ("init dirty pages", oleddirty, 0xFF);
+  fail |= HostCheck ("init bytes", OLEDSendPages (1), OLED_PAGES * (5 + OLED_WIDTH + 2 * tx));
+  fail |= HostCheck ("idle bytes", OLEDSendPages (1), 0);
+
+  // Ramp from empty at the left to full at the right
+  for (x=0; x<OLED_WIDTH; x++) OLEDPlot (x, 1, x * 2 + 1);
+  fail |= HostCheck ("plot dirty pages", oleddirty, ((1 << OLED_PLOT_PAGES) - 1) << OLED_PLOT_PAGE);
+  fail |= HostCheck ("plot left column", oledfb[OLED_PLOT_PAGE + 1][0], 0);
+  fail |= HostCheck ("plot middle column", oledfb[OLED_PLOT_PAGE + 1][OLED_WIDTH / 2], 0xFF);
+  fail |= HostCheck ("plot middle top page", oledfb[OLED_PLOT_PAGE][OLED_WIDTH / 2], 0);
+  fail |= HostCheck ("plot right column", oledfb[OLED_PLOT_PAGE][OLED_WIDTH - 1], 0xFE);
+  fail |= HostCheck ("plot bytes", OLEDSendPages (1), OLED_PLOT_PAGES * (5 + OLED_WIDTH + 2 * tx));
+
+  // One transaction per call when not sending everything
+  OLEDDisplayFrequency (7040100);
+  fail |= HostCheck ("frequency dirty pages", oleddirty, 3 << OLED_FREQ_PAGE);
+  fail |= HostCheck ("first transaction bytes", OLEDSendPages (0), 5 + BUFFER_LENGTH + 1);
+  fail |= HostCheck ("rest bytes", OLEDSendPages (1), 2 * (5 + OLED_WIDTH + 2 * tx) - (5 + BUFFER_LENGTH + 1));
+
+  return fail;
+}
+
+static int HostBeacon (void)
+// One message of each kind. The symbols are printed by BeaconReport()
+{
+  char a[][8] = {"VE3OOI", "FN03", "CQ", "K1ABC", "FN42", "W9XYZ", "R-15", "RR73", "RO", "+05"};
+  unsigned char fail = 0;
+
+  fail |= HostCheck ("WSPR VE3OOI FN03 37", BeaconWSPR (a[0], a[1], 37), 1);
+  BeaconReport ();
+  fail |= HostCheck ("FT8 CQ K1ABC FN42", BeaconFT8 (a[2], a[3], a[4]), 1);
+  BeaconReport ();
+  fail |= HostCheck ("FT8 W9XYZ K1ABC R-15", BeaconFT8 (a[5], a[3], a[6]), 1);
+  BeaconReport ();
+  fail |= HostCheck ("FT8 K1ABC W9XYZ RR73", BeaconFT8 (a[3], a[5], a[7]), 1);
+  BeaconReport ();
+  fail |= HostCheck ("JT65 CQ K1ABC FN42", BeaconJT65 (a[2], a[3], a[4]), 1);
+  BeaconReport ();
+  fail |= HostCheck ("JT65 W9XYZ K1ABC R-15", BeaconJT65 (a[5], a[3], a[6]), 1);
+  BeaconReport ();
+  fail |= HostCheck ("JT65 K1ABC W9XYZ RO", BeaconJT65 (a[3], a[5], a[8]), 1);
+  BeaconReport ();
+  fail |= HostCheck ("FT8 RO rejected", BeaconFT8 (a[3], a[5], a[8]), 0);
+  fail |= HostCheck ("JT65 +05 rejected", BeaconJT65 (a[3], a[5], a[9]), 0);
+  fail |= HostCheck ("FT8 CQ as CALL2 rejected", BeaconFT8 (a[3], a[2], NULL), 0);
+  return fail;
+}
+
+static int HostAnalyzer (void)
+// Two passes of a triangle sweep over the simulated resonance at 10MHz. The bar of the middle point is
+// as tall as any in the plot and taller than the bars at the ends
+{
+  extern unsigned long analyzercount;
+  unsigned char x, k, b, h[OLED_WIDTH], top = 0, fail = 0;
+  unsigned int i, points = 33;
+
+  OLEDInit ();
+  fail |= HostCheck ("sweep configured", SweepConfigure (9000000, 11000000, points, 1, SWEEP_TRIANGLE, SWEEP_LINEAR), 1);
+  fail |= HostCheck ("analyzer started", AnalyzerStart (SI_CLK0, 0, 4, ANALYZER_CSV), 1);
+  for (i=0; i<2 * points; i++) AnalyzerPoll ();
+  fail |= HostCheck ("still running", analyzeractive, 1);
+  AnalyzerStop ();
+  fail |= HostCheck ("points measured", analyzercount, 2 * points);
+
+  for (x=0; x<OLED_WIDTH; x++) {
+    for (k=0, h[x]=0; k<OLED_PLOT_PAGES; k++) {
+      for (b=0; b<8; b++) h[x] += (oledfb[OLED_PLOT_PAGE + k][x] >> b) & 1;
+    }
+    if (h[x] > top) top = h[x];
+  }
+  fail |= HostCheck ("middle bar height", h[(points / 2) * OLED_WIDTH / points], top);
+  fail |= HostCheck ("first bar lower", h[0] < top, 1);
+  fail |= HostCheck ("last bar lower", h[OLED_WIDTH - 1] < top, 1);
+  OLEDSendPages (1);
+  return fail;
+}
+
+int main (int argc, char **argv)
+{
+  if (argc < 2) {
+    fprintf (stderr, "Usage: %s bench|oled|beacon|analyzer\n", argv[0]);
+    return 1;
+  }
+
+  HostSetup ();
+
+  if (!strcmp (argv[1], "bench")) {
+    LCDBenchmark ();
+  } else if (!strcmp (argv[1], "oled")) {
+    return HostOLED ();
+  } else if (!strcmp (argv[1], "beacon")) {
+    return HostBeacon ();
+  } else if (!strcmp (argv[1], "analyzer")) {
+    return HostAnalyzer ();
+  } else {
+    fprintf (stderr, "Unknown test %s\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}
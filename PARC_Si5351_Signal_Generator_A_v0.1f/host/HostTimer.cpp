@@ -0,0 +1,38 @@
+/*
+
+  Host build. Replaces Timer.cpp.  Time stamps come from the host clock and Timer2 is only shared,
+  it never ticks.
+
+ */
+
+#include "Arduino.h"
+
+#include "Timer.h"
+
+volatile unsigned char timer2owner;
+
+
+void EnableTimers (unsigned char timer, unsigned int count)
+{
+}
+
+void DisableTimers (unsigned char timer)
+{
+}
+
+unsigned char ClaimTimer2 (unsigned char owner)
+{
+  if (timer2owner != TIMER2_FREE && timer2owner != owner) return 0;
+  timer2owner = owner;
+  return 1;
+}
+
+void ReleaseTimer2 (unsigned char owner)
+{
+  if (timer2owner == owner) timer2owner = TIMER2_FREE;
+}
+
+unsigned long TimerTimestamp (void)
+{
+  return micros () / TIMER_TICK_US;
+}
@@ -0,0 +1,28 @@
+/*
+
+  Host build. Wire transactions are counted and discarded
+
+ */
+
+#ifndef _HOST_WIRE_H_
+#define _HOST_WIRE_H_
+
+#include <Arduino.h>
+
+#define BUFFER_LENGTH 32
+
+class TwoWire : public Print
+{
+public:
+  void begin (void) {}
+  void beginTransmission (uint8_t address) { bytes++; }
+  uint8_t endTransmission (void) { return 0; }
+  size_t write (uint8_t data) { bytes++; return 1; }
+  using Print::write;
+
+  unsigned long bytes;          // Bytes put on the bus, including the address bytes
+};
+
+extern TwoWire Wire;
+
+#endif // _HOST_WIRE_H_
@@ -0,0 +1,2 @@
+// Host build. Everything used is in Arduino.h
+#include <Arduino.h>
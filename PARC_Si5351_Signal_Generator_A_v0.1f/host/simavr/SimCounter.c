@@ -0,0 +1,248 @@
+/*
+
+  simavr test of the frequency counter.  The firmware is built with the CLI and ENABLE_COUNTER and runs on a
+  simulated ATmega328P at 16MHz.  Every I2C address is acknowledged and reads return 0 so the Si5351 looks
+  ready.  The harness turns the encoder to CLI ENABLE, pushes PBUTTON2 and then types G commands while a
+  square wave drives T1 (D5).
+
+    simcounter firmware.elf
+
+  High frequencies are read from the count in the gate, to the 10Hz resolution of a 100ms gate.  Low
+  frequencies are read from the time stamps of the first and last edges (reciprocal counting), which the
+  4us stamps resolve to a few parts per million over a 1s gate
+
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_io.h"
+#include "sim_time.h"
+#include "sim_cycle_timers.h"
+#include "avr_ioport.h"
+#include "avr_uart.h"
+#include "avr_twi.h"
+
+#define SIM_MCU       "atmega328p"
+#define SIM_F_CPU     16000000UL
+#define SIM_BOOT_MS   3000          // Splash and Si5351 set up
+#define SIM_CHAR_MS   2             // Typing is slower than 9600 baud so the UART never overruns
+#define SIM_PRESS_MS  100           // Longer than PBDEBOUNCE
+#define SIM_CLI_ITEM  7             // CLI_ENABLE in the root menu
+#define SIM_REPLY_MS  200           // A counter report at 9600 baud
+
+static avr_t *avr;
+static avr_irq_t *twiin, *uartin, *t1, *enca, *encb, *encpb, *pb2;
+static avr_cycle_count_t t1half;    // CPU cycles between edges of the T1 square wave. 0 holds T1 high
+static unsigned char t1level = 1;
+
+static char rxline[128];            // Serial output since the last end of line
+static unsigned char rxlen, prompted, haveread;
+static unsigned long rxgates;
+static double rxhz;
+
+// Readings checked.  The input is a whole number of CPU cycles per half period so the frequency expected
+// is F_CPU / (2 * half period) and not the one asked for
+static const struct {
+  const char *what;
+  unsigned int gate;                // ms
+  unsigned long hz;
+  double tolerance;                 // Hz
+} simreadings[] = {
+  {"1MHz 100ms gate",   100, 1000000, 10.0},
+  {"100Hz 1s reciprocal", 1000,   100, 0.005},
+  {"12345Hz 1s reciprocal", 1000, 12345, 0.1},
+};
+
+
+static void SimUART (struct avr_irq_t *irq, uint32_t value, void *param)
+// Serial output a line at a time.  The reading is picked out of "Counter: on Gate ms: N Gates: N Hz: H"
+{
+  char *p;
+
+  if (value != '\r' && value != '\n') {
+    if (rxlen < sizeof(rxline) - 1) rxline[rxlen++] = (char)value;
+    rxline[rxlen] = 0;
+    if (strstr (rxline, ":>")) prompted = 1;
+    return;
+  }
+  if (!rxlen) return;
+
+  if ((p = strstr (rxline, "Gates: "))) {
+    rxgates = strtoul (p + 7, NULL, 10);
+    if ((p = strstr (p, "Hz: "))) {
+      rxhz = strtod (p + 4, NULL);
+      haveread = 1;
+    }
+  }
+  printf ("  | %s\n", rxline);
+  rxlen = 0;
+  rxline[0] = 0;
+}
+
+static void SimTWI (struct avr_irq_t *irq, uint32_t value, void *param)
+// Every address and byte is acknowledged and reads return 0.  The Si5351 has finished its set up and
+// its PLLs are out of reset
+{
+  avr_twi_msg_irq_t v;
+
+  v.u.v = value;
+  if (v.u.twi.msg & (TWI_COND_START | TWI_COND_WRITE)) {
+    avr_raise_irq (twiin, avr_twi_irq_msg (TWI_COND_ACK, v.u.twi.addr, 1));
+  }
+  if (v.u.twi.msg & TWI_COND_READ) {
+    avr_raise_irq (twiin, avr_twi_irq_msg (TWI_COND_READ, v.u.twi.addr, 0));
+  }
+}
+
+static avr_cycle_count_t SimT1 (struct avr_t *avr, avr_cycle_count_t when, void *param)
+// Next edge of the T1 input
+{
+  if (!t1half) {
+    if (!t1level) avr_raise_irq (t1, t1level = 1);
+    return when + avr_usec_to_cycles (avr, 1000);
+  }
+  t1level ^= 1;
+  avr_raise_irq (t1, t1level);
+  return when + t1half;
+}
+
+static void SimRun (unsigned long ms)
+{
+  avr_cycle_count_t end;
+  int state;
+
+  end = avr->cycle + avr_usec_to_cycles (avr, ms * 1000UL);
+  while (avr->cycle < end) {
+    state = avr_run (avr);
+    if (state == cpu_Done || state == cpu_Crashed) {
+      fprintf (stderr, "Firmware stopped\n");
+      exit (2);
+    }
+  }
+}
+
+static void SimDetent (void)
+// One clockwise detent.  The encoder counts the move from both low to B high
+{
+  avr_raise_irq (enca, 0);
+  avr_raise_irq (encb, 0);
+  SimRun (5);
+  avr_raise_irq (encb, 1);
+  SimRun (5);
+  avr_raise_irq (enca, 1);
+  SimRun (20);
+}
+
+static void SimSend (const char *cmd)
+// Type a CLI command and Enter
+{
+  for (; *cmd; cmd++) {
+    avr_raise_irq (uartin, (uint8_t)*cmd);
+    SimRun (SIM_CHAR_MS);
+  }
+  avr_raise_irq (uartin, '\r');
+  SimRun (SIM_CHAR_MS);
+}
+
+static unsigned char SimCheck (const char *what, double got, double want, double tolerance)
+{
+  unsigned char fail = fabs (got - want) > tolerance;
+
+  printf ("%-24s %16.3f %16.3f %s\n", what, got, want, fail ? "FAIL" : "ok");
+  return fail;
+}
+
+static unsigned char SimReading (unsigned char i)
+// Start the counter with the gate of a reading, let it run three gates and ask for the last one.  The
+// first gate after a start can be short
+{
+  char cmd[16];
+  double want;
+
+  t1half = SIM_F_CPU / 2 / simreadings[i].hz;
+  want = (double)SIM_F_CPU / 2.0 / (double)t1half;
+
+  snprintf (cmd, sizeof(cmd), "G %u", simreadings[i].gate);
+  SimSend (cmd);
+  SimRun (3UL * simreadings[i].gate + 50);
+
+  haveread = 0;
+  SimSend ("G");
+  SimRun (SIM_REPLY_MS);
+  if (!haveread || rxgates < 2) {
+    printf ("%-24s %16s %16.3f FAIL\n", simreadings[i].what, "no reading", want);
+    return 1;
+  }
+  return SimCheck (simreadings[i].what, rxhz, want, simreadings[i].tolerance);
+}
+
+int main (int argc, char **argv)
+{
+  elf_firmware_t fw;
+  uint32_t uartflags = 0;
+  unsigned char i, fail = 0;
+
+  if (argc != 2) {
+    fprintf (stderr, "Usage: %s firmware.elf\n", argv[0]);
+    return 2;
+  }
+  memset (&fw, 0, sizeof(fw));
+  if (elf_read_firmware (argv[1], &fw)) {
+    fprintf (stderr, "Can't read %s\n", argv[1]);
+    return 2;
+  }
+
+  avr = avr_make_mcu_by_name (SIM_MCU);
+  if (!avr) {
+    fprintf (stderr, "simavr has no %s\n", SIM_MCU);
+    return 2;
+  }
+  avr_init (avr);
+  avr->frequency = SIM_F_CPU;
+  avr_load_firmware (avr, &fw);
+
+  // Serial output is collected here instead of simavr's stdout
+  avr_ioctl (avr, AVR_IOCTL_UART_GET_FLAGS('0'), &uartflags);
+  uartflags &= ~AVR_UART_FLAG_STDIO;
+  avr_ioctl (avr, AVR_IOCTL_UART_SET_FLAGS('0'), &uartflags);
+  avr_irq_register_notify (avr_io_getirq (avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT), SimUART, NULL);
+  uartin = avr_io_getirq (avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+
+  avr_irq_register_notify (avr_io_getirq (avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT), SimTWI, NULL);
+  twiin = avr_io_getirq (avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT);
+
+  // The inputs have no pull ups in the simulator. Everything starts released
+  enca = avr_io_getirq (avr, AVR_IOCTL_IOPORT_GETIRQ('B'), 2);    // ENC_A D10
+  encb = avr_io_getirq (avr, AVR_IOCTL_IOPORT_GETIRQ('B'), 3);    // ENC_B D11
+  encpb = avr_io_getirq (avr, AVR_IOCTL_IOPORT_GETIRQ('B'), 4);   // ENC_PB D12
+  t1 = avr_io_getirq (avr, AVR_IOCTL_IOPORT_GETIRQ('D'), 5);      // PBUTTON1 and T1 D5
+  pb2 = avr_io_getirq (avr, AVR_IOCTL_IOPORT_GETIRQ('D'), 6);     // PBUTTON2 D6
+  avr_raise_irq (enca, 1);
+  avr_raise_irq (encb, 1);
+  avr_raise_irq (encpb, 1);
+  avr_raise_irq (t1, 1);
+  avr_raise_irq (pb2, 1);
+  avr_cycle_timer_register (avr, 1, SimT1, NULL);
+
+  SimRun (SIM_BOOT_MS);
+
+  // Root menu to CLI ENABLE. The buttons are ignored from then on so T1 can run
+  for (i=0; i<SIM_CLI_ITEM; i++) SimDetent ();
+  avr_raise_irq (pb2, 0);
+  SimRun (SIM_PRESS_MS);
+  avr_raise_irq (pb2, 1);
+  SimRun (SIM_PRESS_MS);
+  fail |= SimCheck ("CLI prompt", prompted, 1, 0);
+
+  for (i=0; i<sizeof(simreadings) / sizeof(simreadings[0]); i++) fail |= SimReading (i);
+
+  SimSend ("G 0");
+  SimRun (SIM_REPLY_MS);
+  avr_terminate (avr);
+  return fail;
+}
@@ -9,7 +9,9 @@ Routines adapted from  http://www.embedds.com/programming-avr-i2c-interface/
 
 #include <inttypes.h>
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <avr/pgmspace.h>
+#include "VE3OOI_Si5351_Signal_Generator.h"   // Defines for this program
 #include "i2c.h"
 
 #define I2C_START 0x08
@@ -20,10 +22,20 @@ Routines adapted from  http://www.embedds.com/programming-avr-i2c-interface/
 #define I2C_WRITE 0b11000000
 #define I2C_READ  0b11000001
 
+#ifdef ENABLE_INPUT_TRACE
+// Running count and checksum of every byte sent to the Si5351. Used to compare register traffic
+volatile unsigned long i2cbytes;
+volatile unsigned int i2csum;
+#endif // ENABLE_INPUT_TRACE
+
+// Set from the start to the stop condition of a transaction.  An ISR that sends to the Si5351 must not
+// start while the code it interrupted is in the middle of a transaction
+volatile unsigned char i2cbusy;
 
 
 uint8_t i2cStart(void)
 {
+  i2cbusy = 1;
   TWCR = (1<<TWINT) | (1<<TWSTA) | (1<<TWEN);
 
   while (!(TWCR & (1<<TWINT))) ;
@@ -36,10 +48,21 @@ void i2cStop(void)
   TWCR = (1<<TWINT) | (1<<TWEN) | (1<<TWSTO);
 
   while ((TWCR & (1<<TWSTO))) ;
+  i2cbusy = 0;
 }
 
 uint8_t i2cByteSend(uint8_t data)
 {
+#ifdef ENABLE_INPUT_TRACE
+  uint8_t sreg;
+
+  sreg = SREG;                // Counters are also read from the Timer1 ISR
+  cli();
+  i2cbytes++;
+  i2csum = ((i2csum << 1) | (i2csum >> 15)) ^ data;
+  SREG = sreg;
+#endif // ENABLE_INPUT_TRACE
+
   TWDR = data;
 
   TWCR = (1<<TWINT) | (1<<TWEN);
@@ -63,16 +86,28 @@ uint8_t i2cSendRegister(uint8_t reg, uint8_t data)
   uint8_t stts;
   
   stts = i2cStart();
-  if (stts != I2C_START) return 1;
+  if (stts != I2C_START) {
+    i2cStop();
+    return 1;
+  }
 
   stts = i2cByteSend(I2C_WRITE);
-  if (stts != I2C_SLA_W_ACK) return 2;
+  if (stts != I2C_SLA_W_ACK) {
+    i2cStop();
+    return 2;
+  }
 
   stts = i2cByteSend(reg);
-  if (stts != I2C_DATA_ACK) return 3;
+  if (stts != I2C_DATA_ACK) {
+    i2cStop();
+    return 3;
+  }
 
   stts = i2cByteSend(data);
-  if (stts != I2C_DATA_ACK) return 4;
+  if (stts != I2C_DATA_ACK) {
+    i2cStop();
+    return 4;
+  }
 
   i2cStop();
 
@@ -84,17 +119,29 @@ uint8_t i2cSendRepeatedRegister(uint8_t reg, uint8_t bytes, uint8_t *data)
   uint8_t stts, i;
   
   stts = i2cStart();
-  if (stts != I2C_START) return 1;
+  if (stts != I2C_START) {
+    i2cStop();
+    return 1;
+  }
 
   stts = i2cByteSend(I2C_WRITE);
-  if (stts != I2C_SLA_W_ACK) return 2;
+  if (stts != I2C_SLA_W_ACK) {
+    i2cStop();
+    return 2;
+  }
 
   stts = i2cByteSend(reg);
-  if (stts != I2C_DATA_ACK) return 3;
+  if (stts != I2C_DATA_ACK) {
+    i2cStop();
+    return 3;
+  }
 
   for (i=0; i<bytes; i++) {
     stts = i2cByteSend(data[i]);
-    if (stts != I2C_DATA_ACK) return 4; 
+    if (stts != I2C_DATA_ACK) {
+      i2cStop();
+      return 4;
+    }
   }
 
   i2cStop();
@@ -109,19 +156,34 @@ uint8_t i2cReadRegister(uint8_t reg, uint8_t *data)
   uint8_t stts;
   
   stts = i2cStart();
-  if (stts != I2C_START) return 1;
+  if (stts != I2C_START) {
+    i2cStop();
+    return 1;
+  }
 
   stts = i2cByteSend(I2C_WRITE);
-  if (stts != I2C_SLA_W_ACK) return 2;
+  if (stts != I2C_SLA_W_ACK) {
+    i2cStop();
+    return 2;
+  }
  
   stts = i2cByteSend(reg);
-  if (stts != I2C_DATA_ACK) return 3;
+  if (stts != I2C_DATA_ACK) {
+    i2cStop();
+    return 3;
+  }
 
   stts = i2cStart();
-  if (stts != I2C_START_RPT) return 4;
+  if (stts != I2C_START_RPT) {
+    i2cStop();
+    return 4;
+  }
 
   stts = i2cByteSend(I2C_READ);
-  if (stts != I2C_SLA_R_ACK) return 5;
+  if (stts != I2C_SLA_R_ACK) {
+    i2cStop();
+    return 5;
+  }
 
   *data = i2cByteRead();
 